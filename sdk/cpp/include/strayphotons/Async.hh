@@ -7,10 +7,14 @@
 
 #pragma once
 
+#include "strayphotons/JobSystem.hh"
 #include "strayphotons/Logging.hh"
 
 #include <atomic>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 namespace sp {
     template<typename T>
@@ -30,20 +34,53 @@ namespace sp {
 
         std::shared_ptr<T> Get() const {
             while (!valid.test()) {
-                valid.wait(false);
+                if (!HelpWhileWaiting(producer.load(std::memory_order_relaxed))) valid.wait(false);
             }
             return value;
         }
 
+        // Sets the JobSystem job owner that will resolve this value, so worker threads blocked in Get() can help it
+        void SetProducer(const void *owner) {
+            producer.store(owner, std::memory_order_relaxed);
+        }
+
         void Set(const std::shared_ptr<T> &ptr) {
             value = ptr;
-            Assert(!valid.test_and_set(), "Async::Set called multiple times");
+            std::vector<std::function<void()>> readyCallbacks;
+            {
+                std::lock_guard lock(continuationMutex);
+                Assert(!valid.test_and_set(), "Async::Set called multiple times");
+                readyCallbacks = std::move(continuations);
+            }
             valid.notify_all();
+            for (auto &callback : readyCallbacks) {
+                callback();
+            }
+        }
+
+        /**
+         * Registers a callback to be run once the value is set.
+         * The callback is run on the thread calling Set(), or immediately on this thread if the value is already set.
+         * Callbacks should be short, and should not block on other futures.
+         */
+        void Then(std::function<void()> &&callback) {
+            {
+                std::lock_guard lock(continuationMutex);
+                if (!valid.test()) {
+                    continuations.emplace_back(std::move(callback));
+                    return;
+                }
+            }
+            callback();
         }
 
     private:
         std::atomic_flag valid;
         std::shared_ptr<T> value;
+        std::atomic<const void *> producer = nullptr;
+
+        std::mutex continuationMutex;
+        std::vector<std::function<void()>> continuations;
     };
 
     template<typename T>
@@ -0,0 +1,192 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "strayphotons/Async.hh"
+#include "strayphotons/DispatchQueue.hh"
+
+#include <coroutine>
+#include <memory>
+
+/**
+ * Coroutine support for multi-step asynchronous loads.
+ *
+ * A function returning AsyncTask<T> may co_await any AsyncPtr<U> to get its value, and co_await ResumeOn(queue)
+ * to continue running as a work item on a DispatchQueue. The coroutine starts running immediately on the calling
+ * thread, and its co_return value resolves the AsyncPtr<T> the task converts to.
+ *
+ * Each step reuses the coroutine frame as its DispatchQueue work item, and frames are recycled through a shared pool,
+ * so a chain of N steps costs 1 frame and 1 result future instead of N work items and N futures.
+ *
+ * Coroutine arguments are copied into the frame, so they must not be references or views to temporaries.
+ *
+ * Example:
+ *  AsyncTask<Gltf> LoadGltf(DispatchQueue &queue, AsyncPtr<Asset> assetPtr) {
+ *      co_await ResumeOn(queue);
+ *      auto asset = co_await assetPtr; // Resumes on queue once the asset is loaded
+ *      co_return std::make_shared<Gltf>(asset);
+ *  }
+ */
+namespace sp {
+    struct CoroutineFrameStats {
+        // Frames allocated by AsyncTask coroutines, and how many of those were reused from the pool
+        uint64_t allocated = 0, reused = 0;
+        // Times an AsyncTask suspended and was later resumed as a DispatchQueue work item
+        uint64_t queuedResumes = 0;
+    };
+
+    CoroutineFrameStats GetCoroutineFrameStats();
+
+    namespace detail {
+        void *AllocateCoroutineFrame(size_t size);
+        void FreeCoroutineFrame(void *ptr, size_t size);
+
+        struct AsyncTaskPromiseBase : public DispatchQueueWorkItemBase {
+            static void *operator new(size_t size) {
+                return AllocateCoroutineFrame(size);
+            }
+
+            static void operator delete(void *ptr, size_t size) {
+                FreeCoroutineFrame(ptr, size);
+            }
+
+            std::suspend_never initial_suspend() noexcept {
+                return {};
+            }
+
+            // The result is stored in a separate future, so the frame can be freed as soon as the coroutine returns
+            std::suspend_never final_suspend() noexcept {
+                return {};
+            }
+
+            void unhandled_exception() {
+                Abortf("Unhandled exception in AsyncTask coroutine");
+            }
+
+            void Process() override {
+                coroutine.resume();
+            }
+
+            bool Ready() override {
+                return true;
+            }
+
+            void Cancel() override;
+
+            // Moves the suspended coroutine onto queue, it will be resumed by one of the queue's jobs.
+            // Must be called while queue is alive, so tasks should switch queues before waiting on any future.
+            void SwitchQueue(DispatchQueue &queue);
+            // Called before suspending to wait on a future, keeps the current queue from shutting down underneath it
+            void BeginWait();
+            // Resumes the suspended coroutine inline, or as a work item on the current queue
+            void Resume();
+
+            std::coroutine_handle<> coroutine;
+            // The queue this coroutine is running on, or null if it is running inline
+            std::shared_ptr<DispatchQueue::Handle> queueHandle;
+        };
+
+        template<typename T>
+        struct AsyncTaskPromise : public AsyncTaskPromiseBase {
+            void return_value(std::shared_ptr<T> value) {
+                result->Set(value);
+            }
+
+            AsyncPtr<T> result = std::make_shared<Async<T>>();
+        };
+
+        template<>
+        struct AsyncTaskPromise<void> : public AsyncTaskPromiseBase {
+            void return_void() {
+                result->Set(nullptr);
+            }
+
+            AsyncPtr<void> result = std::make_shared<Async<void>>();
+        };
+
+        template<typename T>
+        struct AsyncAwaiter {
+            AsyncPtr<T> future;
+
+            bool await_ready() const {
+                return !future || future->Ready();
+            }
+
+            template<typename Promise>
+            void await_suspend(std::coroutine_handle<Promise> handle) {
+                auto &promise = handle.promise();
+                promise.BeginWait();
+                // The callback may resume the coroutine immediately, so nothing in the frame can be used after this
+                future->Then([&promise] {
+                    promise.Resume();
+                });
+            }
+
+            std::shared_ptr<T> await_resume() const {
+                if (!future) return nullptr;
+                return future->Get();
+            }
+        };
+
+        struct QueueAwaiter {
+            DispatchQueue &queue;
+
+            bool await_ready() const {
+                return false;
+            }
+
+            template<typename Promise>
+            void await_suspend(std::coroutine_handle<Promise> handle) {
+                // Lets threads blocked on the result help run the queue, the frame can't be used after SwitchQueue
+                handle.promise().result->SetProducer(&queue);
+                handle.promise().SwitchQueue(queue);
+            }
+
+            void await_resume() const {}
+        };
+    } // namespace detail
+
+    template<typename T>
+    class AsyncTask {
+    public:
+        struct promise_type : public detail::AsyncTaskPromise<T> {
+            AsyncTask get_return_object() {
+                this->coroutine = std::coroutine_handle<promise_type>::from_promise(*this);
+                return AsyncTask(this->result);
+            }
+        };
+
+        operator AsyncPtr<T>() const {
+            return future;
+        }
+
+        const AsyncPtr<T> &Future() const {
+            return future;
+        }
+
+        detail::AsyncAwaiter<T> operator co_await() const {
+            return {future};
+        }
+
+    private:
+        AsyncTask(const AsyncPtr<T> &future) : future(future) {}
+
+        AsyncPtr<T> future;
+    };
+
+    // Suspends the calling AsyncTask until future is ready, returning its value
+    template<typename T>
+    detail::AsyncAwaiter<T> operator co_await(const AsyncPtr<T> &future) {
+        return {future};
+    }
+
+    // Continues the calling AsyncTask as a work item on queue, including after any later co_await
+    inline detail::QueueAwaiter ResumeOn(DispatchQueue &queue) {
+        return {queue};
+    }
+} // namespace sp
@@ -0,0 +1,81 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "strayphotons/Utility.hh"
+
+#include <array>
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Lock contention instrumentation, only compiled in when SP_CONTENTION_PROFILING is defined
+ * (cmake -DSP_ENABLE_CONTENTION_PROFILING=ON).
+ *
+ * Each named ContentionSite records how often a lock was acquired, how many acquisitions had to wait,
+ * how many spin iterations were needed, and a histogram of wait times. Contended acquisitions are also
+ * attributed to the call stack that waited, so the worst offenders can be listed.
+ */
+namespace sp::contention {
+    // Wait time histogram buckets: <1us, <4us, <16us, <64us, <256us, <1ms, <4ms, >=4ms
+    static const size_t WAIT_HISTOGRAM_BUCKETS = 8;
+    static const size_t CALL_SITE_DEPTH = 4;
+
+    struct SiteStats {
+        std::string name;
+        uint64_t acquires = 0, contended = 0, spins = 0;
+        chrono_clock::duration totalWait = {}, maxWait = {};
+        std::array<uint64_t, WAIT_HISTOGRAM_BUCKETS> waitHistogram = {};
+    };
+
+    struct CallSiteStats {
+        std::string siteName;
+        // Symbolized return addresses, innermost first
+        std::array<std::string, CALL_SITE_DEPTH> frames;
+        uint64_t contended = 0;
+        chrono_clock::duration totalWait = {};
+    };
+
+    class ContentionSite : public NonMoveable {
+    public:
+        ContentionSite(std::string_view name) : name(name) {}
+
+        void RecordAcquire() {
+            acquires.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // Must be called from the waiting thread, the call stack is captured as the contending call site
+        void RecordWait(size_t spins, chrono_clock::duration wait);
+
+        SiteStats GetStats() const;
+        void Reset();
+
+        const std::string name;
+
+    private:
+        std::atomic_uint64_t acquires = 0, contended = 0, spins = 0;
+        std::atomic<chrono_clock::rep> totalWait = 0, maxWait = 0;
+        std::array<std::atomic_uint64_t, WAIT_HISTOGRAM_BUCKETS> waitHistogram = {};
+
+        chrono_clock::rep lastPlottedWait = 0;
+        friend void PlotStats();
+    };
+
+    // Sites are never freed, all locks with the same name share a site
+    ContentionSite &GetSite(std::string_view name);
+
+    // Sorted by total wait time, sites that were never acquired are omitted
+    std::vector<SiteStats> GetAllStats();
+    std::vector<CallSiteStats> GetTopCallSites(size_t count);
+    void ResetStats();
+
+    // Plots the wait time accumulated since the previous call for each site, should be called once per frame
+    void PlotStats();
+} // namespace sp::contention
@@ -8,6 +8,7 @@
 #pragma once
 
 #include "strayphotons/Async.hh"
+#include "strayphotons/JobSystem.hh"
 #include "strayphotons/Utility.hh"
 
 #ifdef TRACY_ENABLE
@@ -21,7 +22,6 @@
 #include <mutex>
 #include <queue>
 #include <string>
-#include <thread>
 #include <type_traits>
 #include <vector>
 
@@ -50,6 +50,12 @@ namespace sp {
                 return future.get();
             }
 
+            // std::future has no continuation support, work items waiting on it are polled instead.
+            template<typename Fn>
+            bool OnReady(Fn &&) {
+                return false;
+            }
+
         private:
             std::future<T> future;
         };
@@ -69,6 +75,11 @@ namespace sp {
                 return future.get();
             }
 
+            template<typename Fn>
+            bool OnReady(Fn &&) {
+                return false;
+            }
+
         private:
             std::shared_future<T> future;
         };
@@ -89,6 +100,14 @@ namespace sp {
                 return future->Get();
             }
 
+            // Returns false if the future is already ready and the callback will not be called.
+            template<typename Fn>
+            bool OnReady(Fn &&callback) {
+                if (Ready()) return false;
+                future->Then(std::forward<Fn>(callback));
+                return true;
+            }
+
         private:
             AsyncPtr<T> future;
         };
@@ -97,10 +116,19 @@ namespace sp {
     struct DispatchQueueWorkItemBase {
         virtual void Process() = 0;
         virtual bool Ready() = 0;
+        // Called instead of Process() when the queue drops the item during shutdown
+        virtual void Cancel() {}
+
+        // Number of input futures that have not resolved yet, plus 1 while the item is being queued
+        std::atomic_size_t pendingInputs = 1;
     };
 
     class DispatchQueue;
 
+    namespace detail {
+        struct AsyncTaskPromiseBase;
+    }
+
     template<typename ReturnType, typename Fn, typename... Futures>
     struct DispatchQueueWorkItem final : public DispatchQueueWorkItemBase {
         using FutureTuple = std::tuple<detail::Future<Futures>...>;
@@ -109,7 +137,9 @@ namespace sp {
         template<typename... Args>
         DispatchQueueWorkItem(DispatchQueue &queue, Fn &&func, Args &&...args)
             : queue(queue), returnValue(std::make_shared<Async<ReturnType>>()), func(std::move(func)),
-              waitForFutures(std::make_tuple(detail::Future<std::remove_cvref_t<Args>>(args)...)) {}
+              waitForFutures(std::make_tuple(detail::Future<std::remove_cvref_t<Args>>(args)...)) {
+            returnValue->SetProducer(&queue);
+        }
 
         DispatchQueue &queue;
         AsyncPtr<ReturnType> returnValue;
@@ -127,15 +157,24 @@ namespace sp {
         }
     };
 
+    /**
+     * A named queue of work items, optionally executed by the engine-wide JobSystem.
+     *
+     * If threadCount is 0, items are only processed when Flush() is called.
+     * Otherwise, at most threadCount items from this queue will be processed concurrently by JobSystem workers.
+     *
+     * Work items are queued as soon as their last input future resolves. The futuresPollInterval is only used for
+     * std::future inputs, which have no way to notify on completion.
+     */
     class DispatchQueue : public NonCopyable {
     public:
         DispatchQueue(std::string name,
             size_t threadCount = 1,
-            chrono_clock::duration futuresPollInterval = std::chrono::milliseconds(5))
-            : name(std::move(name)), threads(threadCount), flushSleepInterval(futuresPollInterval) {
-            for (auto &thread : threads) {
-                thread = std::thread(&DispatchQueue::ThreadMain, this);
-            }
+            chrono_clock::duration futuresPollInterval = std::chrono::milliseconds(5),
+            JobPriority priority = JobPriority::Normal)
+            : name(std::move(name)), maxConcurrency(threadCount), priority(priority),
+              flushSleepInterval(futuresPollInterval), handle(std::make_shared<Handle>(this)) {
+            if (maxConcurrency > 0) jobSystem = &GetJobSystem();
         }
 
         ~DispatchQueue();
@@ -175,39 +214,70 @@ namespace sp {
          */
         template<typename FutT, typename T>
         void ForwardAsync(FutT from, const AsyncPtr<T> &to) {
-            if (from->Ready()) {
+            from->Then([from, to] {
                 to->Set(from->Get());
-            } else {
-                Dispatch<void>(from, [to](auto &fromValue) {
-                    to->Set(fromValue);
-                });
-            }
+            });
         }
 
         template<typename ReturnType, typename Fn, typename... Futures>
         AsyncPtr<ReturnType> DispatchInternal(Fn &&func, Futures &&...futures) {
-            Assert(!exit, "tried to dispatch to a shut down queue");
             auto item = std::make_shared<DispatchQueueWorkItem<ReturnType, Fn, std::remove_cvref_t<Futures>...>>(*this,
                 std::move(func),
                 std::move(futures)...);
 
-            std::unique_lock<std::mutex> lock(mutex);
-            workQueue.push(item);
-            workReady.notify_one();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                Assert(!exit, "tried to dispatch to a shut down queue");
+                waitingItems++;
+            }
+            // Register a continuation on each input, the item is queued when the last one resolves.
+            std::apply(
+                [&](auto &...future) {
+                    (
+                        [&] {
+                            item->pendingInputs++;
+                            bool registered = future.OnReady([handle = this->handle, item] {
+                                InputResolved(handle, item);
+                            });
+                            if (!registered) item->pendingInputs--;
+                        }(),
+                        ...);
+                },
+                item->waitForFutures);
+            InputResolved(handle, item);
             return item->returnValue;
         }
 
     private:
+        // AsyncTask coroutines queue themselves as work items, see AsyncTask.hh
+        friend struct detail::AsyncTaskPromiseBase;
+
+        // Shared with pending input continuations, which may outlive the queue
+        struct Handle {
+            Handle(DispatchQueue *queue) : queue(queue) {}
+
+            std::mutex mutex;
+            DispatchQueue *queue;
+        };
+
+        static void InputResolved(const std::shared_ptr<Handle> &handle,
+            std::shared_ptr<DispatchQueueWorkItemBase> item);
+        void EnqueueReady(std::shared_ptr<DispatchQueueWorkItemBase> &&item);
         size_t FlushInternal(std::unique_lock<std::mutex> &lock, size_t maxWorkItems, bool blockUntilReady);
-        void ThreadMain();
+        void SubmitJob(bool pollDelay);
+        void RunJob();
 
         std::mutex mutex;
         std::string name;
-        std::vector<std::thread> threads;
+        JobSystem *jobSystem = nullptr;
+        size_t maxConcurrency;
+        JobPriority priority;
         chrono_clock::duration flushSleepInterval;
+        std::shared_ptr<Handle> handle;
 
         std::queue<std::shared_ptr<DispatchQueueWorkItemBase>> workQueue;
-        std::condition_variable workReady;
+        size_t activeJobs = 0, waitingItems = 0;
+        std::condition_variable stateChanged;
         bool exit = false, dropPendingWork = false;
     };
 
@@ -10,77 +10,245 @@
 #include "strayphotons/Logging.hh"
 
 #include <Tecs.hh>
+#include <robin_hood.h>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace sp {
     /**
      * An entity map implementation meant to mimic the behavior of std::map<Tecs::Entity, T>.
-     * Values are stored in a vector according to their entity index, allowing for O(1) insertions and deletions.
+     *
+     * Implemented as a sparse set: a sparse vector indexed by entity index points into a densely packed array of
+     * (entity, value) pairs. Insertions and deletions are O(1), and iteration only visits stored entries.
+     * Erasing an entry moves the last entry into its place, so erasing invalidates iterators and references.
+     *
+     * If IndexValues is true, a reverse index from value to entries is maintained so that erase(const T &) is O(1)
+     * per removed entry. Values can then only be modified through insert_or_assign(), and T must be hashable.
      */
-    template<typename T, typename VectorT = std::vector<std::pair<TECS_ENTITY_GENERATION_TYPE, T>>>
-    class EntityMap : private VectorT {
+    template<typename T, bool IndexValues = false>
+    class EntityMap {
     public:
+        using value_type = std::pair<Tecs::Entity, T>;
+
         // Warning: This function will overwrite data when an entity index is reused.
-        T &operator[](const Tecs::Entity &e) {
+        T &operator[](const Tecs::Entity &e)
+            requires(!IndexValues)
+        {
             Assert(e, "Referencing EntityMap with null entity");
-            if (e.index >= VectorT::size()) VectorT::resize(e.index + 1);
-            auto &entry = VectorT::operator[](e.index);
-            if (entry.first == 0) entry.first = e.generation;
-            if (entry.first == e.generation) {
-                return entry.second;
-            } else {
-                entry = {e.generation, {}};
-            }
-            return entry.second;
+            return dense[insert(e)].second;
         }
 
         const T &operator[](const Tecs::Entity &e) const {
             Assert(e, "Referencing EntityMap with null entity");
-            Assert(e.index < VectorT::size(), "Referencing EntityMap with out of range entity");
-            auto &entry = VectorT::operator[](e.index);
-            Assert(entry.first == e.generation, "Referencing EntityMap with mismatched generation id");
-            return entry.second;
+            Assert(e.index < sparse.size(), "Referencing EntityMap with out of range entity");
+            auto &entry = sparse[e.index];
+            Assert(entry.denseIndex != INVALID_INDEX && entry.generation == e.generation,
+                "Referencing EntityMap with mismatched generation id");
+            return dense[entry.denseIndex].second;
+        }
+
+        // Warning: This function will overwrite data when an entity index is reused.
+        void insert_or_assign(const Tecs::Entity &e, T value) {
+            Assert(e, "Referencing EntityMap with null entity");
+            uint32_t index = insert(e);
+            if constexpr (IndexValues) {
+                if (linked[index]) {
+                    if (dense[index].second == value) return;
+                    unlinkValue(index);
+                }
+                dense[index].second = std::move(value);
+                linkValue(index);
+            } else {
+                dense[index].second = std::move(value);
+            }
         }
 
-        T *find(const Tecs::Entity &e) {
-            if (!e || e.index >= VectorT::size()) return nullptr;
-            auto &entry = VectorT::operator[](e.index);
-            if (entry.first == e.generation) return &entry.second;
-            return nullptr;
+        T *find(const Tecs::Entity &e)
+            requires(!IndexValues)
+        {
+            uint32_t index = denseIndex(e);
+            if (index == INVALID_INDEX) return nullptr;
+            return &dense[index].second;
         }
 
         const T *find(const Tecs::Entity &e) const {
-            if (!e || e.index >= VectorT::size()) return nullptr;
-            auto &entry = VectorT::operator[](e.index);
-            if (entry.first == e.generation) return &entry.second;
-            return nullptr;
+            uint32_t index = denseIndex(e);
+            if (index == INVALID_INDEX) return nullptr;
+            return &dense[index].second;
         }
 
-        // Iteration of this type is allowed, but inefficient due to its sparse layout.
-        using VectorT::begin;
-        using VectorT::end;
+        auto begin()
+            requires(!IndexValues)
+        {
+            return dense.begin();
+        }
+
+        auto end()
+            requires(!IndexValues)
+        {
+            return dense.end();
+        }
+
+        auto begin() const {
+            return dense.cbegin();
+        }
+
+        auto end() const {
+            return dense.cend();
+        }
 
         size_t count(const Tecs::Entity &e) const {
-            if (!e || e.index >= VectorT::size()) return 0;
-            auto &entry = VectorT::operator[](e.index);
-            if (entry.first == e.generation) return 1;
-            return 0;
+            return denseIndex(e) == INVALID_INDEX ? 0 : 1;
+        }
+
+        size_t size() const {
+            return dense.size();
+        }
+
+        bool empty() const {
+            return dense.empty();
         }
 
         void erase(const Tecs::Entity &e) {
-            if (!e || e.index >= VectorT::size()) return;
-            auto &entry = VectorT::operator[](e.index);
-            if (entry.first == e.generation) entry = {};
+            uint32_t index = denseIndex(e);
+            if (index != INVALID_INDEX) eraseDense(index);
         }
 
+        // Erases all entries with a matching value
         void erase(const T &value) {
-            for (auto &entry : *this) {
-                if (entry.first != 0 && entry.second == value) {
-                    entry = {};
+            if constexpr (IndexValues) {
+                auto it = valueHeads.find(value);
+                while (it != valueHeads.end()) {
+                    // eraseDense() moves the head forward, or removes it once no entries are left
+                    eraseDense(it->second);
+                    it = valueHeads.find(value);
+                }
+            } else {
+                for (size_t i = dense.size(); i > 0; i--) {
+                    if (dense[i - 1].second == value) eraseDense(i - 1);
+                }
+            }
+        }
+
+        void clear() {
+            sparse.clear();
+            dense.clear();
+            if constexpr (IndexValues) {
+                links.clear();
+                linked.clear();
+                valueHeads.clear();
+            }
+        }
+
+    private:
+        static constexpr uint32_t INVALID_INDEX = ~0u;
+
+        struct SparseEntry {
+            TECS_ENTITY_GENERATION_TYPE generation = 0;
+            uint32_t denseIndex = INVALID_INDEX;
+        };
+
+        // Doubly linked list of dense entries sharing the same value
+        struct ValueLink {
+            uint32_t prev = INVALID_INDEX;
+            uint32_t next = INVALID_INDEX;
+        };
+
+        uint32_t denseIndex(const Tecs::Entity &e) const {
+            if (!e || e.index >= sparse.size()) return INVALID_INDEX;
+            auto &entry = sparse[e.index];
+            if (entry.generation != e.generation) return INVALID_INDEX;
+            return entry.denseIndex;
+        }
+
+        // Returns the dense index for e, resetting the value if the entity index was in use by another generation.
+        uint32_t insert(const Tecs::Entity &e) {
+            if (e.index >= sparse.size()) sparse.resize(e.index + 1);
+            auto &entry = sparse[e.index];
+            if (entry.denseIndex == INVALID_INDEX) {
+                entry = {e.generation, (uint32_t)dense.size()};
+                dense.emplace_back(e, T());
+                if constexpr (IndexValues) {
+                    links.emplace_back();
+                    linked.emplace_back(false);
+                }
+            } else if (entry.generation != e.generation) {
+                if constexpr (IndexValues) {
+                    if (linked[entry.denseIndex]) unlinkValue(entry.denseIndex);
                 }
+                entry.generation = e.generation;
+                dense[entry.denseIndex] = {e, T()};
             }
+            return entry.denseIndex;
         }
 
-        using VectorT::clear;
+        void eraseDense(uint32_t index) {
+            uint32_t last = dense.size() - 1;
+            if constexpr (IndexValues) {
+                if (linked[index]) unlinkValue(index);
+            }
+            sparse[dense[index].first.index] = {};
+            if (index != last) {
+                dense[index] = std::move(dense[last]);
+                sparse[dense[index].first.index].denseIndex = index;
+                if constexpr (IndexValues) {
+                    links[index] = links[last];
+                    linked[index] = linked[last];
+                    if (linked[index]) relinkValue(index);
+                }
+            }
+            dense.pop_back();
+            if constexpr (IndexValues) {
+                links.pop_back();
+                linked.pop_back();
+            }
+        }
+
+        void linkValue(uint32_t index) {
+            auto [it, inserted] = valueHeads.try_emplace(dense[index].second, index);
+            auto &link = links[index];
+            link.prev = INVALID_INDEX;
+            link.next = INVALID_INDEX;
+            if (!inserted) {
+                link.next = it->second;
+                links[it->second].prev = index;
+                it->second = index;
+            }
+            linked[index] = true;
+        }
+
+        void unlinkValue(uint32_t index) {
+            auto &link = links[index];
+            if (link.prev != INVALID_INDEX) {
+                links[link.prev].next = link.next;
+            } else if (link.next != INVALID_INDEX) {
+                valueHeads[dense[index].second] = link.next;
+            } else {
+                valueHeads.erase(dense[index].second);
+            }
+            if (link.next != INVALID_INDEX) links[link.next].prev = link.prev;
+            link = {};
+            linked[index] = false;
+        }
+
+        // Points the neighbours of an entry that was moved to newIndex at its new location
+        void relinkValue(uint32_t newIndex) {
+            auto &link = links[newIndex];
+            if (link.prev != INVALID_INDEX) {
+                links[link.prev].next = newIndex;
+            } else {
+                valueHeads[dense[newIndex].second] = newIndex;
+            }
+            if (link.next != INVALID_INDEX) links[link.next].prev = newIndex;
+        }
+
+        std::vector<SparseEntry> sparse;
+        std::vector<value_type> dense;
+
+        struct NoValueIndex {};
+        std::conditional_t<IndexValues, std::vector<ValueLink>, NoValueIndex> links;
+        std::conditional_t<IndexValues, std::vector<bool>, NoValueIndex> linked;
+        std::conditional_t<IndexValues, robin_hood::unordered_flat_map<T, uint32_t>, NoValueIndex> valueHeads;
     };
 } // namespace sp
@@ -0,0 +1,171 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "strayphotons/Utility.hh"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace sp {
+    enum class JobPriority : uint8_t {
+        High = 0,
+        Normal,
+        Low,
+    };
+    static const size_t JOB_PRIORITY_COUNT = 3;
+
+    /**
+     * Engine-wide work-stealing scheduler.
+     *
+     * Each worker thread owns one deque per priority level. Jobs submitted from a worker are pushed onto its own
+     * deque, while jobs submitted from any other thread are distributed round-robin. Idle workers steal from the
+     * back of other workers' deques, always preferring higher priority work.
+     *
+     * DispatchQueue instances with worker threads are thin named views over this scheduler.
+     */
+    class JobSystem : public NonMoveable {
+    public:
+        using Job = std::function<void()>;
+
+        // A workerCount of 0 will use one worker per hardware thread.
+        JobSystem(size_t workerCount = 0);
+        ~JobSystem();
+
+        // The owner tags the job so threads waiting on the owner's results can run it, see HelpWhileWaiting()
+        void Submit(Job &&job, JobPriority priority = JobPriority::Normal, const void *owner = nullptr);
+        // The job will be submitted once the delay has passed. Used by DispatchQueue to re-poll futures.
+        void SubmitAfter(chrono_clock::duration delay,
+            Job &&job,
+            JobPriority priority = JobPriority::Normal,
+            const void *owner = nullptr);
+
+        // Runs a single pending job submitted by owner on the calling thread if one is available.
+        // This is only allowed from worker threads, and returns false otherwise.
+        bool RunPendingJob(const void *owner);
+
+        void Shutdown();
+
+        size_t GetWorkerCount() const {
+            return workers.size();
+        }
+
+        // Returns the index of the current worker thread, or -1 if called from outside this JobSystem
+        int GetCurrentWorkerIndex() const;
+
+    private:
+        struct QueuedJob {
+            Job job;
+            const void *owner;
+        };
+
+        struct Worker {
+            std::mutex mutex;
+            std::array<std::deque<QueuedJob>, JOB_PRIORITY_COUNT> jobs;
+            std::thread thread;
+        };
+
+        struct DelayedJob {
+            chrono_clock::time_point readyTime;
+            JobPriority priority;
+            const void *owner;
+            std::shared_ptr<Job> job;
+
+            bool operator>(const DelayedJob &other) const {
+                return readyTime > other.readyTime;
+            }
+        };
+
+        void WorkerMain(size_t workerIndex);
+        bool TryPopJob(size_t workerIndex, Job &jobOut);
+        bool TryPopOwnedJob(size_t workerIndex, const void *owner, Job &jobOut);
+        void SubmitDelayedJobs();
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::atomic_size_t nextWorker = 0;
+        std::atomic_size_t pendingJobs = 0;
+
+        std::mutex sleepMutex;
+        std::condition_variable jobsReady;
+        std::priority_queue<DelayedJob, std::vector<DelayedJob>, std::greater<DelayedJob>> delayedJobs;
+        bool exit = false;
+    };
+
+    JobSystem &GetJobSystem();
+
+    /**
+     * Called in a loop by threads blocking on a future produced by the given job owner (e.g. a DispatchQueue).
+     * Worker threads will run a single pending job from that owner (or yield) and return true, so that a job waiting
+     * on another job can't starve the pool. Unrelated jobs are never run, since the caller may be holding locks
+     * (such as an ECS transaction) that they need.
+     * Returns false on non-worker threads or if the producer is unknown, in which case the caller should block.
+     */
+    bool HelpWhileWaiting(const void *producer);
+
+    /**
+     * Calls func(i) for every i in [0, count), split into chunks of at least minChunkSize that run on the JobSystem.
+     * The calling thread also runs chunks, and the call returns once every index has been processed.
+     * func must be safe to call concurrently for different indexes.
+     */
+    template<typename Func>
+    void ParallelFor(size_t count, size_t minChunkSize, Func &&func, JobPriority priority = JobPriority::High) {
+        if (count == 0) return;
+        auto &jobSystem = GetJobSystem();
+        minChunkSize = std::max<size_t>(minChunkSize, 1);
+        size_t chunkCount = std::min((count + minChunkSize - 1) / minChunkSize, jobSystem.GetWorkerCount() * 4 + 1);
+        if (chunkCount <= 1) {
+            for (size_t i = 0; i < count; i++) {
+                func(i);
+            }
+            return;
+        }
+
+        // Jobs claim a chunk before touching anything on this stack frame, and the call only returns once every
+        // claimed chunk has completed. Jobs that start after all chunks are claimed exit without waiting on anything,
+        // so the calling thread never needs to run other jobs while it waits.
+        struct ChunkState {
+            size_t chunkCount;
+            std::atomic_size_t nextChunk = 0;
+            std::atomic_size_t completedChunks = 0;
+        };
+        auto state = std::make_shared<ChunkState>();
+        state->chunkCount = chunkCount;
+        size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+        auto runChunks = [&func, count, chunkSize](ChunkState &state, size_t chunk) {
+            for (; chunk < state.chunkCount; chunk = state.nextChunk++) {
+                size_t end = std::min(count, (chunk + 1) * chunkSize);
+                for (size_t i = chunk * chunkSize; i < end; i++) {
+                    func(i);
+                }
+                if (++state.completedChunks == state.chunkCount) state.completedChunks.notify_all();
+            }
+        };
+        for (size_t job = 1; job < chunkCount; job++) {
+            jobSystem.Submit(
+                [state, &runChunks] {
+                    size_t chunk = state->nextChunk++;
+                    if (chunk < state->chunkCount) runChunks(*state, chunk);
+                },
+                priority);
+        }
+        runChunks(*state, state->nextChunk++);
+        for (size_t completed = state->completedChunks.load(); completed < chunkCount;
+             completed = state->completedChunks.load()) {
+            state->completedChunks.wait(completed);
+        }
+    }
+} // namespace sp
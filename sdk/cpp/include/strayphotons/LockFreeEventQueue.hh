@@ -7,50 +7,173 @@
 
 #pragma once
 
-#include "strayphotons/InlineVector.hh"
 #include "strayphotons/LockFreeMutex.hh"
+#include "strayphotons/Logging.hh"
 
+#include <array>
+#include <atomic>
+#include <cstddef>
 #include <mutex>
+#include <thread>
+#include <typeinfo>
+#include <vector>
 
 namespace sp {
-    template<typename Event, size_t MaxQueueSize = 1000>
+    /**
+     * Bounded multi-producer single-consumer event ring.
+     *
+     * PushEvent() never takes a lock while the ring has space. When the ring is full, events are spilled into a
+     * heap-allocated overflow segment that is drained after the ring, or dropped if SpillOnOverflow is false.
+     * Multiple threads may poll the queue, but only one will consume events at a time.
+     */
+    template<typename Event, size_t MaxQueueSize = 1000, bool SpillOnOverflow = true>
     class LockFreeEventQueue {
     public:
-        LockFreeEventQueue() {}
+        LockFreeEventQueue() {
+            for (size_t i = 0; i < ring.size(); i++) {
+                ring[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
 
         template<typename Fn>
         bool TryPollEvents(Fn &&eventCallback) {
-            if (eventMutex.try_lock()) {
-                for (auto &event : eventBuffer) {
-                    eventCallback(event);
-                }
-                eventBuffer.clear();
-                eventMutex.unlock();
-                return true;
-            }
-            return false;
+            if (polling.test_and_set(std::memory_order_acquire)) return false;
+            DrainEvents(eventCallback);
+            polling.clear(std::memory_order_release);
+            polling.notify_one();
+            return true;
         }
 
         template<typename Fn>
         void PollEvents(Fn &&eventCallback) {
-            std::lock_guard lock(eventMutex);
-            for (auto &event : eventBuffer) {
-                eventCallback(event);
+            while (polling.test_and_set(std::memory_order_acquire)) {
+                polling.wait(true);
             }
-            eventBuffer.clear();
+            DrainEvents(eventCallback);
+            polling.clear(std::memory_order_release);
+            polling.notify_one();
         }
 
         void PushEvent(Event &&event) {
-            std::lock_guard lock(eventMutex);
-            if (eventBuffer.size() < eventBuffer.capacity()) {
-                eventBuffer.emplace_back(std::move(event));
+            // Once events have spilled, keep spilling until the consumer catches up to preserve ordering
+            if (spillCount.load() == 0 && TryPushRing(event)) return;
+
+            if constexpr (SpillOnOverflow) {
+                std::lock_guard lock(spillMutex);
+                spillBuffer.emplace_back(std::move(event));
+                spillCount++;
+                overflowCount++;
             } else {
+                droppedCount++;
                 Errorf("LockFreeEventQueue full! Dropping event %s", typeid(Event).name());
             }
         }
 
+        // Total number of events that did not fit in the ring and were spilled to the heap
+        size_t GetOverflowCount() const {
+            return overflowCount.load(std::memory_order_relaxed);
+        }
+
+        // Total number of events dropped because the ring was full and SpillOnOverflow is disabled
+        size_t GetDroppedCount() const {
+            return droppedCount.load(std::memory_order_relaxed);
+        }
+
     private:
-        LockFreeMutex eventMutex;
-        InlineVector<Event, MaxQueueSize> eventBuffer;
+        static constexpr size_t ceilCapacity(size_t size) {
+            size_t capacity = 1;
+            while (capacity < size) {
+                capacity <<= 1;
+            }
+            return capacity;
+        }
+
+        static constexpr size_t RING_CAPACITY = ceilCapacity(MaxQueueSize);
+        static constexpr size_t RING_MASK = RING_CAPACITY - 1;
+
+        // Moves from event only if it was successfully pushed
+        bool TryPushRing(Event &event) {
+            size_t pos = writeIndex.load(std::memory_order_relaxed);
+            while (true) {
+                auto &slot = ring[pos & RING_MASK];
+                size_t sequence = slot.sequence.load(std::memory_order_acquire);
+                intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+                if (diff == 0) {
+                    if (writeIndex.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        slot.event = std::move(event);
+                        slot.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (diff < 0) {
+                    // Ring is full
+                    return false;
+                } else {
+                    pos = writeIndex.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        template<typename Fn>
+        void DrainRing(Fn &eventCallback, size_t endIndex, bool waitForWriters) {
+            while (readIndex != endIndex) {
+                auto &slot = ring[readIndex & RING_MASK];
+                size_t sequence = slot.sequence.load(std::memory_order_acquire);
+                if (sequence != readIndex + 1) {
+                    // A producer has reserved this slot, but not finished writing it yet
+                    if (!waitForWriters) break;
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                eventCallback(slot.event);
+                slot.event = Event();
+                slot.sequence.store(readIndex + RING_CAPACITY, std::memory_order_release);
+                readIndex++;
+            }
+        }
+
+        template<typename Fn>
+        void DrainEvents(Fn &eventCallback) {
+            if constexpr (SpillOnOverflow) {
+                if (spillCount.load() > 0) {
+                    size_t endIndex;
+                    {
+                        // Swap buffers so callbacks are free to push new events. The ring end is read under the same
+                        // lock, so any event a producer pushes to the ring after its spilled events is left for the
+                        // next poll.
+                        std::lock_guard lock(spillMutex);
+                        std::swap(spillBuffer, drainBuffer);
+                        endIndex = writeIndex.load();
+                        spillCount = 0;
+                    }
+                    // Any event a producer pushed to the ring before spilling must be delivered first
+                    DrainRing(eventCallback, endIndex, true);
+                    for (auto &event : drainBuffer) {
+                        eventCallback(event);
+                    }
+                    drainBuffer.clear();
+                    return;
+                }
+            }
+            // Only drain events that were pushed before polling started
+            DrainRing(eventCallback, writeIndex.load(std::memory_order_acquire), false);
+        }
+
+        struct Slot {
+            std::atomic_size_t sequence;
+            Event event;
+        };
+
+        std::array<Slot, RING_CAPACITY> ring;
+        alignas(64) std::atomic_size_t writeIndex = 0;
+        alignas(64) size_t readIndex = 0;
+        std::atomic_flag polling;
+
+        LockFreeMutex spillMutex;
+        std::vector<Event> spillBuffer, drainBuffer;
+        std::atomic_size_t spillCount = 0;
+
+        std::atomic_size_t overflowCount = 0;
+        std::atomic_size_t droppedCount = 0;
     };
 } // namespace sp
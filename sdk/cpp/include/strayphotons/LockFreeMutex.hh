@@ -9,6 +9,10 @@
 
 #include "strayphotons/Utility.hh"
 
+#ifdef SP_CONTENTION_PROFILING
+    #include "strayphotons/ContentionProfiler.hh"
+#endif
+
 #include <atomic>
 #include <cstddef>
 
@@ -18,6 +22,16 @@ namespace sp {
     // Implements the requirements for SharedMutex: https://en.cppreference.com/w/cpp/named_req/SharedMutex
     class LockFreeMutex : public NonCopyable {
     public:
+        // The name is used to group contention statistics, and is ignored unless SP_CONTENTION_PROFILING is defined
+#ifdef SP_CONTENTION_PROFILING
+        LockFreeMutex() : LockFreeMutex("LockFreeMutex") {}
+        explicit LockFreeMutex(const char *contentionName)
+            : contentionSite(&contention::GetSite(contentionName)) {}
+#else
+        LockFreeMutex() {}
+        explicit LockFreeMutex(const char *) {}
+#endif
+
         // Read locks
         void lock_shared();
         bool try_lock_shared();
@@ -36,5 +50,9 @@ namespace sp {
 
         std::atomic_uint32_t lockState;
         std::atomic_bool exclusiveWaiting;
+
+#ifdef SP_CONTENTION_PROFILING
+        contention::ContentionSite *contentionSite;
+#endif
     };
 } // namespace sp
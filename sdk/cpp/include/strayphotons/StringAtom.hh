@@ -0,0 +1,75 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace sp {
+    /**
+     * A 32-bit handle to a string stored in a global intern table.
+     *
+     * Equal strings always intern to the same atom, so atoms can be compared and hashed as integers.
+     * Interned strings are never freed, and their storage stays valid for the lifetime of the process.
+     *
+     * Looking up an already interned string is lock-free; only the first insertion of a new string takes a lock.
+     * Atom ids depend on insertion order, so atoms must not be ordered or serialized by id.
+     */
+    class StringAtom {
+    public:
+        StringAtom() {}
+        explicit StringAtom(std::string_view str) : id(Intern(str)) {}
+
+        // Returns the atom for str only if it has already been interned
+        static std::optional<StringAtom> Find(std::string_view str);
+        // Number of distinct non-empty strings interned so far
+        static size_t InternedCount();
+
+        std::string_view View() const;
+        const char *c_str() const {
+            return View().data();
+        }
+        std::string str() const {
+            return std::string(View());
+        }
+
+        uint32_t Id() const {
+            return id;
+        }
+
+        bool empty() const {
+            return id == 0;
+        }
+
+        bool operator==(const StringAtom &other) const = default;
+
+    private:
+        static uint32_t Intern(std::string_view str);
+
+        // Id 0 is reserved for the empty string
+        uint32_t id = 0;
+    };
+
+    inline std::ostream &operator<<(std::ostream &out, const StringAtom &atom) {
+        return out << atom.View();
+    }
+} // namespace sp
+
+namespace std {
+    template<>
+    struct hash<sp::StringAtom> {
+        std::size_t operator()(const sp::StringAtom &atom) const {
+            return std::hash<uint32_t>()(atom.Id());
+        }
+    };
+} // namespace std
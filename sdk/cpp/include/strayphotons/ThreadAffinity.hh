@@ -0,0 +1,63 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sp {
+    /**
+     * Describes which CPU cores each engine thread is allowed to run on.
+     *
+     * The policy is parsed from a comma-separated list of entries:
+     *   <ThreadName>=<cores>  Pin a named RegisteredThread to a set of cores
+     *   reserve=<cores>       Keep all threads that aren't explicitly pinned off of these cores
+     *   workers=<cores>       Restrict JobSystem workers to these cores
+     *   numa=<node|auto>      Restrict JobSystem workers to a NUMA node (auto uses the node of the calling thread)
+     * Core sets are joined with '+', and may include ranges: "0-3+8"
+     *
+     * Example: "AudioManager=3,GameLogic=2,reserve=2-3,numa=auto"
+     */
+    class ThreadAffinityPolicy {
+    public:
+        // Returns nullptr and logs an error if the spec is invalid
+        static std::shared_ptr<ThreadAffinityPolicy> Parse(std::string_view spec);
+
+        // Returns an empty list if the thread may run on any core
+        std::vector<uint32_t> GetThreadCores(std::string_view threadName) const;
+        std::vector<uint32_t> GetWorkerCores() const;
+
+        std::string Describe() const;
+
+        std::string spec;
+
+    private:
+        std::vector<uint32_t> GetUnreservedCores(std::vector<uint32_t> cores) const;
+
+        std::map<std::string, std::vector<uint32_t>, std::less<>> pinnedThreads;
+        std::vector<uint32_t> reservedCores, workerCores, numaCores;
+        int numaNode = -1;
+    };
+
+    // Replaces the active policy, threads will apply it the next time they call UpdateThreadAffinity()
+    bool SetThreadAffinityPolicy(std::string_view spec);
+    std::shared_ptr<const ThreadAffinityPolicy> GetThreadAffinityPolicy();
+
+    /**
+     * Applies the active policy to the calling thread if it has changed since the last call on this thread.
+     * RegisteredThreads are matched by name, JobSystem workers should pass isWorker = true.
+     * This is cheap enough to call once per frame.
+     */
+    void UpdateThreadAffinity(std::string_view threadName, bool isWorker = false);
+
+    size_t GetCoreCount();
+} // namespace sp
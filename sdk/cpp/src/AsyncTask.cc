@@ -0,0 +1,135 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "strayphotons/AsyncTask.hh"
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace sp {
+    namespace {
+        // Frames are pooled in 64 byte size classes up to 2KB, larger frames use the global allocator directly
+        static const size_t FRAME_SIZE_GRANULARITY = 64;
+        static const size_t FRAME_SIZE_CLASSES = 32;
+        static const size_t MAX_POOLED_FRAMES = 256;
+
+        // Frames are usually freed on a different thread than they were allocated on (the last queue they ran on),
+        // so a single pool is shared by all threads.
+        struct FramePool {
+            std::mutex mutex;
+            std::array<std::vector<void *>, FRAME_SIZE_CLASSES> freeFrames;
+
+            ~FramePool() {
+                for (auto &frames : freeFrames) {
+                    for (auto *frame : frames) {
+                        ::operator delete(frame);
+                    }
+                }
+            }
+        };
+
+        FramePool &getFramePool() {
+            static FramePool pool;
+            return pool;
+        }
+
+        std::atomic_uint64_t framesAllocated = 0, framesReused = 0, queuedResumes = 0;
+
+        size_t GetSizeClass(size_t size) {
+            return (size + FRAME_SIZE_GRANULARITY - 1) / FRAME_SIZE_GRANULARITY;
+        }
+    } // namespace
+
+    CoroutineFrameStats GetCoroutineFrameStats() {
+        CoroutineFrameStats stats;
+        stats.allocated = framesAllocated.load(std::memory_order_relaxed);
+        stats.reused = framesReused.load(std::memory_order_relaxed);
+        stats.queuedResumes = queuedResumes.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    namespace detail {
+        void *AllocateCoroutineFrame(size_t size) {
+            framesAllocated.fetch_add(1, std::memory_order_relaxed);
+            size_t sizeClass = GetSizeClass(size);
+            if (sizeClass == 0 || sizeClass > FRAME_SIZE_CLASSES) return ::operator new(size);
+
+            auto &pool = getFramePool();
+            {
+                std::lock_guard lock(pool.mutex);
+                auto &frames = pool.freeFrames[sizeClass - 1];
+                if (!frames.empty()) {
+                    void *frame = frames.back();
+                    frames.pop_back();
+                    framesReused.fetch_add(1, std::memory_order_relaxed);
+                    return frame;
+                }
+            }
+            return ::operator new(sizeClass * FRAME_SIZE_GRANULARITY);
+        }
+
+        void FreeCoroutineFrame(void *ptr, size_t size) {
+            size_t sizeClass = GetSizeClass(size);
+            if (sizeClass > 0 && sizeClass <= FRAME_SIZE_CLASSES) {
+                auto &pool = getFramePool();
+                std::lock_guard lock(pool.mutex);
+                auto &frames = pool.freeFrames[sizeClass - 1];
+                if (frames.size() < MAX_POOLED_FRAMES) {
+                    if (frames.capacity() == 0) frames.reserve(MAX_POOLED_FRAMES);
+                    frames.emplace_back(ptr);
+                    return;
+                }
+            }
+            ::operator delete(ptr);
+        }
+
+        void AsyncTaskPromiseBase::SwitchQueue(DispatchQueue &queue) {
+            {
+                std::lock_guard lock(queue.mutex);
+                Assert(!queue.exit, "tried to resume a coroutine on a shut down queue");
+                queue.waitingItems++;
+            }
+            queueHandle = queue.handle;
+            Resume();
+        }
+
+        void AsyncTaskPromiseBase::Cancel() {
+            // Same as a work item dropped by its queue, the task's future is never resolved
+            coroutine.destroy();
+        }
+
+        void AsyncTaskPromiseBase::BeginWait() {
+            if (!queueHandle) return;
+
+            std::lock_guard handleLock(queueHandle->mutex);
+            auto *queue = queueHandle->queue;
+            if (!queue) return;
+            std::lock_guard lock(queue->mutex);
+            queue->waitingItems++;
+        }
+
+        void AsyncTaskPromiseBase::Resume() {
+            if (!queueHandle) {
+                coroutine.resume();
+                return;
+            }
+
+            std::unique_lock handleLock(queueHandle->mutex);
+            auto *queue = queueHandle->queue;
+            if (!queue) {
+                handleLock.unlock();
+                Cancel();
+                return;
+            }
+            queuedResumes.fetch_add(1, std::memory_order_relaxed);
+            // The coroutine frame owns this work item, so the queue holds it without a reference count
+            queue->EnqueueReady(std::shared_ptr<DispatchQueueWorkItemBase>(std::shared_ptr<void>(), this));
+        }
+    } // namespace detail
+} // namespace sp
@@ -0,0 +1,235 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "strayphotons/ContentionProfiler.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+
+#ifdef TRACY_ENABLE
+    #include "common/Tracing.hh"
+#endif
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#elif defined(__linux__) || defined(__APPLE__)
+    #include <cxxabi.h>
+    #include <dlfcn.h>
+    #include <execinfo.h>
+#endif
+
+namespace sp::contention {
+    namespace {
+        struct CallSite {
+            std::atomic<uint64_t> key = 0;
+            std::atomic<const ContentionSite *> site = nullptr;
+            std::array<std::atomic<void *>, CALL_SITE_DEPTH> frames = {};
+            std::atomic_uint64_t contended = 0;
+            std::atomic<chrono_clock::rep> totalWait = 0;
+        };
+
+        static const size_t CALL_SITE_TABLE_SIZE = 1024;
+        std::array<CallSite, CALL_SITE_TABLE_SIZE> callSites;
+
+        // Sites may be created by mutexes constructed during static initialization
+        std::mutex &getSitesMutex() {
+            static std::mutex sitesMutex;
+            return sitesMutex;
+        }
+        std::deque<ContentionSite> &getSites() {
+            static std::deque<ContentionSite> sites;
+            return sites;
+        }
+
+        size_t GetHistogramBucket(chrono_clock::duration wait) {
+            auto micros = std::chrono::duration_cast<std::chrono::microseconds>(wait).count();
+            size_t bucket = 0;
+            for (int64_t bound = 1; bucket < WAIT_HISTOGRAM_BUCKETS - 1 && micros >= bound; bound *= 4) {
+                bucket++;
+            }
+            return bucket;
+        }
+
+        size_t CaptureCallers(std::array<void *, CALL_SITE_DEPTH> &out) {
+            // Skip this function and RecordWait
+            static const size_t SKIP_FRAMES = 2;
+            std::array<void *, SKIP_FRAMES + CALL_SITE_DEPTH> frames = {};
+#ifdef _WIN32
+            size_t count = CaptureStackBackTrace(0, (DWORD)frames.size(), frames.data(), nullptr);
+#elif defined(__linux__) || defined(__APPLE__)
+            size_t count = std::max(0, backtrace(frames.data(), (int)frames.size()));
+#else
+            size_t count = 0;
+#endif
+            size_t outCount = 0;
+            for (size_t i = SKIP_FRAMES; i < count && outCount < CALL_SITE_DEPTH; i++) {
+                out[outCount++] = frames[i];
+            }
+            return outCount;
+        }
+
+        std::string Symbolize(void *address) {
+            if (!address) return "";
+#if defined(__linux__) || defined(__APPLE__)
+            Dl_info info;
+            if (dladdr(address, &info) && info.dli_sname) {
+                int status = 0;
+                char *demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+                std::string name = status == 0 && demangled ? demangled : info.dli_sname;
+                free(demangled);
+                return name + "+" + std::to_string((uintptr_t)address - (uintptr_t)info.dli_saddr);
+            }
+#endif
+            char buffer[32];
+            std::snprintf(buffer, sizeof(buffer), "%p", address);
+            return buffer;
+        }
+
+        void AtomicMax(std::atomic<chrono_clock::rep> &value, chrono_clock::rep newValue) {
+            auto current = value.load(std::memory_order_relaxed);
+            while (current < newValue && !value.compare_exchange_weak(current, newValue)) {}
+        }
+    } // namespace
+
+    void ContentionSite::RecordWait(size_t spinCount, chrono_clock::duration wait) {
+        contended.fetch_add(1, std::memory_order_relaxed);
+        spins.fetch_add(spinCount, std::memory_order_relaxed);
+        totalWait.fetch_add(wait.count(), std::memory_order_relaxed);
+        AtomicMax(maxWait, wait.count());
+        waitHistogram[GetHistogramBucket(wait)].fetch_add(1, std::memory_order_relaxed);
+
+        std::array<void *, CALL_SITE_DEPTH> frames = {};
+        size_t frameCount = CaptureCallers(frames);
+        uint64_t key = std::hash<const void *>()(this);
+        for (size_t i = 0; i < frameCount; i++) {
+            key = key * 31 + std::hash<void *>()(frames[i]);
+        }
+        if (key == 0) key = 1;
+
+        // Open addressing, entries are claimed by the first thread to see a new call stack and never removed
+        for (size_t probe = 0; probe < CALL_SITE_TABLE_SIZE; probe++) {
+            auto &entry = callSites[(key + probe) % CALL_SITE_TABLE_SIZE];
+            uint64_t existing = entry.key.load(std::memory_order_acquire);
+            if (existing == 0) {
+                if (!entry.key.compare_exchange_strong(existing, key)) {
+                    if (existing != key) continue;
+                } else {
+                    for (size_t i = 0; i < CALL_SITE_DEPTH; i++) {
+                        entry.frames[i].store(frames[i], std::memory_order_relaxed);
+                    }
+                    entry.site.store(this, std::memory_order_release);
+                }
+            } else if (existing != key) {
+                continue;
+            }
+            entry.contended.fetch_add(1, std::memory_order_relaxed);
+            entry.totalWait.fetch_add(wait.count(), std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    SiteStats ContentionSite::GetStats() const {
+        SiteStats stats;
+        stats.name = name;
+        stats.acquires = acquires.load(std::memory_order_relaxed);
+        stats.contended = contended.load(std::memory_order_relaxed);
+        stats.spins = spins.load(std::memory_order_relaxed);
+        stats.totalWait = chrono_clock::duration(totalWait.load(std::memory_order_relaxed));
+        stats.maxWait = chrono_clock::duration(maxWait.load(std::memory_order_relaxed));
+        for (size_t i = 0; i < WAIT_HISTOGRAM_BUCKETS; i++) {
+            stats.waitHistogram[i] = waitHistogram[i].load(std::memory_order_relaxed);
+        }
+        return stats;
+    }
+
+    void ContentionSite::Reset() {
+        acquires = 0;
+        contended = 0;
+        spins = 0;
+        totalWait = 0;
+        maxWait = 0;
+        lastPlottedWait = 0;
+        for (auto &bucket : waitHistogram) {
+            bucket = 0;
+        }
+    }
+
+    ContentionSite &GetSite(std::string_view name) {
+        std::lock_guard lock(getSitesMutex());
+        for (auto &site : getSites()) {
+            if (site.name == name) return site;
+        }
+        return getSites().emplace_back(name);
+    }
+
+    std::vector<SiteStats> GetAllStats() {
+        std::vector<SiteStats> result;
+        {
+            std::lock_guard lock(getSitesMutex());
+            for (auto &site : getSites()) {
+                auto stats = site.GetStats();
+                if (stats.acquires > 0 || stats.contended > 0) result.emplace_back(std::move(stats));
+            }
+        }
+        std::sort(result.begin(), result.end(), [](auto &a, auto &b) {
+            return a.totalWait > b.totalWait;
+        });
+        return result;
+    }
+
+    std::vector<CallSiteStats> GetTopCallSites(size_t count) {
+        std::vector<const CallSite *> entries;
+        for (auto &entry : callSites) {
+            if (entry.site.load(std::memory_order_acquire) && entry.contended.load() > 0) entries.emplace_back(&entry);
+        }
+        std::sort(entries.begin(), entries.end(), [](auto *a, auto *b) {
+            return a->totalWait.load() > b->totalWait.load();
+        });
+        if (entries.size() > count) entries.resize(count);
+
+        std::vector<CallSiteStats> result;
+        for (auto *entry : entries) {
+            auto &stats = result.emplace_back();
+            stats.siteName = entry->site.load()->name;
+            for (size_t i = 0; i < CALL_SITE_DEPTH; i++) {
+                stats.frames[i] = Symbolize(entry->frames[i].load(std::memory_order_relaxed));
+            }
+            stats.contended = entry->contended.load();
+            stats.totalWait = chrono_clock::duration(entry->totalWait.load());
+        }
+        return result;
+    }
+
+    void ResetStats() {
+        {
+            std::lock_guard lock(getSitesMutex());
+            for (auto &site : getSites()) {
+                site.Reset();
+            }
+        }
+        for (auto &entry : callSites) {
+            entry.contended = 0;
+            entry.totalWait = 0;
+        }
+    }
+
+    void PlotStats() {
+#ifdef TRACY_ENABLE
+        std::lock_guard lock(getSitesMutex());
+        for (auto &site : getSites()) {
+            auto total = site.totalWait.load(std::memory_order_relaxed);
+            auto delta = chrono_clock::duration(total - site.lastPlottedWait);
+            site.lastPlottedWait = total;
+            if (site.acquires.load(std::memory_order_relaxed) == 0) continue;
+            TracyPlot(site.name.c_str(), std::chrono::duration_cast<std::chrono::microseconds>(delta).count() / 1000.0);
+        }
+#endif
+    }
+} // namespace sp::contention
@@ -13,8 +13,14 @@
 
 namespace sp {
     DispatchQueue::~DispatchQueue() {
-        dropPendingWork = true;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            dropPendingWork = true;
+        }
         Shutdown();
+
+        std::lock_guard lock(handle->mutex);
+        handle->queue = nullptr;
     }
 
     void DispatchQueue::Shutdown() {
@@ -23,11 +29,19 @@ namespace sp {
 #endif
         std::unique_lock<std::mutex> lock(mutex);
         exit = true;
-        workReady.notify_all();
-        lock.unlock();
+        // Wait for all queued work to complete, including items still waiting on their inputs.
+        while (activeJobs > 0 || (jobSystem && !dropPendingWork && waitingItems > 0)) {
+            stateChanged.wait(lock);
+        }
+        if (!dropPendingWork) return;
 
-        for (auto &thread : threads) {
-            if (thread.joinable()) thread.join();
+        // Queued coroutines are owned by their own frame, so they must be destroyed explicitly
+        auto dropped = std::move(workQueue);
+        workQueue = {};
+        lock.unlock();
+        while (!dropped.empty()) {
+            dropped.front()->Cancel();
+            dropped.pop();
         }
     }
 
@@ -36,42 +50,89 @@ namespace sp {
         ZoneScoped;
 #endif
         std::unique_lock<std::mutex> lock(mutex);
-        FlushInternal(lock, workQueue.size(), blockUntilReady);
+        if (!blockUntilReady) {
+            FlushInternal(lock, workQueue.size(), false);
+            return;
+        }
+
+        // Process every item queued so far, waiting for any inputs that haven't resolved yet.
+        size_t remaining = workQueue.size() + waitingItems;
+        while (remaining > 0) {
+            if (workQueue.empty()) {
+                if (waitingItems == 0) break;
+                stateChanged.wait(lock);
+                continue;
+            }
+            remaining -= std::min(remaining, FlushInternal(lock, std::min(remaining, workQueue.size()), true));
+        }
     }
 
-    void DispatchQueue::ThreadMain() {
-#ifdef TRACY_ENABLE
-        tracy::SetThreadName(name.c_str());
-#endif
+    void DispatchQueue::InputResolved(const std::shared_ptr<Handle> &handle,
+        std::shared_ptr<DispatchQueueWorkItemBase> item) {
+        if (--item->pendingInputs > 0) return;
+
+        std::lock_guard lock(handle->mutex);
+        if (handle->queue) handle->queue->EnqueueReady(std::move(item));
+    }
+
+    void DispatchQueue::EnqueueReady(std::shared_ptr<DispatchQueueWorkItemBase> &&item) {
         std::unique_lock<std::mutex> lock(mutex);
+        waitingItems--;
+        stateChanged.notify_all();
+        if (exit && dropPendingWork) {
+            lock.unlock();
+            item->Cancel();
+            return;
+        }
 
-        while (true) {
-            if (workQueue.empty()) {
-                if (exit) break;
-                workReady.wait(lock);
-            }
-            if (exit && dropPendingWork) break;
-            if (workQueue.empty()) continue;
+        workQueue.push(std::move(item));
+        if (jobSystem && activeJobs < maxConcurrency) {
+            activeJobs++;
+            lock.unlock();
+            SubmitJob(false);
+        }
+    }
 
-            {
-#ifdef TRACY_ENABLE
-                ZoneScopedN("ThreadFlush");
-#endif
-                size_t flushCount = workQueue.size();
+    void DispatchQueue::SubmitJob(bool pollDelay) {
+        if (pollDelay && flushSleepInterval.count() > 0) {
+            jobSystem->SubmitAfter(
+                flushSleepInterval,
+                [this] {
+                    RunJob();
+                },
+                priority,
+                this);
+        } else {
+            jobSystem->Submit(
+                [this] {
+                    RunJob();
+                },
+                priority,
+                this);
+        }
+    }
+
+    void DispatchQueue::RunJob() {
 #ifdef TRACY_ENABLE
-                ZoneValue(flushCount);
+        ZoneScopedN("DispatchQueue::RunJob");
+        ZoneText(name.c_str(), name.size());
 #endif
-                if (FlushInternal(lock, flushCount, false) == 0) {
-                    lock.unlock();
-                    if (flushSleepInterval.count() > 0) {
-                        std::this_thread::sleep_for(flushSleepInterval);
-                    } else {
-                        std::this_thread::yield();
-                    }
-                    lock.lock();
-                }
-            }
+        std::unique_lock<std::mutex> lock(mutex);
+        size_t flushCount = 0;
+        if (!exit || !dropPendingWork) {
+            // Only process the items queued so far, then yield the worker back to the JobSystem
+            flushCount = FlushInternal(lock, workQueue.size(), false);
         }
+
+        if (workQueue.empty() || (exit && dropPendingWork)) {
+            activeJobs--;
+            stateChanged.notify_all();
+            return;
+        }
+        lock.unlock();
+
+        // Items remain in the queue, poll again later if none of them were ready (only possible for std::future inputs)
+        SubmitJob(flushCount == 0);
     }
 
     size_t DispatchQueue::FlushInternal(std::unique_lock<std::mutex> &lock, size_t maxWorkItems, bool blockUntilReady) {
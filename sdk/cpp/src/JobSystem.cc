@@ -0,0 +1,209 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "strayphotons/JobSystem.hh"
+
+#include "strayphotons/Logging.hh"
+#include "strayphotons/ThreadAffinity.hh"
+
+#ifdef TRACY_ENABLE
+    #include "common/Tracing.hh"
+#endif
+
+#include <string>
+
+namespace sp {
+    thread_local JobSystem *currentJobSystem = nullptr;
+    thread_local size_t currentWorkerIndex = 0;
+
+    JobSystem &GetJobSystem() {
+        static JobSystem jobSystem;
+        return jobSystem;
+    }
+
+    bool HelpWhileWaiting(const void *producer) {
+        if (!currentJobSystem || !producer) return false;
+        if (!currentJobSystem->RunPendingJob(producer)) std::this_thread::yield();
+        return true;
+    }
+
+    JobSystem::JobSystem(size_t workerCount) {
+        if (workerCount == 0) workerCount = std::max(2u, std::thread::hardware_concurrency());
+        workers.resize(workerCount);
+        for (auto &worker : workers) {
+            worker = std::make_unique<Worker>();
+        }
+        for (size_t i = 0; i < workers.size(); i++) {
+            workers[i]->thread = std::thread(&JobSystem::WorkerMain, this, i);
+        }
+    }
+
+    JobSystem::~JobSystem() {
+        Shutdown();
+    }
+
+    void JobSystem::Shutdown() {
+        {
+            std::lock_guard lock(sleepMutex);
+            exit = true;
+            jobsReady.notify_all();
+        }
+
+        for (auto &worker : workers) {
+            if (worker->thread.joinable()) worker->thread.join();
+        }
+    }
+
+    int JobSystem::GetCurrentWorkerIndex() const {
+        if (currentJobSystem != this) return -1;
+        return (int)currentWorkerIndex;
+    }
+
+    void JobSystem::Submit(Job &&job, JobPriority priority, const void *owner) {
+        Assert(job, "JobSystem::Submit called with null job");
+        size_t workerIndex;
+        if (currentJobSystem == this) {
+            workerIndex = currentWorkerIndex;
+        } else {
+            workerIndex = nextWorker++ % workers.size();
+        }
+
+        pendingJobs++;
+        {
+            auto &worker = *workers[workerIndex];
+            std::lock_guard lock(worker.mutex);
+            worker.jobs[(size_t)priority].emplace_back(QueuedJob{std::move(job), owner});
+        }
+
+        std::lock_guard lock(sleepMutex);
+        jobsReady.notify_one();
+    }
+
+    void JobSystem::SubmitAfter(chrono_clock::duration delay, Job &&job, JobPriority priority, const void *owner) {
+        Assert(job, "JobSystem::SubmitAfter called with null job");
+        std::lock_guard lock(sleepMutex);
+        delayedJobs.push(
+            DelayedJob{chrono_clock::now() + delay, priority, owner, std::make_shared<Job>(std::move(job))});
+        jobsReady.notify_one();
+    }
+
+    bool JobSystem::RunPendingJob(const void *owner) {
+        if (currentJobSystem != this) return false;
+
+        Job job;
+        if (!TryPopOwnedJob(currentWorkerIndex, owner, job)) return false;
+        job();
+        return true;
+    }
+
+    bool JobSystem::TryPopJob(size_t workerIndex, Job &jobOut) {
+        if (pendingJobs == 0) return false;
+
+        for (size_t priority = 0; priority < JOB_PRIORITY_COUNT; priority++) {
+            {
+                // Take the oldest job from our own deque first
+                auto &worker = *workers[workerIndex];
+                std::lock_guard lock(worker.mutex);
+                auto &jobs = worker.jobs[priority];
+                if (!jobs.empty()) {
+                    jobOut = std::move(jobs.front().job);
+                    jobs.pop_front();
+                    pendingJobs--;
+                    return true;
+                }
+            }
+            for (size_t offset = 1; offset < workers.size(); offset++) {
+                // Steal the newest job from another worker
+                auto &victim = *workers[(workerIndex + offset) % workers.size()];
+                std::unique_lock lock(victim.mutex, std::try_to_lock);
+                if (!lock) continue;
+                auto &jobs = victim.jobs[priority];
+                if (!jobs.empty()) {
+                    jobOut = std::move(jobs.back().job);
+                    jobs.pop_back();
+                    pendingJobs--;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool JobSystem::TryPopOwnedJob(size_t workerIndex, const void *owner, Job &jobOut) {
+        if (pendingJobs == 0) return false;
+
+        for (size_t offset = 0; offset < workers.size(); offset++) {
+            auto &worker = *workers[(workerIndex + offset) % workers.size()];
+            std::unique_lock lock(worker.mutex, std::defer_lock);
+            if (offset == 0) {
+                lock.lock();
+            } else if (!lock.try_lock()) {
+                continue;
+            }
+            for (auto &jobs : worker.jobs) {
+                auto it = std::find_if(jobs.begin(), jobs.end(), [owner](auto &queued) {
+                    return queued.owner == owner;
+                });
+                if (it != jobs.end()) {
+                    jobOut = std::move(it->job);
+                    jobs.erase(it);
+                    pendingJobs--;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    void JobSystem::SubmitDelayedJobs() {
+        // sleepMutex must be held by caller
+        auto now = chrono_clock::now();
+        while (!delayedJobs.empty() && delayedJobs.top().readyTime <= now) {
+            auto delayed = delayedJobs.top();
+            delayedJobs.pop();
+
+            pendingJobs++;
+            auto &worker = *workers[nextWorker++ % workers.size()];
+            std::lock_guard lock(worker.mutex);
+            worker.jobs[(size_t)delayed.priority].emplace_back(QueuedJob{std::move(*delayed.job), delayed.owner});
+            jobsReady.notify_one();
+        }
+    }
+
+    void JobSystem::WorkerMain(size_t workerIndex) {
+        currentJobSystem = this;
+        currentWorkerIndex = workerIndex;
+        std::string threadName = "JobWorker" + std::to_string(workerIndex);
+#ifdef TRACY_ENABLE
+        tracy::SetThreadName(threadName.c_str());
+#endif
+
+        Job job;
+        while (true) {
+            UpdateThreadAffinity(threadName, true);
+            if (TryPopJob(workerIndex, job)) {
+#ifdef TRACY_ENABLE
+                ZoneScopedN("JobSystem::Job");
+#endif
+                job();
+                job = nullptr;
+                continue;
+            }
+
+            std::unique_lock lock(sleepMutex);
+            if (exit) break;
+            SubmitDelayedJobs();
+            if (pendingJobs > 0) continue;
+
+            if (delayedJobs.empty()) {
+                jobsReady.wait(lock);
+            } else {
+                jobsReady.wait_until(lock, delayedJobs.top().readyTime);
+            }
+        }
+    }
+} // namespace sp
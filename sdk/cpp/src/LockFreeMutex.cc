@@ -16,15 +16,27 @@ namespace sp {
     thread_local InlineVector<LockFreeMutex *, 16> lockedVectors;
 
     void LockFreeMutex::lock_shared() {
+#ifdef SP_CONTENTION_PROFILING
+        contentionSite->RecordAcquire();
+        if (try_lock_shared()) return;
+        auto waitStart = chrono_clock::now();
+        size_t spins = 0;
+#endif
         size_t retry = 0;
         while (true) {
-            if (try_lock_shared()) return;
+            if (try_lock_shared()) break;
+#ifdef SP_CONTENTION_PROFILING
+            spins++;
+#endif
 
             if (retry++ > SPINLOCK_RETRY_YIELD) {
                 retry = 0;
                 std::this_thread::yield();
             }
         }
+#ifdef SP_CONTENTION_PROFILING
+        contentionSite->RecordWait(spins, chrono_clock::now() - waitStart);
+#endif
     }
 
     bool LockFreeMutex::try_lock_shared() {
@@ -56,10 +68,18 @@ namespace sp {
     }
 
     void LockFreeMutex::lock() {
+#ifdef SP_CONTENTION_PROFILING
+        contentionSite->RecordAcquire();
+        auto waitStart = chrono_clock::now();
+        size_t spins = 0;
+#endif
         size_t retry = 0;
         while (true) {
             bool current = exclusiveWaiting;
             if (!current && exclusiveWaiting.compare_exchange_weak(current, true)) break;
+#ifdef SP_CONTENTION_PROFILING
+            spins++;
+#endif
 
             if (retry++ > SPINLOCK_RETRY_YIELD) {
                 retry = 0;
@@ -68,6 +88,9 @@ namespace sp {
         }
         while (true) {
             if (try_lock()) break;
+#ifdef SP_CONTENTION_PROFILING
+            spins++;
+#endif
 
             if (retry++ > SPINLOCK_RETRY_YIELD) {
                 retry = 0;
@@ -78,6 +101,9 @@ namespace sp {
         Assert(current, "LockFreeMutex::lock() exclusiveWaiting changed unexpectedly");
         bool success = exclusiveWaiting.compare_exchange_strong(current, false);
         Assert(success, "LockFreeMutex::lock() exclusiveWaiting change failed");
+#ifdef SP_CONTENTION_PROFILING
+        if (spins > 0) contentionSite->RecordWait(spins, chrono_clock::now() - waitStart);
+#endif
     }
 
     bool LockFreeMutex::try_lock() {
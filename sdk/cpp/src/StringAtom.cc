@@ -0,0 +1,180 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "strayphotons/StringAtom.hh"
+
+#include "strayphotons/Logging.hh"
+
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace sp {
+    namespace {
+        static const size_t ENTRY_CHUNK_SIZE = 4096;
+        static const size_t MAX_ENTRY_CHUNKS = 4096;
+        static const size_t STRING_BLOCK_SIZE = 64 * 1024;
+        static const size_t INITIAL_TABLE_SIZE = 4096;
+
+        struct AtomEntry {
+            const char *data = "";
+            uint32_t length = 0;
+        };
+
+        // Open addressing table of (hash << 32 | id) slots, 0 marks an empty slot
+        struct AtomTable {
+            AtomTable(size_t size) : mask(size - 1), slots(new std::atomic_uint64_t[size]) {
+                for (size_t i = 0; i < size; i++) {
+                    slots[i].store(0, std::memory_order_relaxed);
+                }
+            }
+
+            const size_t mask;
+            std::unique_ptr<std::atomic_uint64_t[]> slots;
+        };
+
+        struct AtomInterner {
+            // Entries are stored in fixed chunks so existing entries never move once published
+            std::array<std::atomic<AtomEntry *>, MAX_ENTRY_CHUNKS> chunks = {};
+            std::atomic<AtomTable *> table;
+
+            // Only held while inserting new strings
+            std::mutex insertMutex;
+            uint32_t count = 0;
+            char *blockHead = nullptr;
+            size_t blockRemaining = 0;
+            // Replaced tables may still be read by concurrent lookups, so they are retained instead of freed
+            std::vector<std::unique_ptr<AtomTable>> tables;
+
+            AtomInterner() {
+                tables.emplace_back(std::make_unique<AtomTable>(INITIAL_TABLE_SIZE));
+                table = tables.back().get();
+            }
+
+            const AtomEntry &GetEntry(uint32_t id) const {
+                auto *chunk = chunks[id / ENTRY_CHUNK_SIZE].load(std::memory_order_acquire);
+                return chunk[id % ENTRY_CHUNK_SIZE];
+            }
+
+            uint32_t Lookup(const AtomTable &t, std::string_view str, uint32_t hash) const {
+                for (size_t i = hash & t.mask;; i = (i + 1) & t.mask) {
+                    uint64_t slot = t.slots[i].load(std::memory_order_acquire);
+                    if (slot == 0) return 0;
+                    if ((uint32_t)(slot >> 32) != hash) continue;
+
+                    uint32_t id = (uint32_t)slot;
+                    auto &entry = GetEntry(id);
+                    if (std::string_view(entry.data, entry.length) == str) return id;
+                }
+            }
+
+            void InsertSlot(AtomTable &t, uint32_t hash, uint32_t id) {
+                size_t i = hash & t.mask;
+                while (t.slots[i].load(std::memory_order_relaxed) != 0) {
+                    i = (i + 1) & t.mask;
+                }
+                t.slots[i].store((uint64_t)hash << 32 | id, std::memory_order_release);
+            }
+
+            const char *StoreString(std::string_view str) {
+                size_t size = str.size() + 1;
+                char *dst;
+                if (size > STRING_BLOCK_SIZE / 4) {
+                    dst = new char[size];
+                } else {
+                    if (size > blockRemaining) {
+                        blockHead = new char[STRING_BLOCK_SIZE];
+                        blockRemaining = STRING_BLOCK_SIZE;
+                    }
+                    dst = blockHead;
+                    blockHead += size;
+                    blockRemaining -= size;
+                }
+                std::memcpy(dst, str.data(), str.size());
+                dst[str.size()] = '\0';
+                return dst;
+            }
+
+            uint32_t Insert(std::string_view str, uint32_t hash) {
+                std::lock_guard lock(insertMutex);
+                auto *t = table.load(std::memory_order_relaxed);
+                uint32_t id = Lookup(*t, str, hash);
+                if (id != 0) return id;
+
+                id = ++count;
+                Assertf(id / ENTRY_CHUNK_SIZE < MAX_ENTRY_CHUNKS, "StringAtom table full: %u strings", id);
+                auto *chunk = chunks[id / ENTRY_CHUNK_SIZE].load(std::memory_order_relaxed);
+                if (!chunk) {
+                    chunk = new AtomEntry[ENTRY_CHUNK_SIZE];
+                    chunks[id / ENTRY_CHUNK_SIZE].store(chunk, std::memory_order_release);
+                }
+                chunk[id % ENTRY_CHUNK_SIZE] = AtomEntry{StoreString(str), (uint32_t)str.size()};
+
+                // Keep the table at most half full so probe sequences stay short
+                if ((size_t)count * 2 > t->mask + 1) {
+                    auto &newTable = tables.emplace_back(std::make_unique<AtomTable>((t->mask + 1) * 2));
+                    for (size_t i = 0; i <= t->mask; i++) {
+                        uint64_t slot = t->slots[i].load(std::memory_order_relaxed);
+                        if (slot != 0) InsertSlot(*newTable, (uint32_t)(slot >> 32), (uint32_t)slot);
+                    }
+                    t = newTable.get();
+                    InsertSlot(*t, hash, id);
+                    table.store(t, std::memory_order_release);
+                } else {
+                    InsertSlot(*t, hash, id);
+                }
+                return id;
+            }
+        };
+
+        // Atoms may be created during static initialization and used during static destruction,
+        // so the interner is intentionally never destroyed.
+        AtomInterner &getInterner() {
+            static AtomInterner *interner = new AtomInterner();
+            return *interner;
+        }
+
+        // Slots are never 0 even if the hash is, since atom ids start at 1
+        uint32_t HashString(std::string_view str) {
+            return (uint32_t)std::hash<std::string_view>()(str);
+        }
+    } // namespace
+
+    uint32_t StringAtom::Intern(std::string_view str) {
+        if (str.empty()) return 0;
+        auto &interner = getInterner();
+        uint32_t hash = HashString(str);
+        uint32_t id = interner.Lookup(*interner.table.load(std::memory_order_acquire), str, hash);
+        if (id != 0) return id;
+        return interner.Insert(str, hash);
+    }
+
+    std::optional<StringAtom> StringAtom::Find(std::string_view str) {
+        if (str.empty()) return StringAtom();
+        auto &interner = getInterner();
+        uint32_t id = interner.Lookup(*interner.table.load(std::memory_order_acquire), str, HashString(str));
+        if (id == 0) return {};
+        StringAtom atom;
+        atom.id = id;
+        return atom;
+    }
+
+    size_t StringAtom::InternedCount() {
+        auto &interner = getInterner();
+        std::lock_guard lock(interner.insertMutex);
+        return interner.count;
+    }
+
+    std::string_view StringAtom::View() const {
+        if (id == 0) return "";
+        auto &entry = getInterner().GetEntry(id);
+        return std::string_view(entry.data, entry.length);
+    }
+} // namespace sp
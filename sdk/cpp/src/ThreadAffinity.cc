@@ -0,0 +1,269 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "strayphotons/ThreadAffinity.hh"
+
+#include "strayphotons/Logging.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#elif defined(__linux__)
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+namespace sp {
+    namespace {
+        std::mutex policyMutex;
+        std::shared_ptr<const ThreadAffinityPolicy> activePolicy;
+        std::atomic_uint32_t policyGeneration = 0;
+        thread_local uint32_t appliedGeneration = 0;
+
+        // Parses a list of core ids and ranges, e.g. "0-3+8"
+        bool ParseCoreList(std::string_view str, char separator, std::vector<uint32_t> &out) {
+            while (!str.empty()) {
+                auto end = str.find(separator);
+                auto item = str.substr(0, end);
+                str = end == std::string_view::npos ? std::string_view() : str.substr(end + 1);
+                if (item.empty()) continue;
+
+                uint32_t first = 0, last = 0;
+                auto dash = item.find('-');
+                auto firstStr = item.substr(0, dash);
+                auto result = std::from_chars(firstStr.data(), firstStr.data() + firstStr.size(), first);
+                if (result.ec != std::errc() || result.ptr != firstStr.data() + firstStr.size()) return false;
+                last = first;
+                if (dash != std::string_view::npos) {
+                    auto lastStr = item.substr(dash + 1);
+                    result = std::from_chars(lastStr.data(), lastStr.data() + lastStr.size(), last);
+                    if (result.ec != std::errc() || result.ptr != lastStr.data() + lastStr.size()) return false;
+                    if (last < first) return false;
+                }
+                for (uint32_t core = first; core <= last; core++) {
+                    out.emplace_back(core);
+                }
+            }
+            std::sort(out.begin(), out.end());
+            out.erase(std::unique(out.begin(), out.end()), out.end());
+            return true;
+        }
+
+        std::string FormatCoreList(const std::vector<uint32_t> &cores) {
+            if (cores.empty()) return "any";
+            std::string out;
+            for (size_t i = 0; i < cores.size(); i++) {
+                size_t end = i;
+                while (end + 1 < cores.size() && cores[end + 1] == cores[end] + 1) {
+                    end++;
+                }
+                if (!out.empty()) out += ",";
+                out += std::to_string(cores[i]);
+                if (end > i) out += "-" + std::to_string(cores[end]);
+                i = end;
+            }
+            return out;
+        }
+
+        std::vector<uint32_t> AllCores() {
+            std::vector<uint32_t> cores(GetCoreCount());
+            for (size_t i = 0; i < cores.size(); i++) {
+                cores[i] = (uint32_t)i;
+            }
+            return cores;
+        }
+
+#ifdef __linux__
+        bool ReadNumaNodeCores(int node, std::vector<uint32_t> &out) {
+            std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+            std::string cpulist;
+            if (!file || !std::getline(file, cpulist)) return false;
+            return ParseCoreList(cpulist, ',', out);
+        }
+#endif
+
+        bool SetCurrentThreadCores(const std::vector<uint32_t> &cores) {
+#ifdef _WIN32
+            DWORD_PTR mask = 0;
+            for (auto core : cores) {
+                if (core < sizeof(mask) * 8) mask |= (DWORD_PTR)1 << core;
+            }
+            return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#elif defined(__linux__)
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (auto core : cores) {
+                if (core < CPU_SETSIZE) CPU_SET(core, &set);
+            }
+            return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+            // Thread affinity is only a scheduling hint on this platform and isn't supported
+            (void)cores;
+            return false;
+#endif
+        }
+    } // namespace
+
+    size_t GetCoreCount() {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    std::shared_ptr<ThreadAffinityPolicy> ThreadAffinityPolicy::Parse(std::string_view spec) {
+        auto policy = std::make_shared<ThreadAffinityPolicy>();
+        policy->spec = spec;
+
+        while (!spec.empty()) {
+            auto end = spec.find(',');
+            auto entry = spec.substr(0, end);
+            spec = end == std::string_view::npos ? std::string_view() : spec.substr(end + 1);
+            if (entry.empty()) continue;
+
+            auto equals = entry.find('=');
+            if (equals == std::string_view::npos) {
+                Errorf("Invalid thread affinity entry, expected name=cores: %s", std::string(entry));
+                return nullptr;
+            }
+            auto key = entry.substr(0, equals);
+            auto value = entry.substr(equals + 1);
+
+            if (key == "numa") {
+#ifdef __linux__
+                int node = -1;
+                if (value == "auto") {
+                    int cpu = sched_getcpu();
+                    for (int i = 0; cpu >= 0; i++) {
+                        std::vector<uint32_t> cores;
+                        if (!ReadNumaNodeCores(i, cores)) break;
+                        if (std::binary_search(cores.begin(), cores.end(), (uint32_t)cpu)) {
+                            node = i;
+                            break;
+                        }
+                    }
+                } else {
+                    auto result = std::from_chars(value.data(), value.data() + value.size(), node);
+                    if (result.ec != std::errc()) node = -1;
+                }
+                if (node < 0 || !ReadNumaNodeCores(node, policy->numaCores)) {
+                    Warnf("Unable to read NUMA node %s, ignoring numa affinity", std::string(value));
+                    policy->numaCores.clear();
+                } else {
+                    policy->numaNode = node;
+                }
+#else
+                Warnf("NUMA thread affinity is not supported on this platform");
+#endif
+                continue;
+            }
+
+            std::vector<uint32_t> cores;
+            if (!ParseCoreList(value, '+', cores) || cores.empty()) {
+                Errorf("Invalid thread affinity core list: %s", std::string(entry));
+                return nullptr;
+            }
+            if (key == "reserve") {
+                policy->reservedCores = cores;
+            } else if (key == "workers") {
+                policy->workerCores = cores;
+            } else {
+                policy->pinnedThreads[std::string(key)] = cores;
+            }
+        }
+        if ((!policy->workerCores.empty() || !policy->numaCores.empty()) && policy->GetWorkerCores().empty()) {
+            Warnf("Thread affinity leaves no cores for JobSystem workers, workers will not be pinned");
+        }
+        return policy;
+    }
+
+    std::vector<uint32_t> ThreadAffinityPolicy::GetUnreservedCores(std::vector<uint32_t> cores) const {
+        if (reservedCores.empty()) return cores;
+        std::erase_if(cores, [&](uint32_t core) {
+            return std::binary_search(reservedCores.begin(), reservedCores.end(), core);
+        });
+        return cores;
+    }
+
+    std::vector<uint32_t> ThreadAffinityPolicy::GetThreadCores(std::string_view threadName) const {
+        auto it = pinnedThreads.find(threadName);
+        if (it != pinnedThreads.end()) return it->second;
+        if (reservedCores.empty()) return {};
+        return GetUnreservedCores(AllCores());
+    }
+
+    std::vector<uint32_t> ThreadAffinityPolicy::GetWorkerCores() const {
+        std::vector<uint32_t> cores = workerCores;
+        if (!numaCores.empty()) {
+            if (cores.empty()) {
+                cores = numaCores;
+            } else {
+                std::erase_if(cores, [&](uint32_t core) {
+                    return !std::binary_search(numaCores.begin(), numaCores.end(), core);
+                });
+            }
+        }
+        if (cores.empty() && reservedCores.empty()) return {};
+        if (cores.empty()) cores = AllCores();
+        return GetUnreservedCores(cores);
+    }
+
+    std::string ThreadAffinityPolicy::Describe() const {
+        std::string out;
+        for (auto &[name, cores] : pinnedThreads) {
+            out += name + "=[" + FormatCoreList(cores) + "] ";
+        }
+        out += "workers=[" + FormatCoreList(GetWorkerCores()) + "]";
+        if (numaNode >= 0) out += " (NUMA node " + std::to_string(numaNode) + ")";
+        if (!reservedCores.empty()) {
+            out += " other=[" + FormatCoreList(GetUnreservedCores(AllCores())) + "]";
+            out += " reserved=[" + FormatCoreList(reservedCores) + "]";
+        }
+        return out;
+    }
+
+    bool SetThreadAffinityPolicy(std::string_view spec) {
+        std::lock_guard lock(policyMutex);
+        if (activePolicy && activePolicy->spec == spec) return true;
+        if (!activePolicy && spec.empty()) return true;
+
+        auto policy = ThreadAffinityPolicy::Parse(spec);
+        if (!policy) return false;
+
+        Logf("Thread affinity (%u cores): %s", GetCoreCount(), policy->Describe());
+        activePolicy = policy;
+        policyGeneration++;
+        return true;
+    }
+
+    std::shared_ptr<const ThreadAffinityPolicy> GetThreadAffinityPolicy() {
+        std::lock_guard lock(policyMutex);
+        return activePolicy;
+    }
+
+    void UpdateThreadAffinity(std::string_view threadName, bool isWorker) {
+        uint32_t generation = policyGeneration.load(std::memory_order_relaxed);
+        if (generation == appliedGeneration) return;
+        appliedGeneration = generation;
+
+        auto policy = GetThreadAffinityPolicy();
+        if (!policy) return;
+
+        auto cores = isWorker ? policy->GetWorkerCores() : policy->GetThreadCores(threadName);
+        // An empty core list resets the thread to run anywhere, in case it was previously pinned
+        if (cores.empty()) cores = AllCores();
+        if (!SetCurrentThreadCores(cores)) {
+            Warnf("Failed to set thread affinity for %s to cores %s", std::string(threadName), FormatCoreList(cores));
+        } else {
+            Debugf("Thread %s affinity set to cores %s", std::string(threadName), FormatCoreList(cores));
+        }
+    }
+} // namespace sp
@@ -37,7 +37,7 @@ namespace sp {
 
     AudioManager::AudioManager()
         : RegisteredThread("AudioManager", std::chrono::milliseconds(20), false), sampleRate(48000),
-          decoderQueue("AudioDecode") {
+          decoderQueue("AudioDecode", 1, std::chrono::milliseconds(5), JobPriority::High) {
 
         framesPerBuffer = std::min(vraudio::kMaxSupportedNumFrames,
             CeilToPowerOfTwo((size_t)(sampleRate * interval.count() / 1e9)));
@@ -15,6 +15,7 @@
 #include "strayphotons/Async.hh"
 #include "strayphotons/DispatchQueue.hh"
 #include "strayphotons/EntityMap.hh"
+#include "strayphotons/InlineVector.hh"
 #include "strayphotons/LockFreeEventQueue.hh"
 
 #include <vector>
@@ -0,0 +1,28 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "ArenaAllocator.hh"
+
+namespace sp {
+    ArenaAllocator::ArenaAllocator(size_t initialBlockSize)
+        : heap(std::pmr::new_delete_resource(), stats.blocks, stats.reservedBytes),
+          arena(initialBlockSize, &heap), counter(&arena, stats.allocations, stats.allocatedBytes) {}
+
+    void *ArenaAllocator::CountingResource::do_allocate(size_t size, size_t alignment) {
+        count++;
+        bytes += size;
+        return upstream->allocate(size, alignment);
+    }
+
+    void ArenaAllocator::CountingResource::do_deallocate(void *ptr, size_t size, size_t alignment) {
+        upstream->deallocate(ptr, size, alignment);
+    }
+
+    bool ArenaAllocator::CountingResource::do_is_equal(const std::pmr::memory_resource &other) const noexcept {
+        return this == &other;
+    }
+} // namespace sp
@@ -0,0 +1,65 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "strayphotons/Utility.hh"
+
+#include <cstddef>
+#include <memory_resource>
+
+/**
+ * Monotonic arena for short-lived allocations, such as the entity lists built while loading or applying a scene.
+ *
+ * Allocations are carved out of large blocks and only released when the arena is destroyed, so the arena should only
+ * back containers that are discarded together. Containers opt in through std::pmr allocators, and only the container
+ * itself is placed in the arena: heap types stored inside its elements, such as component data, still use their own
+ * allocators. An arena is not thread-safe, and should only be used by the thread that owns it.
+ */
+namespace sp {
+    struct ArenaStats {
+        size_t allocations = 0;
+        size_t allocatedBytes = 0;
+        // Bytes requested from the global heap, including unused space at the end of each block
+        size_t reservedBytes = 0;
+        size_t blocks = 0;
+    };
+
+    class ArenaAllocator : public NonMoveable {
+    public:
+        ArenaAllocator(size_t initialBlockSize = 64 * 1024);
+
+        std::pmr::memory_resource *Resource() {
+            return &counter;
+        }
+
+        const ArenaStats &Stats() const {
+            return stats;
+        }
+
+    private:
+        // Counts allocations made by a resource, and forwards them upstream
+        class CountingResource : public std::pmr::memory_resource {
+        public:
+            CountingResource(std::pmr::memory_resource *upstream, size_t &count, size_t &bytes)
+                : upstream(upstream), count(count), bytes(bytes) {}
+
+        private:
+            void *do_allocate(size_t size, size_t alignment) override;
+            void do_deallocate(void *ptr, size_t size, size_t alignment) override;
+            bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+            std::pmr::memory_resource *upstream;
+            size_t &count, &bytes;
+        };
+
+        ArenaStats stats;
+        CountingResource heap;
+        std::pmr::monotonic_buffer_resource arena;
+        CountingResource counter;
+    };
+} // namespace sp
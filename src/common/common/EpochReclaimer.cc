@@ -0,0 +1,136 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "EpochReclaimer.hh"
+
+#include "strayphotons/Logging.hh"
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace sp::epoch {
+    namespace {
+        static const size_t MAX_READER_THREADS = 256;
+        // Retire() reclaims inline once this many objects are waiting
+        static const size_t RECLAIM_THRESHOLD = 1024;
+
+        struct alignas(64) ReaderSlot {
+            std::atomic_bool claimed = false;
+            // The epoch this thread's outermost guard was entered in, or 0 if no guard is held
+            std::atomic_uint64_t epoch = 0;
+        };
+
+        struct RetiredObject {
+            uint64_t epoch;
+            std::function<void()> freeFunc;
+        };
+
+        struct EpochState {
+            std::atomic_uint64_t globalEpoch = 1;
+            std::array<ReaderSlot, MAX_READER_THREADS> readers;
+
+            std::mutex retiredMutex;
+            // Sorted by retire epoch
+            std::deque<RetiredObject> retired;
+        };
+
+        // Readers may still hold guards during static destruction, so the state is intentionally never destroyed
+        EpochState &getState() {
+            static EpochState *state = new EpochState();
+            return *state;
+        }
+
+        struct ThreadReader {
+            ReaderSlot *slot = nullptr;
+            uint32_t depth = 0;
+
+            ~ThreadReader() {
+                if (slot) slot->claimed.store(false, std::memory_order_release);
+            }
+
+            ReaderSlot &GetSlot() {
+                if (slot) return *slot;
+                for (auto &reader : getState().readers) {
+                    bool claimed = false;
+                    if (reader.claimed.compare_exchange_strong(claimed, true)) {
+                        slot = &reader;
+                        return *slot;
+                    }
+                }
+                Abortf("Too many threads reading epoch protected data: %u", MAX_READER_THREADS);
+            }
+        };
+
+        thread_local ThreadReader threadReader;
+    } // namespace
+
+    EpochGuard::EpochGuard() {
+        auto &reader = threadReader;
+        if (reader.depth++ > 0) return;
+
+        auto &slot = reader.GetSlot();
+        slot.epoch.store(getState().globalEpoch.load(), std::memory_order_relaxed);
+        // Orders the announcement before any pointer loads, pairs with the fence in Reclaim()
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    EpochGuard::~EpochGuard() {
+        auto &reader = threadReader;
+        if (--reader.depth > 0) return;
+        reader.slot->epoch.store(0, std::memory_order_release);
+    }
+
+    void Retire(std::function<void()> &&freeFunc) {
+        auto &state = getState();
+        // Orders the caller's unlink before reading the epoch
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        size_t pending;
+        {
+            std::lock_guard lock(state.retiredMutex);
+            state.retired.push_back({state.globalEpoch.load(), std::move(freeFunc)});
+            pending = state.retired.size();
+        }
+        if (pending >= RECLAIM_THRESHOLD) Reclaim();
+    }
+
+    size_t Reclaim() {
+        auto &state = getState();
+        std::vector<std::function<void()>> freeList;
+        {
+            std::lock_guard lock(state.retiredMutex);
+            if (state.retired.empty()) return 0;
+
+            uint64_t minEpoch = state.globalEpoch.fetch_add(1) + 1;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            for (auto &reader : state.readers) {
+                uint64_t epoch = reader.epoch.load(std::memory_order_acquire);
+                if (epoch != 0 && epoch < minEpoch) minEpoch = epoch;
+            }
+
+            // An object retired in epoch N was unlinked before any reader could observe epoch N + 1,
+            // so it is only reachable by guards entered in epoch N or earlier.
+            while (!state.retired.empty() && state.retired.front().epoch < minEpoch) {
+                freeList.emplace_back(std::move(state.retired.front().freeFunc));
+                state.retired.pop_front();
+            }
+        }
+        for (auto &freeFunc : freeList) {
+            freeFunc();
+        }
+        return freeList.size();
+    }
+
+    size_t PendingCount() {
+        auto &state = getState();
+        std::lock_guard lock(state.retiredMutex);
+        return state.retired.size();
+    }
+} // namespace sp::epoch
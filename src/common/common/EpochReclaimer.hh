@@ -0,0 +1,47 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "strayphotons/Utility.hh"
+
+#include <cstdint>
+#include <functional>
+
+/**
+ * Epoch-based memory reclamation for lock-free readers of shared data structures.
+ *
+ * Readers hold an EpochGuard while they dereference pointers loaded from a shared structure. Writers unlink objects
+ * under their own lock, then Retire() them instead of freeing them directly. Retired objects are freed by Reclaim()
+ * once every guard that was active when they were retired has been released.
+ *
+ * Entering and leaving a guard are a pair of atomic stores, so readers never wait on writers.
+ * Guards may be nested on the same thread.
+ */
+namespace sp::epoch {
+    class EpochGuard : public NonCopyable {
+    public:
+        EpochGuard();
+        ~EpochGuard();
+    };
+
+    // Must be called after ptr has been unlinked, so no new readers can find it
+    void Retire(std::function<void()> &&freeFunc);
+
+    template<typename T>
+    void Retire(T *ptr) {
+        Retire([ptr] {
+            delete ptr;
+        });
+    }
+
+    // Frees retired objects that are no longer visible to any reader, returns the number of objects freed
+    size_t Reclaim();
+
+    // Number of retired objects waiting to be freed
+    size_t PendingCount();
+} // namespace sp::epoch
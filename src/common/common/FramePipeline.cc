@@ -0,0 +1,179 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "FramePipeline.hh"
+
+#include "common/Tracing.hh"
+#include "strayphotons/Logging.hh"
+
+#include <algorithm>
+
+namespace sp {
+    // A neighbouring phase that hasn't made progress within a few of its frame intervals is assumed to be paused or
+    // stalled. The timeout is clamped so phases with no measured interval yet still make progress.
+    static const int PHASE_WAIT_INTERVALS = 4;
+    static const auto PHASE_WAIT_TIMEOUT_MIN = std::chrono::milliseconds(10);
+    static const auto PHASE_WAIT_TIMEOUT_MAX = std::chrono::milliseconds(100);
+
+    static const std::array<const char *, FRAME_PHASE_COUNT> phaseNames = {"Logic", "Physics", "Render"};
+    static const std::array<const char *, FRAME_PHASE_COUNT> phaseWaitPlotNames = {
+        "FramePipeline Logic Wait (ms)",
+        "FramePipeline Physics Wait (ms)",
+        "FramePipeline Render Wait (ms)",
+    };
+    static const std::array<const char *, FRAME_PHASE_COUNT> phaseFramePlotNames = {
+        "FramePipeline Logic Frame (ms)",
+        "FramePipeline Physics Frame (ms)",
+        "FramePipeline Render Frame (ms)",
+    };
+
+    FramePipeline &GetFramePipeline() {
+        static FramePipeline pipeline;
+        return pipeline;
+    }
+
+    void FramePipeline::SetEnabled(bool enabled) {
+        if (this->enabled == enabled) return;
+        std::lock_guard lock(mutex);
+        this->enabled = enabled;
+        phaseChanged.notify_all();
+    }
+
+    void FramePipeline::SetPhaseActive(FramePhase phase, bool active) {
+        std::lock_guard lock(mutex);
+        auto &state = phases[(size_t)phase];
+        state.active = active;
+        state.stalled = false;
+        state.frameStart = {};
+        state.frameInterval = {};
+        state.windowStart = chrono_clock::now();
+        phaseChanged.notify_all();
+    }
+
+    std::optional<size_t> FramePipeline::BlockingPhase(size_t phase) const {
+        // mutex must be held by caller
+        auto &state = phases[phase];
+        uint64_t nextFrame = state.completedFrame + 1;
+        if (phase > 0 && phases[phase - 1].active) {
+            // Wait for the upstream phase to produce a new frame
+            nextFrame = phases[phase - 1].completedFrame;
+            if (nextFrame <= state.completedFrame) return phase - 1;
+        }
+        if (phase + 1 < FRAME_PHASE_COUNT && phases[phase + 1].active && !phases[phase + 1].stalled) {
+            // Don't get more than one frame ahead of the downstream phase, unless it has stopped making progress
+            if (phases[phase + 1].startedFrame + 1 < nextFrame) return phase + 1;
+        }
+        return {};
+    }
+
+    chrono_clock::duration FramePipeline::WaitTimeout(size_t phase) const {
+        // mutex must be held by caller
+        chrono_clock::duration interval = {};
+        if (phase > 0 && phases[phase - 1].active) {
+            interval = std::max(interval, phases[phase - 1].frameInterval);
+        }
+        if (phase + 1 < FRAME_PHASE_COUNT && phases[phase + 1].active) {
+            interval = std::max(interval, phases[phase + 1].frameInterval);
+        }
+        if (interval == chrono_clock::duration::zero()) return PHASE_WAIT_TIMEOUT_MAX;
+        return std::clamp<chrono_clock::duration>(interval * PHASE_WAIT_INTERVALS,
+            PHASE_WAIT_TIMEOUT_MIN,
+            PHASE_WAIT_TIMEOUT_MAX);
+    }
+
+    void FramePipeline::BeginPhase(FramePhase phase) {
+        ZoneScoped;
+        auto index = (size_t)phase;
+        std::unique_lock lock(mutex);
+        auto &state = phases[index];
+
+        auto waitStart = chrono_clock::now();
+        bool ready = phaseChanged.wait_until(lock, waitStart + WaitTimeout(index), [&] {
+            return !enabled || !BlockingPhase(index);
+        });
+        if (!ready) {
+            state.timeoutCount++;
+            auto blocking = BlockingPhase(index);
+            if (blocking && *blocking > index) {
+                // Stop waiting on the downstream phase every frame until it completes another one
+                phases[*blocking].stalled = true;
+                Warnf("FramePipeline: %s phase stalled, %s phase will run ahead until it resumes",
+                    phaseNames[*blocking],
+                    phaseNames[index]);
+            }
+        }
+
+        auto frameStart = chrono_clock::now();
+        if (state.frameStart != chrono_clock::time_point()) {
+            auto interval = frameStart - state.frameStart;
+            if (state.frameInterval == chrono_clock::duration::zero()) {
+                state.frameInterval = interval;
+            } else {
+                state.frameInterval = (state.frameInterval * 7 + interval) / 8;
+            }
+        }
+        state.frameStart = frameStart;
+
+        auto waitTime = state.frameStart - waitStart;
+        state.totalWaitTime += waitTime;
+        state.maxWaitTime = std::max(state.maxWaitTime, waitTime);
+        TracyPlot(phaseWaitPlotNames[index],
+            std::chrono::duration_cast<std::chrono::microseconds>(waitTime).count() / 1000.0);
+
+        if (index > 0 && phases[index - 1].active) {
+            // Always process the most recent upstream frame, even if the wait timed out
+            state.startedFrame = phases[index - 1].completedFrame;
+        } else {
+            state.startedFrame = state.completedFrame + 1;
+        }
+        phaseChanged.notify_all();
+    }
+
+    void FramePipeline::EndPhase(FramePhase phase) {
+        auto index = (size_t)phase;
+        std::lock_guard lock(mutex);
+        auto &state = phases[index];
+
+        auto now = chrono_clock::now();
+        auto frameTime = now - state.frameStart;
+        state.totalFrameTime += frameTime;
+        state.frameCount++;
+        state.completedFrame = state.startedFrame;
+        if (state.stalled) {
+            state.stalled = false;
+            Logf("FramePipeline: %s phase resumed", phaseNames[index]);
+        }
+        TracyPlot(phaseFramePlotNames[index],
+            std::chrono::duration_cast<std::chrono::microseconds>(frameTime).count() / 1000.0);
+
+        if (now - state.windowStart >= std::chrono::seconds(1)) {
+            state.measured.framesPerSecond = state.frameCount;
+            state.measured.averageFrameTime = state.totalFrameTime / state.frameCount;
+            state.measured.averageWaitTime = state.totalWaitTime / state.frameCount;
+            state.measured.maxWaitTime = state.maxWaitTime;
+            state.measured.timeouts = state.timeoutCount;
+            state.frameCount = 0;
+            state.timeoutCount = 0;
+            state.totalFrameTime = {};
+            state.totalWaitTime = {};
+            state.maxWaitTime = {};
+            state.windowStart = now;
+        }
+        state.measured.lastFrame = state.completedFrame;
+        phaseChanged.notify_all();
+    }
+
+    FramePipelineStats FramePipeline::GetStats() const {
+        std::lock_guard lock(mutex);
+        FramePipelineStats stats;
+        stats.enabled = enabled;
+        for (size_t i = 0; i < FRAME_PHASE_COUNT; i++) {
+            stats.phases[i] = phases[i].measured;
+        }
+        return stats;
+    }
+} // namespace sp
@@ -0,0 +1,102 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "strayphotons/Utility.hh"
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+
+namespace sp {
+    enum class FramePhase : uint8_t {
+        Logic = 0,
+        Physics,
+        Render,
+    };
+    static const size_t FRAME_PHASE_COUNT = 3;
+
+    // Per-phase timing measured over the last second of pipelined execution
+    struct FramePhaseStats {
+        // Logic frame id most recently completed by this phase
+        uint64_t lastFrame = 0;
+        uint32_t framesPerSecond = 0;
+        // Average time spent running a frame, and waiting at the phase barrier before it
+        chrono_clock::duration averageFrameTime = {};
+        chrono_clock::duration averageWaitTime = {};
+        chrono_clock::duration maxWaitTime = {};
+        // Number of barrier waits that gave up because a neighbouring phase stopped making progress
+        uint32_t timeouts = 0;
+    };
+
+    struct FramePipelineStats {
+        bool enabled = false;
+        std::array<FramePhaseStats, FRAME_PHASE_COUNT> phases;
+    };
+
+    /**
+     * Explicit barriers between the Logic -> Physics -> Render frame phases.
+     *
+     * When enabled, logic frame N+1 may overlap physics frame N and render frame N-1, but no phase may start a frame
+     * until the phase before it has produced a new one, and no phase may run more than one frame ahead of the phase
+     * after it. Downstream phases always pick up the most recently completed upstream frame, so phases that start late
+     * or are toggled at runtime resynchronize on their own.
+     *
+     * Phases that are not active (e.g. Render in headless mode) are skipped. If a neighbouring phase stops making
+     * progress (paused, stalled, or shutting down) the barrier times out after a few of that phase's frame intervals
+     * rather than deadlocking. A downstream phase that times out is marked stalled, and upstream phases run ahead of it
+     * without waiting until it completes another frame.
+     */
+    class FramePipeline : public NonMoveable {
+    public:
+        void SetEnabled(bool enabled);
+        bool IsEnabled() const {
+            return enabled;
+        }
+
+        void SetPhaseActive(FramePhase phase, bool active);
+
+        // Blocks until the phase is allowed to start its next frame
+        void BeginPhase(FramePhase phase);
+        void EndPhase(FramePhase phase);
+
+        FramePipelineStats GetStats() const;
+
+    private:
+        // Returns the neighbouring phase this phase is waiting on, if any
+        std::optional<size_t> BlockingPhase(size_t phase) const;
+        chrono_clock::duration WaitTimeout(size_t phase) const;
+
+        struct PhaseState {
+            bool active = false;
+            // Set when a neighbour timed out waiting on this phase, cleared when it completes a frame
+            bool stalled = false;
+            // Logic frame ids this phase is currently processing, and has last completed
+            uint64_t startedFrame = 0, completedFrame = 0;
+            chrono_clock::time_point frameStart;
+            // Moving average of the time between frame starts
+            chrono_clock::duration frameInterval = {};
+
+            chrono_clock::time_point windowStart;
+            uint32_t frameCount = 0, timeoutCount = 0;
+            chrono_clock::duration totalFrameTime = {}, totalWaitTime = {}, maxWaitTime = {};
+
+            FramePhaseStats measured;
+        };
+
+        mutable std::mutex mutex;
+        std::condition_variable phaseChanged;
+        std::atomic_bool enabled = false;
+        std::array<PhaseState, FRAME_PHASE_COUNT> phases;
+    };
+
+    FramePipeline &GetFramePipeline();
+} // namespace sp
@@ -13,7 +13,11 @@
 #include "strayphotons/Logging.hh"
 #include "strayphotons/Utility.hh"
 
+#include <array>
 #include <atomic>
+#include <bit>
+#include <functional>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <robin_hood.h>
@@ -23,6 +27,16 @@ namespace sp {
     static_assert(sizeof(chrono_clock::rep) <= sizeof(uint64_t), "Chrono Clock time point is larger than uint64_t");
     static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "std::atomic_int64_t is not lock-free");
 
+    /**
+     * A map of shared values that are preserved for PreserveAgeMilliseconds after their last external reference is
+     * released, and then destroyed by Tick().
+     *
+     * Entries are split across independently locked shards, so readers only contend with writers of the same shard.
+     * Each call to Tick() scans whole shards in round-robin order until TICK_ENTRY_BUDGET entries have been visited,
+     * so large maps are scanned over several ticks instead of all at once. An entry's age is counted from the tick
+     * before the first scan that finds it unreferenced, so in large maps entries may be kept for up to one extra scan
+     * rotation, but are never destroyed early.
+     */
     template<typename K,
         typename V,
         int64_t PreserveAgeMilliseconds = 10000,
@@ -32,75 +46,122 @@ namespace sp {
     private:
         static_assert(PreserveAgeMilliseconds > 0, "PreserveAgeMilliseconds must be positive");
 
+        static const size_t SHARD_COUNT = 64;
+        static const size_t TICK_ENTRY_BUDGET = 4096;
+
+        // unused_since value for entries that were referenced the last time they were scanned or loaded
+        static const uint64_t IN_USE = std::numeric_limits<uint64_t>::max();
+
         struct TimedValue {
             TimedValue() {}
-            TimedValue(const std::shared_ptr<V> &value) : value(value), last_use(0) {}
+            TimedValue(const std::shared_ptr<V> &value) : value(value), unused_since(IN_USE) {}
 
             std::shared_ptr<V> value;
-            std::atomic_uint64_t last_use;
+            // Value of tick_time_ms before the tick whose scan first found this entry unreferenced
+            std::atomic_uint64_t unused_since;
         };
 
         using Storage = robin_hood::unordered_node_map<K, TimedValue, Hash, Equal>;
 
-        LockFreeMutex mutex;
-        chrono_clock::time_point last_tick;
-        Storage storage;
+        struct Shard {
+            LockFreeMutex mutex{"PreservingMap"};
+            Storage storage;
+        };
 
-    public:
-        PreservingMap() : last_tick(chrono_clock::now()) {}
+        std::array<Shard, SHARD_COUNT> shards;
 
-        void Tick(chrono_clock::duration maxTickInterval,
-            std::function<void(std::shared_ptr<V> &)> destroyCallback = nullptr) {
-            ZoneScoped;
-            auto now = chrono_clock::now();
-            chrono_clock::duration tickInterval = std::min(now - last_tick, maxTickInterval);
-            auto intervalMs = std::chrono::duration_cast<std::chrono::milliseconds>(tickInterval).count();
-            last_tick = now;
+        // Only accessed by Tick(). tick_time_ms is the sum of all tick intervals, clamped by maxTickInterval.
+        chrono_clock::time_point last_tick;
+        uint64_t tick_time_ms = 0;
+        uint64_t prev_tick_time_ms = 0;
+        size_t next_shard = 0;
+
+        template<typename Key>
+        Shard &GetShard(const Key &key) {
+            // Use the high bits of the hash so shard selection doesn't correlate with bucket selection within a shard
+            uint64_t hash = (uint64_t)Hash()(key) * 0x9E3779B97F4A7C15ull;
+            return shards[hash >> (64 - std::bit_width(SHARD_COUNT - 1))];
+        }
 
+        // Returns the number of entries that were scanned
+        size_t TickShard(Shard &shard, std::function<void(std::shared_ptr<V> &)> &destroyCallback) {
             // 64KiB of stack space or 100 items per tick, whichever is higher
             InlineVector<K, std::max<size_t>(100, 65536 / sizeof(K))> cleanupList;
+            size_t scanned;
             {
-                std::shared_lock lock(mutex);
-                for (auto &[key, timed] : storage) {
+                std::shared_lock lock(shard.mutex);
+                scanned = shard.storage.size();
+                for (auto &[key, timed] : shard.storage) {
                     if (timed.value.use_count() == 1) {
-                        if ((timed.last_use += intervalMs) > PreserveAgeMilliseconds) {
+                        // The shard may not have been scanned for a whole rotation, so an entry that was only just
+                        // released starts aging from the previous tick, rather than from the shard's previous scan.
+                        uint64_t unusedSince = IN_USE;
+                        if (timed.unused_since.compare_exchange_strong(unusedSince, prev_tick_time_ms)) {
+                            unusedSince = prev_tick_time_ms;
+                        }
+                        if (tick_time_ms - unusedSince > PreserveAgeMilliseconds) {
                             if (cleanupList.size() < cleanupList.capacity()) cleanupList.emplace_back(key);
                         }
                     } else {
-                        timed.last_use = 0;
+                        timed.unused_since = IN_USE;
                     }
                 }
             }
             if (cleanupList.size() > 0) {
-                std::unique_lock lock(mutex);
+                std::unique_lock lock(shard.mutex);
 
                 for (auto &key : cleanupList) {
-                    auto it = storage.find(key);
-                    if (it != storage.end() && it->second.value.use_count() == 1) {
+                    auto it = shard.storage.find(key);
+                    if (it != shard.storage.end() && it->second.value.use_count() == 1) {
                         if (destroyCallback) destroyCallback(it->second.value);
-                        storage.erase(it);
+                        shard.storage.erase(it);
                     }
                 }
             }
+            return scanned;
+        }
+
+    public:
+        static_assert(std::has_single_bit(SHARD_COUNT), "PreservingMap SHARD_COUNT must be a power of 2");
+
+        PreservingMap() : last_tick(chrono_clock::now()) {}
+
+        void Tick(chrono_clock::duration maxTickInterval,
+            std::function<void(std::shared_ptr<V> &)> destroyCallback = nullptr) {
+            ZoneScoped;
+            auto now = chrono_clock::now();
+            chrono_clock::duration tickInterval = std::min(now - last_tick, maxTickInterval);
+            prev_tick_time_ms = tick_time_ms;
+            tick_time_ms += std::chrono::duration_cast<std::chrono::milliseconds>(tickInterval).count();
+            last_tick = now;
+
+            size_t visited = 0;
+            for (size_t i = 0; i < SHARD_COUNT && visited < TICK_ENTRY_BUDGET; i++) {
+                auto &shard = shards[next_shard];
+                next_shard = (next_shard + 1) % SHARD_COUNT;
+                visited += TickShard(shard, destroyCallback);
+            }
         }
 
         void Register(const K &key, const std::shared_ptr<V> &source, bool allowReplace = false) {
-            std::unique_lock lock(mutex);
+            auto &shard = GetShard(key);
+            std::unique_lock lock(shard.mutex);
 
-            auto [it, inserted] = storage.emplace(key, source);
+            auto [it, inserted] = shard.storage.emplace(key, source);
             if (!inserted) {
                 Assertf(allowReplace, "Tried to register existing value in PreservingMap");
-                it->second.last_use = 0;
+                it->second.unused_since = IN_USE;
                 it->second.value = source;
             }
         }
 
         std::shared_ptr<V> Load(const K &key) {
-            std::shared_lock lock(mutex);
+            auto &shard = GetShard(key);
+            std::shared_lock lock(shard.mutex);
 
-            auto it = storage.find(key);
-            if (it != storage.end()) {
-                it->second.last_use = 0;
+            auto it = shard.storage.find(key);
+            if (it != shard.storage.end()) {
+                it->second.unused_since = IN_USE;
                 return it->second.value;
             } else {
                 return nullptr;
@@ -109,11 +170,12 @@ namespace sp {
 
         template<typename OtherKey, typename S = Storage>
         typename std::enable_if<S::is_transparent, std::shared_ptr<V>>::type Load(const OtherKey &key) {
-            std::shared_lock lock(mutex);
+            auto &shard = GetShard(key);
+            std::shared_lock lock(shard.mutex);
 
-            auto it = storage.find(key);
-            if (it != storage.end()) {
-                it->second.last_use = 0;
+            auto it = shard.storage.find(key);
+            if (it != shard.storage.end()) {
+                it->second.unused_since = IN_USE;
                 return it->second.value;
             } else {
                 return nullptr;
@@ -124,13 +186,14 @@ namespace sp {
         // A key can only be dropped if there are no references to it.
         // Values will have their destructors called inline by the current thread.
         bool Drop(const K &key) {
-            std::unique_lock lock(mutex);
+            auto &shard = GetShard(key);
+            std::unique_lock lock(shard.mutex);
 
-            auto it = storage.find(key);
-            if (it == storage.end()) return true;
+            auto it = shard.storage.find(key);
+            if (it == shard.storage.end()) return true;
 
             if (it->second.value.use_count() == 1) {
-                storage.erase(it);
+                shard.storage.erase(it);
                 return true;
             }
             return false;
@@ -140,42 +203,53 @@ namespace sp {
         // Values will have their destructors called inline by the current thread.
         // Returns the number of values that were removed.
         size_t DropAll(std::function<void(std::shared_ptr<V> &)> destroyCallback = nullptr) {
-            std::unique_lock lock(mutex);
-
             size_t count = 0;
-            for (auto it = storage.begin(); it != storage.end();) {
-                if (it->second.value.use_count() == 1) {
-                    if (destroyCallback) destroyCallback(it->second.value);
-                    it = storage.erase(it);
-                    count++;
-                } else {
-                    it++;
+            for (auto &shard : shards) {
+                std::unique_lock lock(shard.mutex);
+
+                for (auto it = shard.storage.begin(); it != shard.storage.end();) {
+                    if (it->second.value.use_count() == 1) {
+                        if (destroyCallback) destroyCallback(it->second.value);
+                        it = shard.storage.erase(it);
+                        count++;
+                    } else {
+                        it++;
+                    }
                 }
             }
             return count;
         }
 
+        // Shards are locked one at a time, so entries added concurrently may or may not be visited
         void ForEach(std::function<void(const K &, std::shared_ptr<V> &)> callback) {
-            std::unique_lock lock(mutex);
-            for (auto &[key, tvalue] : storage) {
-                callback(key, tvalue.value);
+            for (auto &shard : shards) {
+                std::unique_lock lock(shard.mutex);
+                for (auto &[key, tvalue] : shard.storage) {
+                    callback(key, tvalue.value);
+                }
             }
         }
 
         bool Contains(const K &key) {
-            std::shared_lock lock(mutex);
-            return storage.contains(key);
+            auto &shard = GetShard(key);
+            std::shared_lock lock(shard.mutex);
+            return shard.storage.contains(key);
         }
 
         template<typename OtherKey, typename S = Storage>
         typename std::enable_if<S::is_transparent, bool>::type Contains(const OtherKey &key) {
-            std::shared_lock lock(mutex);
-            return storage.contains(key);
+            auto &shard = GetShard(key);
+            std::shared_lock lock(shard.mutex);
+            return shard.storage.contains(key);
         }
 
         size_t Size() {
-            std::shared_lock lock(mutex);
-            return storage.size();
+            size_t size = 0;
+            for (auto &shard : shards) {
+                std::shared_lock lock(shard.mutex);
+                size += shard.storage.size();
+            }
+            return size;
         }
     };
 } // namespace sp
@@ -79,7 +79,7 @@ namespace sp {
             }
         };
 
-        LockFreeMutex mutex;
+        LockFreeMutex mutex{"PreservingSet"};
         chrono_clock::time_point last_tick;
         std::deque<TimedValue> storage;
         std::unordered_set<std::shared_ptr<T>, PtrHash, PtrEqual> handles;
@@ -12,6 +12,7 @@
 #include "strayphotons/Hashing.hh"
 #include "strayphotons/LockFreeMutex.hh"
 #include "strayphotons/Logging.hh"
+#include "strayphotons/ThreadAffinity.hh"
 
 #include <mutex>
 #include <shared_mutex>
@@ -69,6 +70,7 @@ namespace sp {
 
         thread = std::thread([this] {
             tracy::SetThreadName(threadName.c_str());
+            UpdateThreadAffinity(threadName);
             Tracef("RegisteredThread Started %s", threadName);
             Defer exit([this] {
                 Tracef("Thread stopping: %s", threadName);
@@ -84,57 +86,98 @@ namespace sp {
 
             if (!ThreadInit()) return;
 
-            auto targetFrameEnd = chrono_clock::now() + this->interval;
-            uint32_t fpsCounter = 0;
+            auto &pipeline = GetFramePipeline();
+            if (framePhase) pipeline.SetPhaseActive(*framePhase, true);
+            Defer deactivatePhase([&] {
+                if (framePhase) pipeline.SetPhaseActive(*framePhase, false);
+            });
+
+            // Scheduled start time of the next frame
+            auto frameTarget = chrono_clock::now();
             chrono_clock::time_point fpsTimer = chrono_clock::now();
+            uint32_t fpsCounter = 0;
+            FrameTimingStats timing;
+            chrono_clock::duration totalJitter = {};
+            uint32_t jitterSamples = 0;
 #ifdef CATCH_GLOBAL_EXCEPTIONS
             try {
 #endif
                 while (state == ThreadState::Started) {
-                    if (this->PreFrame()) {
-                        if (this->stepMode) {
-                            while (stepCount < maxStepCount) {
-                                if (traceFrames) FrameMarkStart(threadName.c_str());
-                                this->Frame();
-                                if (traceFrames) FrameMarkEnd(threadName.c_str());
-                                stepCount++;
+                    UpdateThreadAffinity(threadName);
+                    auto frameStart = chrono_clock::now();
+                    int64_t frameCount = 1;
+                    if (this->interval.count() > 0) {
+                        auto jitter = frameStart > frameTarget ? frameStart - frameTarget : frameTarget - frameStart;
+                        totalJitter += jitter;
+                        timing.maxJitter = std::max(timing.maxJitter, jitter);
+                        jitterSamples++;
+
+                        if (fixedStep && frameStart > frameTarget) {
+                            // Run extra frames for any intervals that were missed
+                            frameCount += (frameStart - frameTarget) / this->interval;
+                            int64_t maxFrames = 1 + (int64_t)maxCatchUpFrames;
+                            if (frameCount > maxFrames) {
+                                // Too far behind to catch up, skip ahead on the timeline
+                                timing.droppedFrames += frameCount - maxFrames;
+                                frameTarget += this->interval * (frameCount - maxFrames);
+                                frameCount = maxFrames;
                             }
-                            stepCount.notify_all();
-                            this->PostFrame(true);
-                        } else {
-                            if (traceFrames) FrameMarkStart(threadName.c_str());
-                            this->Frame();
-                            if (traceFrames) FrameMarkEnd(threadName.c_str());
-                            this->PostFrame(false);
+                            timing.catchUpFrames += frameCount - 1;
+                        }
+                    }
+
+                    for (int64_t i = 0; i < frameCount && state == ThreadState::Started; i++) {
+                        bool pipelined = framePhase && pipeline.IsEnabled();
+                        if (pipelined) pipeline.BeginPhase(*framePhase);
+                        if (this->PreFrame()) {
+                            RunFrame();
+                            fpsCounter++;
                         }
-                        // Logf("[%s] Allocations per frame: %llu", threadName, SampleAllocationCount());fpsMeasuredTime
-                        fpsCounter++;
+                        if (pipelined) pipeline.EndPhase(*framePhase);
                     }
 
                     auto realFrameEnd = chrono_clock::now();
                     if (realFrameEnd - fpsTimer > std::chrono::seconds(1)) {
                         measuredFps = fpsCounter;
+                        measuredTiming.averageJitter = jitterSamples > 0 ? (totalJitter / jitterSamples).count() : 0;
+                        measuredTiming.maxJitter = timing.maxJitter.count();
+                        measuredTiming.overrunFrames = timing.overrunFrames;
+                        measuredTiming.catchUpFrames = timing.catchUpFrames;
+                        measuredTiming.droppedFrames = timing.droppedFrames;
                         fpsCounter = 0;
+                        timing = {};
+                        totalJitter = {};
+                        jitterSamples = 0;
                         fpsTimer = chrono_clock::now();
                     }
 
                     if (this->interval.count() > 0) {
-                        targetFrameEnd += this->interval;
+                        frameTarget += this->interval * frameCount;
 
-                        if (realFrameEnd < targetFrameEnd) {
-                            std::this_thread::sleep_until(targetFrameEnd);
+                        if (realFrameEnd < frameTarget) {
+                            if (fixedStep) {
+                                WaitUntil(frameTarget);
+                            } else {
+                                std::this_thread::sleep_until(frameTarget);
+                            }
                         } else {
-                            // std::cout << std::string("Thread behind: " + threadName + " by " +
-                            //                          std::to_string((realFrameEnd - targetFrameEnd).count() / 1000) +
-                            //                          "\n");
-
-                            // Falling behind, reset target frame end time.
-                            // Add some extra time to allow other threads to start transactions.
-                            targetFrameEnd = realFrameEnd + std::chrono::nanoseconds(100);
-                            std::this_thread::yield();
-                        }
+                            timing.overrunFrames++;
+                            if (fixedStep) {
+                                // Stay on the fixed timeline, missed frames will be caught up next iteration.
+                                std::this_thread::yield();
+                            } else {
+                                // std::cout << std::string("Thread behind: " + threadName + " by " +
+                                //                          std::to_string((realFrameEnd - frameTarget).count() / 1000)
+                                //                          + "\n");
 
+                                // Falling behind, reset target frame end time.
+                                // Add some extra time to allow other threads to start transactions.
+                                frameTarget = realFrameEnd + std::chrono::nanoseconds(100);
+                                std::this_thread::yield();
+                            }
+                        }
                     } else {
+                        frameTarget = realFrameEnd;
                         std::this_thread::yield();
                     }
                 }
@@ -148,6 +191,49 @@ namespace sp {
         });
     }
 
+    void RegisteredThread::RunFrame() {
+        if (this->stepMode) {
+            while (stepCount < maxStepCount) {
+                if (traceFrames) FrameMarkStart(threadName.c_str());
+                this->Frame();
+                if (traceFrames) FrameMarkEnd(threadName.c_str());
+                stepCount++;
+            }
+            stepCount.notify_all();
+            this->PostFrame(true);
+        } else {
+            if (traceFrames) FrameMarkStart(threadName.c_str());
+            this->Frame();
+            if (traceFrames) FrameMarkEnd(threadName.c_str());
+            this->PostFrame(false);
+        }
+    }
+
+    void RegisteredThread::WaitUntil(chrono_clock::time_point target) const {
+        chrono_clock::duration spinThreshold(spinWait.load());
+        if (spinThreshold.count() <= 0) {
+            std::this_thread::sleep_until(target);
+            return;
+        }
+        auto now = chrono_clock::now();
+        if (target - now > spinThreshold) {
+            std::this_thread::sleep_until(target - spinThreshold);
+        }
+        while (chrono_clock::now() < target) {
+            std::this_thread::yield();
+        }
+    }
+
+    FrameTimingStats RegisteredThread::GetFrameTimingStats() const {
+        FrameTimingStats stats;
+        stats.averageJitter = chrono_clock::duration(measuredTiming.averageJitter.load());
+        stats.maxJitter = chrono_clock::duration(measuredTiming.maxJitter.load());
+        stats.overrunFrames = measuredTiming.overrunFrames;
+        stats.catchUpFrames = measuredTiming.catchUpFrames;
+        stats.droppedFrames = measuredTiming.droppedFrames;
+        return stats;
+    }
+
     void RegisteredThread::Pause(bool pause) {
         stepMode = pause;
     }
@@ -193,4 +279,15 @@ namespace sp {
             return 0;
         }
     }
+
+    FrameTimingStats GetFrameTimingStats_static(std::string_view threadName) {
+        std::shared_lock l(getRegistrationMutex());
+        auto &registeredThreads = getRegisteredThreads();
+        auto it = registeredThreads.find(threadName);
+        if (it != registeredThreads.end()) {
+            return it->second->GetFrameTimingStats();
+        } else {
+            return {};
+        }
+    }
 } // namespace sp
@@ -7,14 +7,29 @@
 
 #pragma once
 
+#include "common/FramePipeline.hh"
 #include "strayphotons/Utility.hh"
 
 #include <atomic>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <thread>
 
 namespace sp {
+    // Frame timing measured over the last second of a RegisteredThread's execution
+    struct FrameTimingStats {
+        // Average and maximum difference between the scheduled and actual frame start time
+        chrono_clock::duration averageJitter = {};
+        chrono_clock::duration maxJitter = {};
+        // Number of frames that finished after the next frame was scheduled to start
+        uint32_t overrunFrames = 0;
+        // Number of extra frames run to catch up after falling behind (fixed-step mode only)
+        uint32_t catchUpFrames = 0;
+        // Number of frames skipped because the catch-up limit was reached (fixed-step mode only)
+        uint32_t droppedFrames = 0;
+    };
+
     class RegisteredThread : public NonCopyable {
     public:
         RegisteredThread(std::string threadName, chrono_clock::duration interval, bool traceFrames = false);
@@ -29,6 +44,24 @@ namespace sp {
             return measuredFps;
         }
 
+        FrameTimingStats GetFrameTimingStats() const;
+
+        /**
+         * Fixed-step mode schedules frames on a fixed timeline instead of resetting the target time when a frame
+         * overruns. Time lost to slow frames is made up by running up to maxCatchUpFrames extra frames back-to-back.
+         *
+         * Frames are started by sleeping, which is only accurate to ~1ms on most platforms. If spinWait is non-zero,
+         * the thread instead spins for that long before each frame target for sub-millisecond precision, at the cost
+         * of keeping a core busy.
+         */
+        void SetFixedStep(bool enabled,
+            uint32_t maxCatchUpFrames = 4,
+            chrono_clock::duration spinWait = chrono_clock::duration::zero()) {
+            this->maxCatchUpFrames = maxCatchUpFrames;
+            this->spinWait = spinWait.count();
+            fixedStep = enabled;
+        }
+
         const std::string threadName;
         chrono_clock::duration interval;
         std::atomic_uint64_t stepCount, maxStepCount;
@@ -56,6 +89,12 @@ namespace sp {
 
         virtual void ThreadShutdown() {}
 
+        // Frames of this thread will be synchronized by the FramePipeline barriers while pipelining is enabled.
+        // Must be called before StartThread().
+        void SetFramePhase(FramePhase phase) {
+            framePhase = phase;
+        }
+
         enum class ThreadState : uint32_t {
             Stopped = 0,
             Started,
@@ -65,11 +104,29 @@ namespace sp {
         std::atomic_uint32_t measuredFps;
 
     private:
+        void RunFrame();
+        void WaitUntil(chrono_clock::time_point target) const;
+
         std::thread thread;
+        std::optional<FramePhase> framePhase;
+
+        std::atomic_bool fixedStep = false;
+        std::atomic_uint32_t maxCatchUpFrames = 4;
+        std::atomic<chrono_clock::rep> spinWait = 0;
+
+        struct {
+            std::atomic<chrono_clock::rep> averageJitter, maxJitter;
+            std::atomic_uint32_t overrunFrames, catchUpFrames, droppedFrames;
+        } measuredTiming;
     };
 
     uint32_t GetMeasuredFps_static(std::string_view threadName);
     inline uint32_t GetMeasuredFps(std::string_view threadName) {
         return GetMeasuredFps_static(threadName);
     }
+
+    FrameTimingStats GetFrameTimingStats_static(std::string_view threadName);
+    inline FrameTimingStats GetFrameTimingStats(std::string_view threadName) {
+        return GetFrameTimingStats_static(threadName);
+    }
 } // namespace sp
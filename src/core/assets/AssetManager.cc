@@ -19,6 +19,7 @@ extern "C" {
 #include "ecs/Components.hh"
 #include "ecs/Ecs.hh"
 #include "ecs/EcsImpl.hh"
+#include "strayphotons/AsyncTask.hh"
 
 #include <filesystem>
 #include <fstream>
@@ -54,6 +55,49 @@ extern "C" {
 #include <stb_image_write.h>
 
 namespace sp {
+    namespace {
+        // Each load moves onto the asset work queue before waiting, so the queue tracks it until its input resolves
+        AsyncTask<Gltf> LoadGltfTask(DispatchQueue &queue, AsyncPtr<Asset> assetPtr, AssetName name) {
+            co_await ResumeOn(queue);
+            auto asset = co_await assetPtr;
+            if (!asset) {
+                Logf("Gltf not found: %s", name);
+                co_return nullptr;
+            }
+            co_return std::make_shared<Gltf>(name, asset);
+        }
+
+        AsyncTask<PhysicsInfo> LoadPhysicsInfoTask(DispatchQueue &queue, AsyncPtr<Asset> assetPtr, AssetName name) {
+            co_await ResumeOn(queue);
+            auto asset = co_await assetPtr;
+            // PhysicsInfo handles missing asset internally
+            co_return std::make_shared<PhysicsInfo>(name, asset);
+        }
+
+        AsyncTask<HullSettings> LoadHullSettingsTask(DispatchQueue &queue,
+            AsyncPtr<PhysicsInfo> physicsInfoPtr,
+            AssetName modelName,
+            AssetName meshName) {
+            co_await ResumeOn(queue);
+            auto physicsInfo = co_await physicsInfoPtr;
+            if (!physicsInfo) {
+                Logf("PhysicsInfo not found: %s", modelName);
+                co_return nullptr;
+            }
+            co_return std::make_shared<HullSettings>(PhysicsInfo::GetHull(physicsInfo, meshName));
+        }
+
+        AsyncTask<Image> LoadImageTask(DispatchQueue &queue, AsyncPtr<Asset> assetPtr, AssetPath path) {
+            co_await ResumeOn(queue);
+            auto asset = co_await assetPtr;
+            if (!asset) {
+                Logf("Image not found: %s", path);
+                co_return nullptr;
+            }
+            co_return std::make_shared<Image>(asset);
+        }
+    } // namespace
+
     AssetManager &Assets() {
         static AssetManager assets;
         return assets;
@@ -63,7 +107,8 @@ namespace sp {
     const std::filesystem::path DEFAULT_ASSETS_PATH = "./assets.spdata";
 
     AssetManager::AssetManager()
-        : RegisteredThread("AssetCleanup", 10.0), shutdown(true), workQueue("AssetWorker", 4) {}
+        : RegisteredThread("AssetCleanup", 10.0), shutdown(true),
+          workQueue("AssetWorker", GetJobSystem().GetWorkerCount()) {}
 
     AssetManager::~AssetManager() {
         Shutdown();
@@ -313,13 +358,7 @@ namespace sp {
                 asset = Load(path, AssetType::External);
             }
 
-            gltf = workQueue.Dispatch<Gltf>(asset, [name = AssetName(name)](std::shared_ptr<const Asset> asset) {
-                if (!asset) {
-                    Logf("Gltf not found: %s", name);
-                    return std::shared_ptr<Gltf>();
-                }
-                return std::make_shared<Gltf>(name, asset);
-            });
+            gltf = LoadGltfTask(workQueue, asset, name);
             loadedGltfs.Register(name, gltf);
             if (shutdown.load()) StartThread();
         }
@@ -356,11 +395,7 @@ namespace sp {
                 auto path = FindPhysicsByName(name);
                 if (!path.empty()) asset = Load(path, AssetType::Bundled);
 
-                physicsInfo = workQueue.Dispatch<PhysicsInfo>(asset,
-                    [name = AssetName(name)](std::shared_ptr<const Asset> asset) {
-                        // PhysicsInfo handles missing asset internally
-                        return std::make_shared<PhysicsInfo>(name, asset);
-                    });
+                physicsInfo = LoadPhysicsInfoTask(workQueue, asset, name);
                 loadedPhysics.Register(name, physicsInfo);
             }
         }
@@ -372,17 +407,7 @@ namespace sp {
         Assert(!modelName.empty(), "AssetManager::LoadHullSettings called with empty model name");
         Assert(!meshName.empty(), "AssetManager::LoadHullSettings called with empty mesh name");
 
-        auto physicsInfo = LoadPhysicsInfo(modelName);
-
-        return workQueue.Dispatch<HullSettings>(physicsInfo,
-            [modelName = AssetName(modelName), meshName = AssetName(meshName)](
-                std::shared_ptr<const PhysicsInfo> physicsInfo) {
-                if (!physicsInfo) {
-                    Logf("PhysicsInfo not found: %s", modelName);
-                    return std::shared_ptr<HullSettings>();
-                }
-                return std::make_shared<HullSettings>(PhysicsInfo::GetHull(physicsInfo, meshName));
-            });
+        return LoadHullSettingsTask(workQueue, LoadPhysicsInfo(modelName), modelName, meshName);
     }
 
     AsyncPtr<Image> AssetManager::LoadImage(std::string_view path) {
@@ -397,13 +422,7 @@ namespace sp {
                 if (image) return image;
 
                 auto asset = Load(path);
-                image = workQueue.Dispatch<Image>(asset, [path = AssetPath(path)](std::shared_ptr<const Asset> asset) {
-                    if (!asset) {
-                        Logf("Image not found: %s", path);
-                        return std::shared_ptr<Image>();
-                    }
-                    return std::make_shared<Image>(asset);
-                });
+                image = LoadImageTask(workQueue, asset, path);
 
                 loadedImages.Register(path, image);
             }
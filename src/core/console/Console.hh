@@ -107,7 +107,7 @@ namespace sp {
         void RegisterCoreCommands();
         void RegisterTracyCommands();
 
-        LockFreeMutex cvarReadLock, cvarExecLock;
+        LockFreeMutex cvarReadLock{"Console CVarRead"}, cvarExecLock{"Console CVarExec"};
         std::map<std::string, CVarBase *> cvars;
         CFuncCollection funcs;
         std::thread cliInputThread;
@@ -0,0 +1,87 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "ecs/Ecs.hh"
+
+#include <algorithm>
+#include <vector>
+
+namespace ecs {
+    /**
+     * Tracks which entities had component T added, modified, or removed since the last Poll(), so a system can process
+     * only the changes instead of iterating EntitiesWith<T>() every frame.
+     *
+     * The first Poll() after Watch() or RequestResync() returns every entity that currently has T.
+     * Removed entities are included in the change list, so results should still be checked with Has<T>().
+     *
+     * Writing to T through a non-const Get() counts as a modification, so systems should only write components that
+     * actually changed to avoid seeing their own writes on the next Poll().
+     */
+    template<typename T>
+    class ComponentChangeCursor {
+    public:
+        // Must be called with an AddRemove lock before the first Poll()
+        template<typename LockType>
+        void Watch(LockType &lock) {
+            addRemoveObserver = lock.template Watch<ComponentAddRemoveEvent<T>>();
+            modifiedObserver = lock.template Watch<ComponentModifiedEvent<T>>();
+            resync = true;
+        }
+
+        template<typename LockType>
+        void Stop(LockType &lock) {
+            addRemoveObserver.Stop(lock);
+            modifiedObserver.Stop(lock);
+        }
+
+        // The next Poll() will return every entity with T, instead of only the changed ones
+        void RequestResync() {
+            resync = true;
+        }
+
+        // Returns true if the last Poll() returned every entity with T
+        bool Resynced() const {
+            return resynced;
+        }
+
+        // Returns a sorted list of entities with changes to T since the last call.
+        template<typename LockType>
+        const std::vector<Entity> &Poll(LockType &lock) {
+            changed.clear();
+
+            ComponentAddRemoveEvent<T> addRemoveEvent;
+            while (addRemoveObserver.Poll(lock, addRemoveEvent)) {
+                if (!resync) changed.emplace_back(addRemoveEvent.entity);
+            }
+            ComponentModifiedEvent<T> modifiedEvent;
+            while (modifiedObserver.Poll(lock, modifiedEvent)) {
+                if (!resync) changed.emplace_back(modifiedEvent);
+            }
+
+            resynced = resync;
+            if (resync) {
+                for (const Entity &ent : lock.template EntitiesWith<T>()) {
+                    changed.emplace_back(ent);
+                }
+                resync = false;
+            }
+
+            std::sort(changed.begin(), changed.end());
+            changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+            return changed;
+        }
+
+    private:
+        ComponentAddRemoveObserver<T> addRemoveObserver;
+        ComponentModifiedObserver<T> modifiedObserver;
+        bool resync = true;
+        bool resynced = false;
+        std::vector<Entity> changed;
+    };
+} // namespace ecs
@@ -7,7 +7,9 @@
 
 #include "Ecs.hh"
 
+#include "common/Tracing.hh"
 #include "ecs/EcsImpl.hh"
+#include "strayphotons/ContentionProfiler.hh"
 #include "strayphotons/DispatchQueue.hh"
 #include "strayphotons/Logging.hh"
 
@@ -31,22 +33,114 @@ namespace ecs {
         return GetECSContext().transactionQueue;
     }
 
+    TransactionQueueStats GetTransactionQueueStats() {
+        auto &ctx = GetECSContext();
+        TransactionQueueStats stats;
+        stats.queued = ctx.transactionsQueued.load(std::memory_order_relaxed);
+        stats.lockAcquisitions = ctx.transactionLockAcquisitions.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    namespace detail {
+        // Limits how long other threads may be blocked by a single coalesced transaction
+        static const size_t MAX_COALESCED_TRANSACTIONS = 128;
+
+        void QueueTransaction(std::shared_ptr<QueuedTransaction> &&transaction) {
+            auto &ctx = GetECSContext();
+            {
+                std::lock_guard lock(ctx.pendingTransactionsMutex);
+                ctx.pendingTransactions.emplace_back(std::move(transaction));
+            }
+            ctx.transactionsQueued++;
+
+            // One job is dispatched per transaction, jobs find the queue empty if their transaction was coalesced.
+            ctx.transactionQueue.Dispatch<void>([] {
+                auto &ctx = GetECSContext();
+                std::shared_ptr<QueuedTransaction> leader;
+                {
+                    std::lock_guard lock(ctx.pendingTransactionsMutex);
+                    if (ctx.pendingTransactions.empty()) return;
+                    leader = std::move(ctx.pendingTransactions.front());
+                    ctx.pendingTransactions.pop_front();
+                }
+                ctx.transactionLockAcquisitions++;
+                leader->RunAsLeader();
+            });
+        }
+
+        void RunCoalescedTransactions(const QueuedTransaction &leader,
+            const DynamicLock<> &lock,
+            std::vector<std::shared_ptr<QueuedTransaction>> &completed) {
+            ZoneScoped;
+            if (leader.HasWaiters()) return;
+            auto &ctx = GetECSContext();
+            // The transaction queue only runs 1 job at a time, so nothing else removes items while this runs.
+            while (completed.size() < MAX_COALESCED_TRANSACTIONS) {
+                std::shared_ptr<QueuedTransaction> next;
+                {
+                    std::lock_guard queueLock(ctx.pendingTransactionsMutex);
+                    if (ctx.pendingTransactions.empty()) break;
+                    if (ctx.pendingTransactions.front()->staging != leader.staging) break;
+                    next = std::move(ctx.pendingTransactions.front());
+                    ctx.pendingTransactions.pop_front();
+                }
+                if (!next->TryRun(lock)) {
+                    // Put it back so it leads the next transaction and queue order is preserved
+                    std::lock_guard queueLock(ctx.pendingTransactionsMutex);
+                    ctx.pendingTransactions.emplace_front(std::move(next));
+                    break;
+                }
+                bool hasWaiters = next->HasWaiters();
+                completed.emplace_back(std::move(next));
+                if (hasWaiters) break;
+            }
+            ZoneValue(completed.size());
+        }
+    } // namespace detail
+
     template<typename... AllComponentTypes, template<typename...> typename ECSType>
-    int getComponentIndex(ECSType<AllComponentTypes...> *, const std::string &componentName) {
+    const auto &getComponentNames(ECSType<AllComponentTypes...> *) {
         static const std::array<std::string, sizeof...(AllComponentTypes)> componentNames = {[&] {
             auto comp = LookupComponent(typeid(AllComponentTypes));
             Assertf(comp, "Unknown component name: %s", typeid(AllComponentTypes).name());
             return comp->name;
         }()...};
+        return componentNames;
+    }
 
+    int GetComponentIndex(const std::string &componentName) {
+        auto &componentNames = getComponentNames((ECS *)nullptr);
         auto it = std::find(componentNames.begin(), componentNames.end(), componentName);
         if (it == componentNames.end()) return -1;
         return it - componentNames.begin();
     }
 
-    int GetComponentIndex(const std::string &componentName) {
-        return getComponentIndex((ECS *)nullptr, componentName);
-    }
+#ifdef SP_CONTENTION_PROFILING
+    namespace detail {
+        // Waits shorter than this are the cost of an uncontended transaction, not contention
+        static const auto TRANSACTION_CONTENDED_THRESHOLD = std::chrono::microseconds(2);
+
+        void RecordTransactionWait(const ComponentAccess *access, size_t count, chrono_clock::duration wait) {
+            using SiteList = std::vector<std::pair<sp::contention::ContentionSite *, sp::contention::ContentionSite *>>;
+            static const SiteList sites = [] {
+                SiteList sites;
+                for (auto &name : getComponentNames((ECS *)nullptr)) {
+                    sites.emplace_back(&sp::contention::GetSite("ECS Read " + name),
+                        &sp::contention::GetSite("ECS Write " + name));
+                }
+                return sites;
+            }();
+
+            bool contended = wait >= TRANSACTION_CONTENDED_THRESHOLD;
+            for (size_t i = 0; i < count && i < sites.size(); i++) {
+                if (access[i] == ComponentAccess::None) continue;
+                auto *site = access[i] == ComponentAccess::Write ? sites[i].second : sites[i].first;
+                site->RecordAcquire();
+                if (contended) site->RecordWait(0, wait);
+            }
+        }
+    } // namespace detail
+#endif
 
     std::string ToString(Lock<Read<Name>> lock, Entity e) {
         if (!e.Has<Name>(lock)) return std::to_string(e);
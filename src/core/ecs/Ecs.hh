@@ -11,11 +11,13 @@
 #include "strayphotons/DispatchQueue.hh"
 
 #include <Tecs.hh>
+#include <array>
 #include <iostream>
 #include <memory>
 #include <optional>
 #include <tuple>
 #include <type_traits>
+#include <vector>
 
 namespace picojson {
     class value;
@@ -147,8 +149,38 @@ namespace ecs {
 
     int GetComponentIndex(const std::string &componentName);
 
+#ifdef SP_CONTENTION_PROFILING
+    namespace detail {
+        enum class ComponentAccess : uint8_t { None = 0, Read, Write };
+
+        template<typename LockType, typename... AllComponentTypes>
+        constexpr auto getTransactionAccess(Tecs::ECS<AllComponentTypes...> *) {
+            return std::array<ComponentAccess, sizeof...(AllComponentTypes)>{
+                (Tecs::is_write_allowed<AllComponentTypes, LockType>()      ? ComponentAccess::Write
+                    : Tecs::is_read_allowed<AllComponentTypes, LockType>() ? ComponentAccess::Read
+                                                                            : ComponentAccess::None)...};
+        }
+
+        void RecordTransactionWait(const ComponentAccess *access, size_t count, chrono_clock::duration wait);
+
+        // Records the time between construction and destruction as a lock wait for each component in LockType
+        template<typename LockType>
+        struct TransactionWaitTimer {
+            chrono_clock::time_point start = chrono_clock::now();
+
+            ~TransactionWaitTimer() {
+                static constexpr auto access = getTransactionAccess<LockType>((ECS *)nullptr);
+                RecordTransactionWait(access.data(), access.size(), chrono_clock::now() - start);
+            }
+        };
+    } // namespace detail
+#endif
+
     template<typename... Permissions>
     inline auto StartTransaction() {
+#ifdef SP_CONTENTION_PROFILING
+        detail::TransactionWaitTimer<Lock<Permissions...>> timer;
+#endif
         return World().StartTransaction<Permissions...>();
     }
 
@@ -157,14 +189,104 @@ namespace ecs {
         return StagingWorld().StartTransaction<Permissions...>();
     }
 
+    struct TransactionQueueStats {
+        // Transactions queued, and the number of locks acquired to run them
+        uint64_t queued = 0, lockAcquisitions = 0;
+    };
+
+    TransactionQueueStats GetTransactionQueueStats();
+
+    namespace detail {
+        // A type-erased QueueTransaction() callback waiting in the transaction queue
+        class QueuedTransaction {
+        public:
+            QueuedTransaction(bool staging) : staging(staging) {}
+            virtual ~QueuedTransaction() {}
+
+            // Acquires a lock for this transaction and runs it, along with any compatible transactions queued behind it
+            virtual void RunAsLeader() = 0;
+            // Runs the callback if its permissions are a subset of lock's permissions, returns false otherwise
+            virtual bool TryRun(const DynamicLock<> &lock) = 0;
+            // Resolves the returned future, called once the lock the callback ran with has been committed
+            virtual void Resolve() = 0;
+            // True if the returned future is still referenced outside the queue. Later transactions may wait on it,
+            // so it has to be resolved before they run, which ends a coalesced batch.
+            virtual bool HasWaiters() const = 0;
+
+            const bool staging;
+        };
+
+        void QueueTransaction(std::shared_ptr<QueuedTransaction> &&transaction);
+
+        // Runs queued transactions from the front of the queue using the leader's lock until one is incompatible.
+        // Transactions that were run are appended to completed so they can be resolved after the lock is released.
+        void RunCoalescedTransactions(const QueuedTransaction &leader,
+            const DynamicLock<> &lock,
+            std::vector<std::shared_ptr<QueuedTransaction>> &completed);
+
+        template<typename ReturnType, typename Fn, typename... Permissions>
+        class QueuedTransactionImpl final : public QueuedTransaction {
+        public:
+            QueuedTransactionImpl(bool staging, Fn &&callback)
+                : QueuedTransaction(staging), callback(std::move(callback)),
+                  future(std::make_shared<sp::Async<ReturnType>>()) {}
+
+            void RunAsLeader() override {
+                std::vector<std::shared_ptr<QueuedTransaction>> completed;
+                {
+                    auto lock = staging ? StagingWorld().StartTransaction<Permissions...>()
+                                        : StartTransaction<Permissions...>();
+                    run(lock);
+                    RunCoalescedTransactions(*this, lock, completed);
+                }
+                Resolve();
+                for (auto &transaction : completed) {
+                    transaction->Resolve();
+                }
+            }
+
+            bool TryRun(const DynamicLock<> &lock) override {
+                auto subLock = lock.TryLock<Permissions...>();
+                if (!subLock) return false;
+                run(*subLock);
+                return true;
+            }
+
+            void Resolve() override {
+                future->Set(result);
+            }
+
+            bool HasWaiters() const override {
+                // The future can only be copied from an existing reference, so once the caller has dropped theirs
+                // nothing can start waiting on it.
+                return future.use_count() > 1;
+            }
+
+            sp::AsyncPtr<ReturnType> future;
+
+        private:
+            void run(const Lock<Permissions...> &lock) {
+                if constexpr (std::is_void_v<ReturnType>) {
+                    callback(lock);
+                } else {
+                    result = std::make_shared<ReturnType>(callback(lock));
+                }
+            }
+
+            Fn callback;
+            std::shared_ptr<ReturnType> result;
+        };
+    } // namespace detail
+
     /**
      * Queues a transaction in a globally serialized queue. Ideal for non-blocking write transactions.
      *
      * Returns a future that will be resolved with the return value of the callback.
      * The function will be called from the ECSTransactionQueue thread with the acquired transaction lock.
-     *
-     * If the return value of the callback is itself a future, the future returned
-     * from QueueTransaction will be set to its value once it is ready.
+     * Consecutive queued transactions whose permissions are a subset of the first one's are run in order
+     * under a single lock acquisition. Futures are resolved after the shared lock has been committed. A transaction
+     * whose returned future is still held when it runs ends the batch it runs in, so later transactions that wait on
+     * it see it resolved.
      *
      * Usage: QueueTransaction<Permissions...>([](auto lock) { return value; });
      * Example:
@@ -175,14 +297,11 @@ namespace ecs {
     inline auto QueueTransaction(Fn &&callback)
         -> sp::AsyncPtr<std::invoke_result_t<Fn, const Lock<Permissions...> &>> {
         using ReturnType = std::invoke_result_t<Fn, const Lock<Permissions...> &>;
-        return TransactionQueue().Dispatch<ReturnType>([callback = std::move(callback)]() {
-            Lock<Permissions...> lock = World().StartTransaction<Permissions...>();
-            if constexpr (std::is_void_v<ReturnType>) {
-                callback(lock);
-            } else {
-                return std::make_shared<ReturnType>(callback(lock));
-            }
-        });
+        using TransactionType = detail::QueuedTransactionImpl<ReturnType, std::decay_t<Fn>, Permissions...>;
+        auto transaction = std::make_shared<TransactionType>(false, std::move(callback));
+        auto future = transaction->future;
+        detail::QueueTransaction(std::move(transaction));
+        return future;
     }
 
     // See QueueTransaction() for usage.
@@ -190,14 +309,11 @@ namespace ecs {
     inline auto QueueStagingTransaction(Fn &&callback)
         -> sp::AsyncPtr<std::invoke_result_t<Fn, const Lock<Permissions...> &>> {
         using ReturnType = std::invoke_result_t<Fn, const Lock<Permissions...> &>;
-        return TransactionQueue().Dispatch<ReturnType>([callback = std::move(callback)]() {
-            Lock<Permissions...> lock = StagingWorld().StartTransaction<Permissions...>();
-            if constexpr (std::is_void_v<ReturnType>) {
-                callback(lock);
-            } else {
-                return std::make_shared<ReturnType>(callback(lock));
-            }
-        });
+        using TransactionType = detail::QueuedTransactionImpl<ReturnType, std::decay_t<Fn>, Permissions...>;
+        auto transaction = std::make_shared<TransactionType>(true, std::move(callback));
+        auto future = transaction->future;
+        detail::QueueTransaction(std::move(transaction));
+        return future;
     }
 
     static inline bool IsLive(const Entity &e) {
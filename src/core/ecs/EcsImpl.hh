@@ -62,7 +62,13 @@ namespace ecs {
         ECS staging;
         ECS live;
         EntityReferenceManager refManager;
-        sp::DispatchQueue transactionQueue = sp::DispatchQueue("ECSTransactionQueue", 1, std::chrono::milliseconds(1));
+        sp::DispatchQueue transactionQueue =
+            sp::DispatchQueue("ECSTransactionQueue", 1, std::chrono::milliseconds(1), sp::JobPriority::High);
+
+        // Transactions waiting to be run by transactionQueue, in the order they were queued
+        std::mutex pendingTransactionsMutex;
+        std::deque<std::shared_ptr<detail::QueuedTransaction>> pendingTransactions;
+        std::atomic_uint64_t transactionsQueued = 0, transactionLockAcquisitions = 0;
     };
 
     // Define these special components here to solve circular includes
@@ -117,7 +117,11 @@ namespace ecs {
     }
 
     ecs::Name EntityRef::Name() const {
-        return ptr ? ptr->name : ecs::Name();
+        return ptr ? ptr->atoms.ToName() : ecs::Name();
+    }
+
+    NameAtoms EntityRef::Atoms() const {
+        return ptr ? ptr->atoms : NameAtoms();
     }
 
     Entity EntityRef::Get(const ecs::Lock<> &lock) const {
@@ -144,11 +148,14 @@ namespace ecs {
 
     void EntityRef::SetScope(const EntityScope &scope) {
         if (!ptr) return;
-        ecs::Name newName(ptr->name, scope);
+        // Names with a scene are already fully qualified
+        if (!ptr->atoms.scene.empty()) return;
+        ecs::Name newName(ptr->atoms.ToName(), scope);
         if (!newName) {
             ptr = nullptr;
-        } else if (newName != ptr->name) {
-            ptr = GetEntityRefs().Get(newName).ptr;
+        } else {
+            auto newAtoms = newName.Atoms();
+            if (newAtoms != ptr->atoms) ptr = GetEntityRefs().Get(newAtoms).ptr;
         }
     }
 
@@ -183,7 +190,9 @@ namespace ecs {
 
     bool EntityRef::operator==(const NamedEntity &other) const {
         if (!ptr || !other) return false;
-        return Name() == other.name;
+        // A name that was never interned can't match any existing ref
+        auto otherAtoms = NameAtoms::Find(other.name);
+        return otherAtoms && ptr->atoms == *otherAtoms;
     }
 
     bool EntityRef::operator==(const Entity &other) const {
@@ -192,6 +201,6 @@ namespace ecs {
     }
 
     bool EntityRef::operator<(const EntityRef &other) const {
-        return Name() < other.Name();
+        return Atoms() < other.Atoms();
     }
 } // namespace ecs
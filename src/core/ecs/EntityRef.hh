@@ -78,6 +78,8 @@ The special `"scoperoot"` alias can be used to reference the parent entity durin
         EntityRef(const std::shared_ptr<Ref> &ptr) : ptr(ptr) {}
 
         ecs::Name Name() const;
+        // The interned name, cheaper to compare and hash than Name()
+        NameAtoms Atoms() const;
         Entity Get(const Lock<> &lock) const;
         Entity GetLive() const;
         Entity GetStaging() const;
@@ -7,88 +7,351 @@
 
 #include "EntityReferenceManager.hh"
 
+#include "common/EpochReclaimer.hh"
+#include "common/Tracing.hh"
 #include "ecs/Ecs.hh"
 #include "ecs/EcsImpl.hh"
 #include "ecs/SignalRef.hh"
 
+#include <algorithm>
+#include <array>
 #include <mutex>
-#include <shared_mutex>
+#include <vector>
 
 namespace ecs {
+    namespace {
+        static const size_t INITIAL_NAME_TABLE_SIZE = 1024;
+        static const size_t ENTITY_CHUNK_SIZE = 4096;
+        static const size_t MAX_ENTITY_CHUNKS = 4096;
+        // Unused refs are kept alive for this long, so refs that are repeatedly looked up aren't recreated
+        static const uint64_t PRESERVE_AGE_MILLISECONDS = 1000;
+    } // namespace
+
+    struct EntityReferenceManager::RefNode {
+        RefNode(const NameAtoms &atoms) : atoms(atoms), ref(std::make_shared<EntityRef::Ref>(atoms)) {}
+
+        const NameAtoms atoms;
+        const std::shared_ptr<EntityRef::Ref> ref;
+        // Milliseconds the ref has gone without any outside references
+        std::atomic_uint64_t lastUse = 0;
+        // Set while Tick() decides whether to remove this node, readers that see it retry under the lock
+        std::atomic_bool dropping = false;
+        // Every entity this ref has been set to, only accessed with the mutex held
+        std::vector<Entity> linkedEntities;
+    };
+
+    // Open addressing table, removed entries are replaced with a tombstone so probe sequences stay intact
+    struct EntityReferenceManager::NameTable {
+        NameTable(size_t size) : mask(size - 1), slots(new std::atomic<RefNode *>[size]) {
+            for (size_t i = 0; i < size; i++) {
+                slots[i].store(nullptr, std::memory_order_relaxed);
+            }
+        }
+
+        static RefNode *Tombstone() {
+            return reinterpret_cast<RefNode *>(uintptr_t(1));
+        }
+
+        size_t Size() const {
+            return mask + 1;
+        }
+
+        const size_t mask;
+        std::unique_ptr<std::atomic<RefNode *>[]> slots;
+    };
+
+    // Immutable once published, a new node replaces it when an entity index is reused
+    struct EntityReferenceManager::EntityNode {
+        Entity entity;
+        RefNode *node;
+    };
+
+    // Indexed by entity index, chunks are allocated on demand and never move once published
+    struct EntityReferenceManager::EntityTable {
+        struct Chunk {
+            std::array<std::atomic<EntityNode *>, ENTITY_CHUNK_SIZE> slots = {};
+        };
+
+        std::array<std::atomic<Chunk *>, MAX_ENTITY_CHUNKS> chunks = {};
+
+        ~EntityTable() {
+            for (auto &chunkPtr : chunks) {
+                auto *chunk = chunkPtr.load();
+                if (!chunk) continue;
+                for (auto &slot : chunk->slots) {
+                    delete slot.load();
+                }
+                delete chunk;
+            }
+        }
+
+        std::atomic<EntityNode *> *Find(const Entity &entity) const {
+            if (entity.index / ENTITY_CHUNK_SIZE >= MAX_ENTITY_CHUNKS) return nullptr;
+            auto *chunk = chunks[entity.index / ENTITY_CHUNK_SIZE].load(std::memory_order_acquire);
+            if (!chunk) return nullptr;
+            return &chunk->slots[entity.index % ENTITY_CHUNK_SIZE];
+        }
+
+        // Must be called with the mutex held
+        std::atomic<EntityNode *> &Get(const Entity &entity) {
+            Assertf(entity.index / ENTITY_CHUNK_SIZE < MAX_ENTITY_CHUNKS,
+                "EntityReferenceManager entity index out of range: %s",
+                std::to_string(entity));
+            auto &chunkPtr = chunks[entity.index / ENTITY_CHUNK_SIZE];
+            auto *chunk = chunkPtr.load(std::memory_order_relaxed);
+            if (!chunk) {
+                chunk = new Chunk();
+                chunkPtr.store(chunk, std::memory_order_release);
+            }
+            return chunk->slots[entity.index % ENTITY_CHUNK_SIZE];
+        }
+
+        // Must be called with the mutex held
+        void Unlink(const Entity &entity, const RefNode *node) {
+            auto *slot = Find(entity);
+            if (!slot) return;
+            auto *entityNode = slot->load(std::memory_order_relaxed);
+            if (entityNode && entityNode->entity == entity && entityNode->node == node) {
+                slot->store(nullptr, std::memory_order_release);
+                sp::epoch::Retire(entityNode);
+            }
+        }
+    };
+
+    // Returns a new reference to node's ref, or nullptr if the node is concurrently being removed by Tick()
+    std::shared_ptr<EntityRef::Ref> EntityReferenceManager::AcquireRef(RefNode *node) {
+        auto ref = node->ref;
+        // Pairs with the fence in Tick(): either Tick() sees this reference and keeps the node,
+        // or this sees the dropping flag and discards the reference.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (node->dropping.load(std::memory_order_relaxed)) return nullptr;
+        if (node->lastUse.load(std::memory_order_relaxed) != 0) {
+            node->lastUse.store(0, std::memory_order_relaxed);
+        }
+        return ref;
+    }
+
     EntityReferenceManager &GetEntityRefs() {
         return GetECSContext().refManager;
     }
 
+    EntityReferenceManager::EntityReferenceManager()
+        : nameTable(new NameTable(INITIAL_NAME_TABLE_SIZE)), stagingRefs(new EntityTable()),
+          liveRefs(new EntityTable()), lastTick(chrono_clock::now()) {}
+
+    EntityReferenceManager::~EntityReferenceManager() {
+        auto *table = nameTable.load();
+        for (size_t i = 0; i < table->Size(); i++) {
+            auto *node = table->slots[i].load();
+            if (node && node != NameTable::Tombstone()) delete node;
+        }
+        delete table;
+    }
+
+    EntityReferenceManager::RefNode *EntityReferenceManager::FindNode(const NameAtoms &atoms) const {
+        auto &table = *nameTable.load(std::memory_order_acquire);
+        size_t hash = std::hash<NameAtoms>()(atoms);
+        for (size_t i = hash & table.mask;; i = (i + 1) & table.mask) {
+            auto *node = table.slots[i].load(std::memory_order_acquire);
+            if (!node) return nullptr;
+            if (node != NameTable::Tombstone() && node->atoms == atoms) return node;
+        }
+    }
+
+    EntityReferenceManager::RefNode *EntityReferenceManager::InsertNode(const NameAtoms &atoms) {
+        auto *table = nameTable.load(std::memory_order_relaxed);
+        // Keep the table at most half full, including tombstones
+        if ((nameCount + tombstoneCount + 1) * 2 > table->Size()) {
+            size_t newSize = INITIAL_NAME_TABLE_SIZE;
+            while ((nameCount + 1) * 4 > newSize) {
+                newSize *= 2;
+            }
+            auto *newTable = new NameTable(newSize);
+            for (size_t i = 0; i < table->Size(); i++) {
+                auto *node = table->slots[i].load(std::memory_order_relaxed);
+                if (!node || node == NameTable::Tombstone()) continue;
+                size_t j = std::hash<NameAtoms>()(node->atoms) & newTable->mask;
+                while (newTable->slots[j].load(std::memory_order_relaxed)) {
+                    j = (j + 1) & newTable->mask;
+                }
+                newTable->slots[j].store(node, std::memory_order_relaxed);
+            }
+            nameTable.store(newTable, std::memory_order_release);
+            sp::epoch::Retire(table);
+            table = newTable;
+            tombstoneCount = 0;
+        }
+
+        auto *node = new RefNode(atoms);
+        size_t i = std::hash<NameAtoms>()(atoms) & table->mask;
+        while (true) {
+            auto *existing = table->slots[i].load(std::memory_order_relaxed);
+            if (!existing || existing == NameTable::Tombstone()) {
+                if (existing) tombstoneCount--;
+                table->slots[i].store(node, std::memory_order_release);
+                break;
+            }
+            i = (i + 1) & table->mask;
+        }
+        nameCount++;
+        return node;
+    }
+
+    EntityReferenceManager::EntityTable &EntityReferenceManager::GetEntityTable(const Entity &entity) {
+        if (IsLive(entity)) {
+            return *liveRefs;
+        } else if (IsStaging(entity)) {
+            return *stagingRefs;
+        } else {
+            Abortf("Invalid EntityReferenceManager entity: %s", std::to_string(entity));
+        }
+    }
+
     EntityRef EntityReferenceManager::Get(const Name &name) {
-        DebugZoneScoped;
         if (!name) return EntityRef();
+        return Get(name.Atoms());
+    }
 
-        EntityRef ref = entityRefs.Load(name);
-        if (!ref) {
-            std::lock_guard lock(mutex);
-            ref = entityRefs.Load(name);
-            if (ref) return ref;
+    EntityRef EntityReferenceManager::Get(const NameAtoms &atoms) {
+        DebugZoneScoped;
+        if (!atoms) return EntityRef();
 
-            ref = std::make_shared<EntityRef::Ref>(name);
-            entityRefs.Register(name, ref.ptr);
+        {
+            sp::epoch::EpochGuard guard;
+            auto *node = FindNode(atoms);
+            if (node) {
+                auto ref = AcquireRef(node);
+                if (ref) return EntityRef(ref);
+            }
         }
-        return ref;
+
+        std::lock_guard lock(mutex);
+        // Nodes are only removed by lock holders, so no epoch guard is needed here
+        auto *node = FindNode(atoms);
+        if (!node) node = InsertNode(atoms);
+        node->lastUse = 0;
+        return EntityRef(node->ref);
     }
 
     EntityRef EntityReferenceManager::Get(const Entity &entity) {
         DebugZoneScoped;
         if (!entity) return EntityRef();
 
-        std::shared_lock lock(mutex);
-        if (IsLive(entity)) {
-            if (liveRefs.count(entity) == 0) return EntityRef();
-            return EntityRef(liveRefs[entity].lock());
-        } else if (IsStaging(entity)) {
-            if (stagingRefs.count(entity) == 0) return EntityRef();
-            return EntityRef(stagingRefs[entity].lock());
-        } else {
-            Abortf("Invalid EntityReferenceManager entity: %s", std::to_string(entity));
+        auto &table = GetEntityTable(entity);
+        {
+            sp::epoch::EpochGuard guard;
+            auto *slot = table.Find(entity);
+            if (!slot) return EntityRef();
+            auto *entityNode = slot->load(std::memory_order_acquire);
+            if (!entityNode || entityNode->entity != entity) return EntityRef();
+            auto ref = AcquireRef(entityNode->node);
+            if (ref) return EntityRef(ref);
         }
+
+        // The ref is being removed by Tick(), wait for it to decide
+        std::lock_guard lock(mutex);
+        auto *slot = table.Find(entity);
+        if (!slot) return EntityRef();
+        auto *entityNode = slot->load(std::memory_order_relaxed);
+        if (!entityNode || entityNode->entity != entity) return EntityRef();
+        return EntityRef(entityNode->node->ref);
     }
 
     EntityRef EntityReferenceManager::Set(const Name &name, const Entity &entity) {
         DebugZoneScoped;
         Assertf(entity, "Trying to set EntityRef with null Entity");
+        Assertf(name, "Trying to set EntityRef with empty Name");
+
+        auto atoms = name.Atoms();
+        auto &table = GetEntityTable(entity);
 
-        auto ref = Get(name);
         std::lock_guard lock(mutex);
+        auto *node = FindNode(atoms);
+        if (!node) node = InsertNode(atoms);
+        node->lastUse = 0;
+
         if (IsLive(entity)) {
-            ref.ptr->liveEntity = entity;
-            liveRefs[entity] = ref.ptr;
-        } else if (IsStaging(entity)) {
-            ref.ptr->stagingEntity = entity;
-            stagingRefs[entity] = ref.ptr;
+            node->ref->liveEntity = entity;
         } else {
-            Abortf("Invalid EntityReferenceManager entity: %s", std::to_string(entity));
+            node->ref->stagingEntity = entity;
         }
-        return ref;
+
+        auto &slot = table.Get(entity);
+        auto *existing = slot.load(std::memory_order_relaxed);
+        if (!existing || existing->entity != entity || existing->node != node) {
+            slot.store(new EntityNode{entity, node}, std::memory_order_release);
+            if (existing) sp::epoch::Retire(existing);
+            if (std::find(node->linkedEntities.begin(), node->linkedEntities.end(), entity) ==
+                node->linkedEntities.end()) {
+                node->linkedEntities.emplace_back(entity);
+            }
+        }
+        return EntityRef(node->ref);
     }
 
     std::set<Name> EntityReferenceManager::GetNames(const std::string &search) {
         std::set<Name> results;
-        entityRefs.ForEach([&](auto &name, auto &) {
+        std::lock_guard lock(mutex);
+        auto *table = nameTable.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < table->Size(); i++) {
+            auto *node = table->slots[i].load(std::memory_order_relaxed);
+            if (!node || node == NameTable::Tombstone()) continue;
+            auto name = node->atoms.ToName();
             if (search.empty() || name.String().find(search) != std::string::npos) {
                 results.emplace(name);
             }
-        });
+        }
         return results;
     }
 
+    size_t EntityReferenceManager::Size() {
+        std::lock_guard lock(mutex);
+        return nameCount;
+    }
+
     void EntityReferenceManager::Tick(chrono_clock::duration maxTickInterval) {
-        entityRefs.Tick(maxTickInterval, [this](std::shared_ptr<EntityRef::Ref> &refPtr) {
-            EntityRef ref(refPtr);
-            auto staging = ref.GetStaging();
-            auto live = ref.GetLive();
-            if (staging || live) {
-                std::lock_guard lock(mutex);
-                if (staging) stagingRefs.erase(staging);
-                if (live) liveRefs.erase(live);
+        ZoneScoped;
+        auto now = chrono_clock::now();
+        chrono_clock::duration tickInterval = std::min(now - lastTick, maxTickInterval);
+        uint64_t intervalMs = std::chrono::duration_cast<std::chrono::milliseconds>(tickInterval).count();
+        lastTick = now;
+
+        std::vector<RefNode *> removed;
+        {
+            std::lock_guard lock(mutex);
+            auto *table = nameTable.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < table->Size(); i++) {
+                auto *node = table->slots[i].load(std::memory_order_relaxed);
+                if (!node || node == NameTable::Tombstone()) continue;
+
+                if (node->ref.use_count() > 1) {
+                    node->lastUse = 0;
+                    continue;
+                }
+                if ((node->lastUse += intervalMs) <= PRESERVE_AGE_MILLISECONDS) continue;
+
+                node->dropping.store(true, std::memory_order_relaxed);
+                // Pairs with the fence in AcquireRef(), a lock-free reader may have just copied the ref
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (node->ref.use_count() > 1) {
+                    node->dropping.store(false, std::memory_order_relaxed);
+                    node->lastUse = 0;
+                    continue;
+                }
+
+                table->slots[i].store(NameTable::Tombstone(), std::memory_order_release);
+                nameCount--;
+                tombstoneCount++;
+
+                for (auto &entity : node->linkedEntities) {
+                    GetEntityTable(entity).Unlink(entity, node);
+                }
+                removed.emplace_back(node);
             }
-        });
+        }
+        for (auto *node : removed) {
+            sp::epoch::Retire(node);
+        }
+        sp::epoch::Reclaim();
     }
 } // namespace ecs
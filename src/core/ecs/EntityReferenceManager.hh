@@ -7,47 +7,66 @@
 
 #pragma once
 
-#include "common/PreservingMap.hh"
 #include "ecs/Ecs.hh"
 #include "ecs/EntityRef.hh"
 #include "ecs/SignalRef.hh"
 #include "ecs/components/Name.hh"
 #include "ecs/components/Signals.hh"
-#include "strayphotons/EntityMap.hh"
 #include "strayphotons/LockFreeMutex.hh"
 #include "strayphotons/Logging.hh"
 
 #include <atomic>
 #include <memory>
-#include <robin_hood.h>
+#include <set>
 
 namespace ecs {
+    /**
+     * Lookups of existing refs by name or entity are lock-free: they read from tables that are only modified by
+     * writers holding the mutex, and removed entries are freed through sp::epoch once no reader can still see them.
+     * Only creating a new ref, Set() and Tick() take the lock.
+     */
     class EntityReferenceManager {
         sp::LogOnExit logOnExit = "EntityReferenceManager shut down ======================================";
 
     public:
-        EntityReferenceManager() {}
+        EntityReferenceManager();
+        ~EntityReferenceManager();
 
         EntityRef Get(const Name &name);
+        EntityRef Get(const NameAtoms &atoms);
         EntityRef Get(const Entity &entity);
         EntityRef Set(const Name &name, const Entity &entity);
         std::set<Name> GetNames(const std::string &search = "");
+        size_t Size();
 
         void Tick(chrono_clock::duration maxTickInterval);
 
     private:
-        sp::LockFreeMutex mutex;
-        sp::PreservingMap<Name, EntityRef::Ref, 1000> entityRefs;
-        sp::EntityMap<std::weak_ptr<EntityRef::Ref>> stagingRefs;
-        sp::EntityMap<std::weak_ptr<EntityRef::Ref>> liveRefs;
+        struct RefNode;
+        struct NameTable;
+        struct EntityNode;
+        struct EntityTable;
+
+        static std::shared_ptr<EntityRef::Ref> AcquireRef(RefNode *node);
+        RefNode *FindNode(const NameAtoms &atoms) const;
+        // Must be called with the mutex held
+        RefNode *InsertNode(const NameAtoms &atoms);
+        EntityTable &GetEntityTable(const Entity &entity);
+
+        // Only held by writers
+        sp::LockFreeMutex mutex{"EntityReferenceManager"};
+        std::atomic<NameTable *> nameTable;
+        size_t nameCount = 0, tombstoneCount = 0;
+        std::unique_ptr<EntityTable> stagingRefs, liveRefs;
+        chrono_clock::time_point lastTick;
     };
 
     struct EntityRef::Ref {
-        ecs::Name name;
+        NameAtoms atoms;
         std::atomic<Entity> stagingEntity;
         std::atomic<Entity> liveEntity;
 
-        Ref(const ecs::Name &name) : name(name) {}
+        Ref(const NameAtoms &atoms) : atoms(atoms) {}
     };
 
     EntityReferenceManager &GetEntityRefs();
@@ -127,6 +127,21 @@ namespace ecs {
         funcs.Register("reloadscripts", "Reloads all dynamically loaded scripts", [this]() {
             ReloadDynamicLibraries();
         });
+        funcs.Register("printscriptstats", "Print logic script timing since the last call", [this]() {
+            auto stats = ResetLogicUpdateStats();
+            if (stats.frames == 0) {
+                Logf("No logic frames have run");
+                return;
+            }
+            auto toMs = [](chrono_clock::duration d) {
+                return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count() / 1000000.0;
+            };
+            Logf("Logic scripts over %u frames: avg %.3fms, max %.3fms, %.1f scripts per frame",
+                stats.frames,
+                toMs(stats.totalTime) / stats.frames,
+                toMs(stats.maxTime),
+                stats.scripts / (double)stats.frames);
+        });
     }
 
     ScriptManager::~ScriptManager() {
@@ -392,22 +407,39 @@ namespace ecs {
 
     void ScriptManager::RunLogicUpdate(const LogicUpdateLock &lock, const chrono_clock::duration &interval) {
         ZoneScoped;
-        auto &scriptSet = scripts[ScriptType::LogicScript];
-        std::shared_lock l1(dynamicLibraryMutex);
-        std::shared_lock l2(scriptSet.mutex);
-        for (size_t i : scriptSet.activeScriptList) {
-            auto &[ent, state] = scriptSet.scripts[i];
-            if (!ent.Has<Scripts>(lock)) continue;
-            auto *callbackPtr = std::get_if<LogicTickFunc>(&state.definition.callback);
-            if (!callbackPtr) continue;
-            auto callback = *callbackPtr;
-            if (!callback) continue;
-            if (state.definition.filterOnEvent && state.eventQueue && state.eventQueue->Empty()) continue;
-            DebugZoneScopedN("OnTick");
-            DebugZoneStr(ecs::ToString(lock, ent));
-            callback(state, lock, ent, interval);
-            state.lastEvent = {};
+        auto start = chrono_clock::now();
+        uint64_t scriptCount = 0;
+        {
+            auto &scriptSet = scripts[ScriptType::LogicScript];
+            std::shared_lock l1(dynamicLibraryMutex);
+            std::shared_lock l2(scriptSet.mutex);
+            for (size_t i : scriptSet.activeScriptList) {
+                auto &[ent, state] = scriptSet.scripts[i];
+                if (!ent.Has<Scripts>(lock)) continue;
+                auto *callbackPtr = std::get_if<LogicTickFunc>(&state.definition.callback);
+                if (!callbackPtr) continue;
+                auto callback = *callbackPtr;
+                if (!callback) continue;
+                if (state.definition.filterOnEvent && state.eventQueue && state.eventQueue->Empty()) continue;
+                DebugZoneScopedN("OnTick");
+                DebugZoneStr(ecs::ToString(lock, ent));
+                callback(state, lock, ent, interval);
+                state.lastEvent = {};
+                scriptCount++;
+            }
         }
+        auto frameTime = chrono_clock::now() - start;
+
+        std::lock_guard l(logicStatsMutex);
+        logicStats.frames++;
+        logicStats.scripts += scriptCount;
+        logicStats.totalTime += frameTime;
+        logicStats.maxTime = std::max(logicStats.maxTime, frameTime);
+    }
+
+    LogicUpdateStats ScriptManager::ResetLogicUpdateStats() {
+        std::lock_guard l(logicStatsMutex);
+        return std::exchange(logicStats, {});
     }
 
     void ScriptManager::RunPhysicsUpdate(const PhysicsUpdateLock &lock, const chrono_clock::duration &interval) {
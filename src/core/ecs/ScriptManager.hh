@@ -17,6 +17,7 @@
 #include <deque>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <shared_mutex>
 #include <variant>
 
@@ -174,7 +175,13 @@ namespace ecs {
         std::deque<std::pair<Entity, ScriptState>> scripts;
         std::priority_queue<size_t, std::vector<size_t>, std::greater<size_t>> freeScriptList;
         std::vector<size_t> activeScriptList;
-        mutable sp::LockFreeMutex mutex;
+        mutable sp::LockFreeMutex mutex{"ScriptSet"};
+    };
+
+    struct LogicUpdateStats {
+        uint64_t frames = 0;
+        uint64_t scripts = 0;
+        chrono_clock::duration totalTime = {}, maxTime = {};
     };
 
     class ScriptManager {
@@ -198,6 +205,9 @@ namespace ecs {
         void RunLogicUpdate(const LogicUpdateLock &Lock, const chrono_clock::duration &interval);
         void RunPhysicsUpdate(const PhysicsUpdateLock &lock, const chrono_clock::duration &interval);
 
+        // Returns the logic update stats accumulated since the previous call
+        LogicUpdateStats ResetLogicUpdateStats();
+
         // RunPrefabs should only be run from the SceneManager thread
         void RunPrefabs(const Lock<AddRemove> &lock, Entity ent);
 
@@ -218,9 +228,12 @@ namespace ecs {
         sp::CFuncCollection funcs;
         sp::EnumArray<ScriptSet, ScriptType> scripts = {};
 
-        mutable sp::LockFreeMutex dynamicLibraryMutex;
+        mutable sp::LockFreeMutex dynamicLibraryMutex{"ScriptManager DynamicLibrary"};
         robin_hood::unordered_map<std::string, std::shared_ptr<DynamicLibrary>> dynamicLibraries;
 
+        std::mutex logicStatsMutex;
+        LogicUpdateStats logicStats;
+
         friend class StructMetadata;
         friend class ScriptInstance;
         friend struct sp::EditorContext;
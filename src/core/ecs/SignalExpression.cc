@@ -12,6 +12,7 @@
 #include "ecs/EcsImpl.hh"
 #include "ecs/EntityRef.hh"
 #include "ecs/SignalExpressionNode.hh"
+#include "ecs/SignalExpressionProgram.hh"
 #include "ecs/SignalManager.hh"
 #include "ecs/SignalStructAccess.hh"
 #include "strayphotons/Hashing.hh"
@@ -443,6 +444,7 @@ namespace ecs {
         this->rootNode = GetSignalManager().GetSignalNode(signal);
         rootNode->Compile();
         Assertf(rootNode->evaluate, "Failed to compile expression: %s", expr);
+        program = Program::Compile(rootNode);
     }
 
     SignalExpression::SignalExpression(std::string_view expr, const Name &scope) : scope(scope), expr(expr) {
@@ -485,6 +487,7 @@ namespace ecs {
 
         // Parse the expression into a deduplicated tree of nodes
         rootNode.reset();
+        program.reset();
         size_t tokenIndex = 0;
         rootNode = ctx.parseNode(tokenIndex);
         if (!rootNode) {
@@ -500,6 +503,9 @@ namespace ecs {
             rootNode.reset();
             return false;
         }
+
+        // Flatten the tree into bytecode for evaluation, falling back to the tree if it can't be flattened
+        program = Program::Compile(rootNode);
         return true;
     }
 
@@ -518,6 +524,7 @@ namespace ecs {
         DebugZoneStr(expr);
         if (!rootNode) return 0.0;
         Context ctx(lock, *this, 0.0);
+        if (program) return program->Evaluate(ctx, depth);
         return rootNode->Evaluate(ctx, depth);
     }
 
@@ -526,6 +533,7 @@ namespace ecs {
         DebugZoneStr(expr);
         if (!rootNode) return 0.0;
         Context ctx(lock, *this, input);
+        if (program) return program->Evaluate(ctx, 0);
         return rootNode->Evaluate(ctx, 0);
     }
 
@@ -538,6 +546,7 @@ namespace ecs {
             // Logf("Setting scope of expression (%s): %s -> %s", scope.String(), rootNode->text, newRoot->text);
             Assertf(newRoot->evaluate, "Failed to compile expression: %s", expr);
             this->rootNode = newRoot;
+            this->program = Program::Compile(newRoot);
         }
     }
 
@@ -84,6 +84,7 @@ Signal expressions support the following operations and functions:
         };
 
         struct Node;
+        class Program;
     } // namespace expression
 
     class SignalExpression {
@@ -93,7 +94,7 @@ Signal expressions support the following operations and functions:
         SignalExpression(std::string_view expr, const Name &scope = Name());
 
         SignalExpression(const SignalExpression &other)
-            : scope(other.scope), expr(other.expr), rootNode(other.rootNode) {}
+            : scope(other.scope), expr(other.expr), rootNode(other.rootNode), program(other.program) {}
 
         // Called automatically by constructor. Should be called when expression string is changed.
         bool Compile();
@@ -134,6 +135,8 @@ Signal expressions support the following operations and functions:
         EntityScope scope;
         sp::HeapString expr;
         std::shared_ptr<expression::Node> rootNode;
+        // Flattened form of rootNode used by Evaluate(), or nullptr if the node tree is evaluated directly
+        std::shared_ptr<const expression::Program> program;
     };
 
     static StructMetadata MetadataSignalExpression(typeid(SignalExpression),
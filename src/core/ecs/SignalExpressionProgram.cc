@@ -0,0 +1,549 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "SignalExpressionProgram.hh"
+
+#include "common/Tracing.hh"
+#include "ecs/EcsImpl.hh"
+#include "ecs/SignalExpression.hh"
+#include "strayphotons/Hashing.hh"
+#include "strayphotons/Logging.hh"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <optional>
+
+namespace ecs::expression {
+    // Operations with no side effects, shared by the interpreter and constant folding
+    static inline double evaluateOperation(OpCode op, double a, double b) {
+        switch (op) {
+        case OpCode::Negate:
+            return -a;
+        case OpCode::Not:
+            return a >= 0.5 ? 0.0 : 1.0;
+        case OpCode::Sin:
+            return std::sin(a);
+        case OpCode::Cos:
+            return std::cos(a);
+        case OpCode::Tan:
+            return std::tan(a);
+        case OpCode::Floor:
+            return std::floor(a);
+        case OpCode::Ceil:
+            return std::ceil(a);
+        case OpCode::Abs:
+            return std::abs(a);
+        case OpCode::Add:
+            return a + b;
+        case OpCode::Subtract:
+            return a - b;
+        case OpCode::Multiply:
+            return a * b;
+        case OpCode::Divide:
+            return a / b;
+        case OpCode::And:
+            return (double)(a >= 0.5 && b >= 0.5);
+        case OpCode::Or:
+            return (double)(a >= 0.5 || b >= 0.5);
+        case OpCode::Greater:
+            return (double)(a > b);
+        case OpCode::GreaterEqual:
+            return (double)(a >= b);
+        case OpCode::Less:
+            return (double)(a < b);
+        case OpCode::LessEqual:
+            return (double)(a <= b);
+        case OpCode::Equal:
+            return (double)(a == b);
+        case OpCode::NotEqual:
+            return (double)(a != b);
+        case OpCode::Min:
+            return std::min(a, b);
+        case OpCode::Max:
+            return std::max(a, b);
+        default:
+            Abortf("evaluateOperation unexpected op code: %u", (uint32_t)op);
+        }
+    }
+
+    static inline const char *arithmeticSymbol(OpCode op) {
+        switch (op) {
+        case OpCode::Add:
+            return "+";
+        case OpCode::Subtract:
+            return "-";
+        case OpCode::Multiply:
+            return "*";
+        case OpCode::Divide:
+            return "/";
+        default:
+            return nullptr;
+        }
+    }
+
+    static std::optional<OpCode> oneInputOpCode(const OneInputOperation &op) {
+        if (op.prefixStr == "-") return OpCode::Negate;
+        if (op.prefixStr == "!") return OpCode::Not;
+        if (op.prefixStr == "sin( ") return OpCode::Sin;
+        if (op.prefixStr == "cos( ") return OpCode::Cos;
+        if (op.prefixStr == "tan( ") return OpCode::Tan;
+        if (op.prefixStr == "floor( ") return OpCode::Floor;
+        if (op.prefixStr == "ceil( ") return OpCode::Ceil;
+        if (op.prefixStr == "abs( ") return OpCode::Abs;
+        return {};
+    }
+
+    static std::optional<OpCode> twoInputOpCode(const TwoInputOperation &op) {
+        if (op.prefixStr == "min( ") return OpCode::Min;
+        if (op.prefixStr == "max( ") return OpCode::Max;
+        if (!op.prefixStr.empty()) return {};
+        if (op.middleStr == " + ") return OpCode::Add;
+        if (op.middleStr == " - ") return OpCode::Subtract;
+        if (op.middleStr == " * ") return OpCode::Multiply;
+        if (op.middleStr == " / ") return OpCode::Divide;
+        if (op.middleStr == " && ") return OpCode::And;
+        if (op.middleStr == " || ") return OpCode::Or;
+        if (op.middleStr == " > ") return OpCode::Greater;
+        if (op.middleStr == " >= ") return OpCode::GreaterEqual;
+        if (op.middleStr == " < ") return OpCode::Less;
+        if (op.middleStr == " <= ") return OpCode::LessEqual;
+        if (op.middleStr == " == ") return OpCode::Equal;
+        if (op.middleStr == " != ") return OpCode::NotEqual;
+        return {};
+    }
+
+    struct ProgramBuilder {
+        Program &program;
+        std::vector<bool> constantRegisters;
+        // Nodes that have already been computed on every path leading to the current instruction
+        std::vector<std::pair<const Node *, uint16_t>> available;
+        bool failed = false;
+
+        uint16_t newRegister(bool constant = false, double value = 0.0) {
+            if (program.initialRegisters.size() >= MAX_PROGRAM_REGISTERS) {
+                failed = true;
+                return 0;
+            }
+            program.initialRegisters.emplace_back(value);
+            constantRegisters.emplace_back(constant);
+            return (uint16_t)(program.initialRegisters.size() - 1);
+        }
+
+        uint16_t constant(double value) {
+            return newRegister(true, value);
+        }
+
+        size_t emit(OpCode op, uint16_t dst, uint16_t a = 0, uint16_t b = 0, const Node *node = nullptr) {
+            program.instructions.emplace_back(Instruction{op, dst, a, b, node});
+            return program.instructions.size() - 1;
+        }
+
+        void patchJump(size_t jumpIndex) {
+            program.instructions[jumpIndex].b = (uint16_t)program.instructions.size();
+        }
+
+        uint16_t emitOperation(OpCode op, uint16_t a, std::optional<uint16_t> b = {}) {
+            if (constantRegisters[a] && (!b || constantRegisters[*b])) {
+                double inputB = b ? program.initialRegisters[*b] : 0.0;
+                double result = evaluateOperation(op, program.initialRegisters[a], inputB);
+                // Non-finite results are left to the interpreter so they are reported at evaluation time
+                if (std::isfinite(result)) return constant(result);
+            }
+            uint16_t dst = newRegister();
+            emit(op, dst, a, b.value_or(0));
+            return dst;
+        }
+
+        // Emits the instructions for branch, and stores its result in dst.
+        // Nodes first computed within the branch are not reused after it, since the branch may be skipped.
+        void emitBranch(const Node &branch, uint16_t dst) {
+            size_t scope = available.size();
+            uint16_t result = emitNode(branch);
+            emit(OpCode::Move, dst, result);
+            available.resize(scope);
+        }
+
+        uint16_t emitNode(const Node &node) {
+            for (auto &[availableNode, reg] : available) {
+                if (availableNode == &node) return reg;
+            }
+            for (auto &child : node.childNodes) {
+                if (!child) {
+                    failed = true;
+                    return 0;
+                }
+            }
+
+            uint16_t reg = 0;
+            if (auto *constantNode = std::get_if<ConstantNode>(&node)) {
+                reg = constant(constantNode->value);
+            } else if (std::holds_alternative<SignalNode>(node)) {
+                reg = newRegister();
+                emit(OpCode::Signal, reg, 0, 0, &node);
+            } else if (std::holds_alternative<IdentifierNode>(node) || std::holds_alternative<ComponentNode>(node)) {
+                if (!node.evaluate) {
+                    failed = true;
+                    return 0;
+                }
+                reg = newRegister();
+                emit(OpCode::CallNode, reg, 0, 0, &node);
+            } else if (std::holds_alternative<FocusCondition>(node)) {
+                reg = newRegister();
+                emit(OpCode::FocusTest, reg, 0, 0, &node);
+                if (!node.childNodes.empty()) {
+                    size_t skipJump = emit(OpCode::JumpIfFalse, 0, reg);
+                    emitBranch(*node.childNodes[0], reg);
+                    patchJump(skipJump);
+                }
+            } else if (auto *oneInput = std::get_if<OneInputOperation>(&node)) {
+                if (node.childNodes.empty()) {
+                    failed = true;
+                    return 0;
+                }
+                uint16_t input = emitNode(*node.childNodes[0]);
+                if (oneInput->prefixStr == "( ") {
+                    reg = input;
+                } else {
+                    auto op = oneInputOpCode(*oneInput);
+                    if (!op) {
+                        failed = true;
+                        return 0;
+                    }
+                    reg = emitOperation(*op, input);
+                }
+            } else if (auto *twoInput = std::get_if<TwoInputOperation>(&node)) {
+                auto op = twoInputOpCode(*twoInput);
+                if (!op || node.childNodes.size() < 2) {
+                    failed = true;
+                    return 0;
+                }
+                uint16_t inputA = emitNode(*node.childNodes[0]);
+                uint16_t inputB = emitNode(*node.childNodes[1]);
+                reg = emitOperation(*op, inputA, inputB);
+            } else if (std::holds_alternative<DeciderOperation>(node)) {
+                if (node.childNodes.size() < 3) {
+                    failed = true;
+                    return 0;
+                }
+                uint16_t condition = emitNode(*node.childNodes[0]);
+                if (constantRegisters[condition]) {
+                    bool conditionValue = program.initialRegisters[condition] >= 0.5;
+                    reg = emitNode(*node.childNodes[conditionValue ? 1 : 2]);
+                } else {
+                    reg = newRegister();
+                    size_t falseJump = emit(OpCode::JumpIfFalse, 0, condition);
+                    emitBranch(*node.childNodes[1], reg);
+                    size_t endJump = emit(OpCode::Jump, 0);
+                    patchJump(falseJump);
+                    emitBranch(*node.childNodes[2], reg);
+                    patchJump(endJump);
+                }
+            } else {
+                failed = true;
+                return 0;
+            }
+            if (failed) return 0;
+
+            available.emplace_back(&node, reg);
+            return reg;
+        }
+    };
+
+    std::shared_ptr<const Program> Program::Compile(const SignalNodePtr &rootNode) {
+        ZoneScoped;
+        if (!rootNode) return nullptr;
+
+        auto program = std::make_shared<Program>();
+        program->rootNode = rootNode;
+        ProgramBuilder builder{*program};
+        program->resultRegister = builder.emitNode(*rootNode);
+        if (builder.failed) return nullptr;
+
+        program->shapeHash = program->initialRegisters.size();
+        sp::hash_combine(program->shapeHash, program->resultRegister);
+        for (auto &inst : program->instructions) {
+            if (inst.op == OpCode::Signal) {
+                program->signalInputs.emplace_back(inst.node);
+            } else if (inst.op == OpCode::CallNode || inst.op == OpCode::FocusTest) {
+                program->batchable = false;
+            }
+            uint64_t shape = (uint64_t)inst.op << 48 | (uint64_t)inst.dst << 32 | (uint64_t)inst.a << 16 | inst.b;
+            sp::hash_combine(program->shapeHash, shape);
+        }
+        return program;
+    }
+
+    bool Program::SameShape(const Program &other) const {
+        if (shapeHash != other.shapeHash || resultRegister != other.resultRegister) return false;
+        if (initialRegisters.size() != other.initialRegisters.size()) return false;
+        return std::equal(instructions.begin(),
+            instructions.end(),
+            other.instructions.begin(),
+            other.instructions.end(),
+            [](auto &a, auto &b) {
+                return a.op == b.op && a.dst == b.dst && a.a == b.a && a.b == b.b;
+            });
+    }
+
+    double Program::Evaluate(const Context &ctx, uint32_t depth) const {
+        std::array<double, MAX_PROGRAM_REGISTERS> registers;
+        std::copy(initialRegisters.begin(), initialRegisters.end(), registers.begin());
+
+        const Instruction *code = instructions.data();
+        const size_t codeSize = instructions.size();
+        size_t pc = 0;
+        while (pc < codeSize) {
+            const Instruction &inst = code[pc++];
+            double &dst = registers[inst.dst];
+            switch (inst.op) {
+            case OpCode::Signal: {
+                auto &signalNode = std::get<SignalNode>(*inst.node);
+                if (depth >= MAX_SIGNAL_BINDING_DEPTH) {
+                    Errorf("Max signal binding depth exceeded: %s -> %s", ctx.expr.expr, signalNode.signal.String());
+                    dst = 0.0;
+                } else {
+                    dst = signalNode.signal.GetSignal(ctx.lock, depth + 1);
+                }
+                break;
+            }
+            case OpCode::CallNode:
+                dst = inst.node->evaluate(ctx, *inst.node, depth);
+                break;
+            case OpCode::FocusTest: {
+                dst = 0.0;
+                if (ctx.lock.Has<FocusLock>()) {
+                    auto &focusNode = std::get<FocusCondition>(*inst.node);
+                    auto &focusLock = ctx.lock.Get<FocusLock>();
+                    bool hasFocus = focusNode.checkPrimaryFocus ? focusLock.HasPrimaryFocus(focusNode.ifFocused)
+                                                                : focusLock.HasFocus(focusNode.ifFocused);
+                    if (hasFocus) dst = 1.0;
+                }
+                break;
+            }
+            case OpCode::Jump:
+                pc = inst.b;
+                break;
+            case OpCode::JumpIfFalse:
+                if (!(registers[inst.a] >= 0.5)) pc = inst.b;
+                break;
+            case OpCode::Move:
+                dst = registers[inst.a];
+                break;
+            case OpCode::Add:
+            case OpCode::Subtract:
+            case OpCode::Multiply:
+            case OpCode::Divide: {
+                double inputA = registers[inst.a];
+                double inputB = registers[inst.b];
+                double result = evaluateOperation(inst.op, inputA, inputB);
+                if (!std::isfinite(result)) {
+                    Warnf("Signal expression evaluation error: %f %s %f = %f",
+                        inputA,
+                        arithmeticSymbol(inst.op),
+                        inputB,
+                        result);
+                    result = 0.0;
+                }
+                dst = result;
+                break;
+            }
+            default:
+                dst = evaluateOperation(inst.op, registers[inst.a], registers[inst.b]);
+                break;
+            }
+        }
+        return registers[resultRegister];
+    }
+
+    using LaneRegister = std::array<double, PROGRAM_BATCH_LANES>;
+    using LaneMask = std::array<bool, PROGRAM_BATCH_LANES>;
+
+    // Applies func to every lane, but only stores the result for active lanes.
+    // Written as a fixed width loop over plain arrays so the compiler can vectorize it.
+    template<typename Func>
+    static inline void evaluateLanes(LaneRegister &dst,
+        const LaneRegister &a,
+        const LaneRegister &b,
+        const LaneMask &active,
+        Func &&func) {
+        for (size_t lane = 0; lane < PROGRAM_BATCH_LANES; lane++) {
+            double result = func(a[lane], b[lane]);
+            dst[lane] = active[lane] ? result : dst[lane];
+        }
+    }
+
+    void Program::EvaluateBatch(std::span<const Program *const> programs,
+        std::span<const double> inputs,
+        std::span<double> results) {
+        ZoneScoped;
+        if (programs.empty()) return;
+        const Program &shape = *programs[0];
+        const size_t inputCount = shape.signalInputs.size();
+        Assertf(inputs.size() >= programs.size() * inputCount, "Program::EvaluateBatch missing signal inputs");
+        Assertf(results.size() >= programs.size(), "Program::EvaluateBatch results too small");
+
+        std::array<LaneRegister, MAX_PROGRAM_REGISTERS> registers;
+        for (size_t start = 0; start < programs.size(); start += PROGRAM_BATCH_LANES) {
+            size_t laneCount = std::min(PROGRAM_BATCH_LANES, programs.size() - start);
+            for (size_t reg = 0; reg < shape.initialRegisters.size(); reg++) {
+                for (size_t lane = 0; lane < PROGRAM_BATCH_LANES; lane++) {
+                    registers[reg][lane] = lane < laneCount ? programs[start + lane]->initialRegisters[reg] : 0.0;
+                }
+            }
+
+            // Each lane is inactive until the program counter reaches the target of the last jump it took.
+            // All jumps are forward, so every lane rejoins the others before the end of the program.
+            std::array<size_t, PROGRAM_BATCH_LANES> resumeAt;
+            for (size_t lane = 0; lane < PROGRAM_BATCH_LANES; lane++) {
+                resumeAt[lane] = lane < laneCount ? 0 : SIZE_MAX;
+            }
+
+            size_t inputIndex = 0;
+            for (size_t pc = 0; pc < shape.instructions.size(); pc++) {
+                const Instruction &inst = shape.instructions[pc];
+                LaneMask active;
+                bool anyActive = false;
+                for (size_t lane = 0; lane < PROGRAM_BATCH_LANES; lane++) {
+                    active[lane] = resumeAt[lane] <= pc;
+                    anyActive |= active[lane];
+                }
+                if (inst.op == OpCode::Signal) inputIndex++;
+                if (!anyActive) continue;
+
+                LaneRegister &dst = registers[inst.dst];
+                const LaneRegister &a = registers[inst.a];
+                const LaneRegister &b = registers[inst.b];
+                switch (inst.op) {
+                case OpCode::Signal:
+                    for (size_t lane = 0; lane < laneCount; lane++) {
+                        if (active[lane]) dst[lane] = inputs[(start + lane) * inputCount + inputIndex - 1];
+                    }
+                    break;
+                case OpCode::Jump:
+                    for (size_t lane = 0; lane < PROGRAM_BATCH_LANES; lane++) {
+                        if (active[lane]) resumeAt[lane] = inst.b;
+                    }
+                    break;
+                case OpCode::JumpIfFalse:
+                    for (size_t lane = 0; lane < PROGRAM_BATCH_LANES; lane++) {
+                        if (active[lane] && !(a[lane] >= 0.5)) resumeAt[lane] = inst.b;
+                    }
+                    break;
+                case OpCode::Move:
+                    evaluateLanes(dst, a, b, active, [](double a, double) {
+                        return a;
+                    });
+                    break;
+                case OpCode::Negate:
+                    evaluateLanes(dst, a, b, active, [](double a, double) {
+                        return -a;
+                    });
+                    break;
+                case OpCode::Not:
+                    evaluateLanes(dst, a, b, active, [](double a, double) {
+                        return a >= 0.5 ? 0.0 : 1.0;
+                    });
+                    break;
+                case OpCode::Add:
+                    evaluateLanes(dst, a, b, active, [](double a, double b) {
+                        return a + b;
+                    });
+                    break;
+                case OpCode::Subtract:
+                    evaluateLanes(dst, a, b, active, [](double a, double b) {
+                        return a - b;
+                    });
+                    break;
+                case OpCode::Multiply:
+                    evaluateLanes(dst, a, b, active, [](double a, double b) {
+                        return a * b;
+                    });
+                    break;
+                case OpCode::Divide:
+                    evaluateLanes(dst, a, b, active, [](double a, double b) {
+                        return a / b;
+                    });
+                    break;
+                case OpCode::And:
+                    evaluateLanes(dst, a, b, active, [](double a, double b) {
+                        return (double)(a >= 0.5 && b >= 0.5);
+                    });
+                    break;
+                case OpCode::Or:
+                    evaluateLanes(dst, a, b, active, [](double a, double b) {
+                        return (double)(a >= 0.5 || b >= 0.5);
+                    });
+                    break;
+                case OpCode::Greater:
+                    evaluateLanes(dst, a, b, active, [](double a, double b) {
+                        return (double)(a > b);
+                    });
+                    break;
+                case OpCode::GreaterEqual:
+                    evaluateLanes(dst, a, b, active, [](double a, double b) {
+                        return (double)(a >= b);
+                    });
+                    break;
+                case OpCode::Less:
+                    evaluateLanes(dst, a, b, active, [](double a, double b) {
+                        return (double)(a < b);
+                    });
+                    break;
+                case OpCode::LessEqual:
+                    evaluateLanes(dst, a, b, active, [](double a, double b) {
+                        return (double)(a <= b);
+                    });
+                    break;
+                case OpCode::Equal:
+                    evaluateLanes(dst, a, b, active, [](double a, double b) {
+                        return (double)(a == b);
+                    });
+                    break;
+                case OpCode::NotEqual:
+                    evaluateLanes(dst, a, b, active, [](double a, double b) {
+                        return (double)(a != b);
+                    });
+                    break;
+                case OpCode::Min:
+                    evaluateLanes(dst, a, b, active, [](double a, double b) {
+                        return std::min(a, b);
+                    });
+                    break;
+                case OpCode::Max:
+                    evaluateLanes(dst, a, b, active, [](double a, double b) {
+                        return std::max(a, b);
+                    });
+                    break;
+                default:
+                    // Math functions without a vector implementation
+                    for (size_t lane = 0; lane < laneCount; lane++) {
+                        if (active[lane]) dst[lane] = evaluateOperation(inst.op, a[lane], b[lane]);
+                    }
+                    break;
+                }
+
+                if (arithmeticSymbol(inst.op)) {
+                    for (size_t lane = 0; lane < laneCount; lane++) {
+                        if (active[lane] && !std::isfinite(dst[lane])) {
+                            Warnf("Signal expression evaluation error: %f %s %f = %f",
+                                a[lane],
+                                arithmeticSymbol(inst.op),
+                                b[lane],
+                                dst[lane]);
+                            dst[lane] = 0.0;
+                        }
+                    }
+                }
+            }
+
+            for (size_t lane = 0; lane < laneCount; lane++) {
+                results[start + lane] = registers[shape.resultRegister][lane];
+            }
+        }
+    }
+} // namespace ecs::expression
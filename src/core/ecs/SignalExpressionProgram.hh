@@ -0,0 +1,130 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "ecs/SignalExpressionNode.hh"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace ecs::expression {
+    static const size_t MAX_PROGRAM_REGISTERS = 256;
+    static const size_t PROGRAM_BATCH_LANES = 8;
+
+    enum class OpCode : uint8_t {
+        // Leaf nodes
+        Signal = 0, // dst = node.signal
+        CallNode, // dst = node.evaluate(), used for component and identifier reads
+        FocusTest, // dst = 1.0 if node.ifFocused is focused, else 0.0
+
+        // Control flow
+        Jump, // goto b
+        JumpIfFalse, // if a < 0.5 goto b
+        Move, // dst = a
+
+        // One input operations: dst = op(a)
+        Negate,
+        Not,
+        Sin,
+        Cos,
+        Tan,
+        Floor,
+        Ceil,
+        Abs,
+
+        // Two input operations: dst = op(a, b)
+        Add,
+        Subtract,
+        Multiply,
+        Divide,
+        And,
+        Or,
+        Greater,
+        GreaterEqual,
+        Less,
+        LessEqual,
+        Equal,
+        NotEqual,
+        Min,
+        Max,
+    };
+
+    struct Instruction {
+        OpCode op;
+        uint16_t dst = 0;
+        uint16_t a = 0, b = 0;
+        const Node *node = nullptr;
+    };
+
+    /**
+     * A SignalExpression node tree flattened into a linear list of register-based instructions.
+     *
+     * Nodes shared by the SignalManager are computed once per evaluation, and operations with only constant inputs
+     * are folded at compile time. Conditionals and focus checks jump over the branch that isn't taken, so the same
+     * signals are read as when evaluating the node tree directly.
+     */
+    class Program {
+    public:
+        // Returns nullptr if the tree can't be flattened, in which case the node tree should be evaluated instead.
+        static std::shared_ptr<const Program> Compile(const SignalNodePtr &rootNode);
+
+        double Evaluate(const Context &ctx, uint32_t depth) const;
+
+        /**
+         * Evaluates programs with the same shape PROGRAM_BATCH_LANES at a time, with each instruction applied to all
+         * lanes at once. Lanes that take different branches are masked out until the branches rejoin.
+         *
+         * Signal reads are replaced by the values in inputs, which holds SignalInputs().size() values per program.
+         * All programs must be batchable and have the same shape as programs[0].
+         */
+        static void EvaluateBatch(std::span<const Program *const> programs,
+            std::span<const double> inputs,
+            std::span<double> results);
+
+        // True if the program only reads signals, so it can be evaluated by EvaluateBatch()
+        bool IsBatchable() const {
+            return batchable;
+        }
+
+        // Programs with the same shape run the same instructions, but may read different signals and constants
+        size_t ShapeHash() const {
+            return shapeHash;
+        }
+        bool SameShape(const Program &other) const;
+
+        // The signal node read by each Signal instruction, in program order
+        const std::vector<const Node *> &SignalInputs() const {
+            return signalInputs;
+        }
+
+        size_t InstructionCount() const {
+            return instructions.size();
+        }
+
+        size_t RegisterCount() const {
+            return initialRegisters.size();
+        }
+
+    private:
+        // Holds a reference to the node tree, which Instruction::node points into
+        SignalNodePtr rootNode;
+        std::vector<Instruction> instructions;
+        // Constant and folded values are stored in their registers before the program runs
+        std::vector<double> initialRegisters;
+        uint16_t resultRegister = 0;
+
+        std::vector<const Node *> signalInputs;
+        size_t shapeHash = 0;
+        bool batchable = true;
+
+        friend struct ProgramBuilder;
+    };
+} // namespace ecs::expression
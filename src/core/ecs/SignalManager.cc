@@ -8,8 +8,10 @@
 #include "SignalManager.hh"
 
 #include "ecs/EcsImpl.hh"
+#include "ecs/SignalExpressionProgram.hh"
 #include "ecs/SignalRef.hh"
 
+#include <algorithm>
 #include <mutex>
 #include <picojson.h>
 #include <shared_mutex>
@@ -37,22 +39,23 @@ namespace ecs {
             auto lock = StartTransaction<Read<Signals>>();
             auto &signals = lock.Get<Signals>();
             Logf("Signal debug info:");
-            Logf("  Storage capacity: %llu", signals.signals.capacity());
-            Logf("  Allocated signals: %llu/%llu",
-                signals.signals.size() - signals.freeIndexes.size(),
-                signals.signals.size());
+            Logf("  Storage capacity: %llu", signals.refs.capacity());
+            Logf("  Allocated signals: %llu/%llu", signals.Size() - signals.freeIndexes.size(), signals.Size());
             Logf("  Free signals: %llu", signals.freeIndexes.size());
             Logf("  Dirty signals: %llu", signals.dirtyIndices.size());
+            Logf("  Queued signal updates: %llu", signals.dirtyValues.size());
             size_t minIndex = ~0llu;
             size_t maxIndex = 0;
-            for (size_t i = 0; i < signals.signals.size(); i++) {
-                auto &signal = signals.signals[i];
-                if (signal.ref) {
+            for (size_t i = 0; i < signals.Size(); i++) {
+                if (signals.refs[i]) {
                     minIndex = std::min(minIndex, i);
                     maxIndex = std::max(maxIndex, i);
                 }
             }
             Logf("  First/Last used index: %llu/%llu", minIndex, maxIndex);
+            Logf("  Edge storage: %llu subscribers, %llu dependencies",
+                signals.subscribers.edges.size() - signals.subscribers.unused,
+                signals.dependencies.edges.size() - signals.dependencies.unused);
             Logf("  Signal References: %llu", signalRefs.Size());
         });
     }
@@ -171,4 +174,158 @@ namespace ecs {
     size_t SignalManager::GetNodeCount() {
         return signalNodes.Size();
     }
+
+    // Matches SignalRef::GetSignal() for inputs that are already up to date, otherwise returns false
+    static bool readBatchInput(const Signals &signals, const Node &node, double &value) {
+        auto &signalRef = std::get<SignalNode>(node).signal;
+        if (!signalRef || signalRef.GetIndex() >= signals.Size()) {
+            value = 0.0;
+            return true;
+        }
+        size_t index = signalRef.GetIndex();
+        if (signals.lastValueDirty[index] || !signals.IsCacheable(index)) return false;
+        value = signals.lastValues[index];
+        return true;
+    }
+
+    size_t SignalManager::UpdateBatchedSignals(const Lock<Write<Signals>, ReadSignalsLock> &lock,
+        std::vector<size_t> candidates) {
+        ZoneScoped;
+        auto &signals = lock.Get<Signals>();
+
+        struct BatchEntry {
+            size_t shapeHash;
+            size_t index;
+        };
+        std::vector<BatchEntry> ready;
+        std::vector<size_t> batchIndexes, updated;
+        std::vector<const Program *> programs;
+        std::vector<double> inputs, results;
+
+        size_t updateCount = 0;
+        for (size_t round = 0; round < MAX_SIGNAL_BINDING_DEPTH && !candidates.empty(); round++) {
+            ready.clear();
+            for (size_t index : candidates) {
+                if (index >= signals.Size()) continue;
+                if (!signals.lastValueDirty[index] || !std::isinf(signals.values[index])) continue;
+                auto *program = signals.programs[index];
+                if (!program || !program->IsBatchable() || !signals.exprs[index].IsCacheable()) continue;
+                double value;
+                bool inputsReady = std::all_of(program->SignalInputs().begin(),
+                    program->SignalInputs().end(),
+                    [&](auto *node) {
+                        return readBatchInput(signals, *node, value);
+                    });
+                if (inputsReady) ready.emplace_back(BatchEntry{program->ShapeHash(), index});
+            }
+            std::sort(ready.begin(), ready.end(), [](auto &a, auto &b) {
+                return a.shapeHash < b.shapeHash || (a.shapeHash == b.shapeHash && a.index < b.index);
+            });
+
+            updated.clear();
+            for (size_t start = 0, end = 0; start < ready.size(); start = end) {
+                while (end < ready.size() && ready[end].shapeHash == ready[start].shapeHash) {
+                    end++;
+                }
+                if (end - start == 1) {
+                    size_t index = ready[start].index;
+                    signals.lastValues[index] = signals.Evaluate(lock, index);
+                    signals.lastValueDirty[index] = false;
+                    signals.MarkStorageDirty(lock, index);
+                    updated.emplace_back(ready[start].index);
+                    continue;
+                }
+
+                // Programs with a colliding hash but a different shape are left for the serial update
+                const Program &shape = *signals.programs[ready[start].index];
+                programs.clear();
+                inputs.clear();
+                batchIndexes.clear();
+                for (size_t i = start; i < end; i++) {
+                    auto *program = signals.programs[ready[i].index];
+                    if (!program->SameShape(shape)) continue;
+                    programs.emplace_back(program);
+                    batchIndexes.emplace_back(ready[i].index);
+                    for (auto *node : program->SignalInputs()) {
+                        readBatchInput(signals, *node, inputs.emplace_back());
+                    }
+                }
+                results.resize(programs.size());
+                Program::EvaluateBatch(programs, inputs, results);
+                for (size_t i = 0; i < batchIndexes.size(); i++) {
+                    signals.lastValues[batchIndexes[i]] = results[i];
+                    signals.lastValueDirty[batchIndexes[i]] = false;
+                    signals.MarkStorageDirty(lock, batchIndexes[i]);
+                }
+                updated.insert(updated.end(), batchIndexes.begin(), batchIndexes.end());
+            }
+            updateCount += updated.size();
+
+            candidates.clear();
+            for (size_t index : updated) {
+                for (const auto &sub : signals.subscribers.Get(index)) {
+                    auto subscriber = sub.lock();
+                    if (subscriber) candidates.emplace_back(SignalRef(subscriber).GetIndex());
+                }
+            }
+            std::sort(candidates.begin(), candidates.end());
+            candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+        }
+        return updateCount;
+    }
+
+    SignalUpdateStats SignalManager::UpdateDirtySignals(const Lock<Write<Signals>, ReadSignalsLock> &lock, bool batch) {
+        ZoneScoped;
+        auto &signals = lock.Get<Signals>();
+        SignalUpdateStats stats;
+
+        // A signal may be queued more than once if it was freed and reallocated, keep its lowest depth
+        std::vector<Signals::DirtyValue> worklist(signals.dirtyValues.begin(), signals.dirtyValues.end());
+        signals.dirtyValues.clear();
+        std::sort(worklist.begin(), worklist.end(), [](auto &a, auto &b) {
+            return a.index < b.index || (a.index == b.index && a.depth < b.depth);
+        });
+        worklist.erase(std::unique(worklist.begin(),
+                           worklist.end(),
+                           [](auto &a, auto &b) {
+                               return a.index == b.index;
+                           }),
+            worklist.end());
+        std::stable_sort(worklist.begin(), worklist.end(), [](auto &a, auto &b) {
+            return a.depth < b.depth;
+        });
+        stats.queued = worklist.size();
+
+        if (batch && !worklist.empty()) {
+            std::vector<size_t> candidates;
+            candidates.reserve(worklist.size());
+            for (auto &entry : worklist) {
+                candidates.emplace_back(entry.index);
+            }
+            std::sort(candidates.begin(), candidates.end());
+            stats.batched = UpdateBatchedSignals(lock, std::move(candidates));
+            stats.evaluated += stats.batched;
+        }
+
+        // Dependencies are normally updated before their subscribers. Any that aren't yet are updated on demand by
+        // SignalRef::GetSignal(), so every signal is still only evaluated once.
+        for (auto &entry : worklist) {
+            stats.visited++;
+            if (entry.index >= signals.Size()) continue;
+            if (!signals.refs[entry.index] || !signals.lastValueDirty[entry.index]) continue;
+
+            signals.lastValues[entry.index] = signals.Evaluate(lock, entry.index);
+            stats.evaluated++;
+            if (signals.IsCacheable(entry.index)) signals.lastValueDirty[entry.index] = false;
+            signals.MarkStorageDirty(lock, entry.index);
+        }
+
+        for (auto &entry : worklist) {
+            if (entry.index >= signals.Size()) continue;
+            if (signals.refs[entry.index] && signals.lastValueDirty[entry.index]) {
+                signals.dirtyValues.emplace_back(entry);
+            }
+        }
+        return stats;
+    }
 } // namespace ecs
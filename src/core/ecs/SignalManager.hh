@@ -22,6 +22,13 @@
 #include <vector>
 
 namespace ecs {
+    struct SignalUpdateStats {
+        size_t queued = 0; // Dirty signals in the worklist at the start of the frame
+        size_t visited = 0; // Worklist entries checked, including entries already updated by an earlier entry
+        size_t evaluated = 0; // Signal values recomputed, including batched signals
+        size_t batched = 0;
+    };
+
     class SignalManager {
         sp::LogOnExit logOnExit = "SignalManager shut down  ==============================================";
 
@@ -45,8 +52,24 @@ namespace ecs {
         size_t DropAllUnusedRefs();
         size_t GetNodeCount();
 
+        /**
+         * Updates the cached value of every signal in the Signals::dirtyValues worklist, in binding depth order.
+         * Only signals reachable from a changed value are visited, rather than scanning all signals.
+         * Uncacheable signals stay dirty, and are queued again for the next frame.
+         *
+         * If batch is true, bindings with the same program shape are evaluated together first.
+         */
+        SignalUpdateStats UpdateDirtySignals(const Lock<Write<Signals>, ReadSignalsLock> &lock, bool batch = true);
+
     private:
-        sp::LockFreeMutex mutex;
+        /**
+         * Updates dirty signal bindings whose expressions compile to the same program shape as a single batch.
+         * Only bindings with clean inputs are batched. Their subscribers are then considered in further rounds,
+         * up to MAX_SIGNAL_BINDING_DEPTH. Returns the number of signals updated.
+         */
+        size_t UpdateBatchedSignals(const Lock<Write<Signals>, ReadSignalsLock> &lock, std::vector<size_t> candidates);
+
+        sp::LockFreeMutex mutex{"SignalManager"};
         sp::PreservingSet<expression::Node, 1000> signalNodes;
         sp::PreservingMap<SignalKey, SignalRef::Ref, 1000> signalRefs;
 
@@ -88,24 +88,24 @@ namespace ecs {
         auto &signals = lock.Get<Signals>();
         size_t &index = GetIndex();
         const size_t &subIndex = subscriber.GetIndex();
-        Assertf(subIndex < signals.signals.size(),
+        Assertf(subIndex < signals.Size(),
             "SignalRef::AddSubscriber() called with invalid subscriber index: %u",
             subIndex);
-        if (index < signals.signals.size()) {
-            auto &signal = signals.signals[index];
-            sp::erase_if(signal.subscribers, [](auto &weakPtr) {
+        if (index < signals.Size()) {
+            size_t expired = signals.subscribers.EraseIf(index, [](auto &weakPtr) {
                 return weakPtr.expired();
             });
-            if (!sp::contains(signal.subscribers, subscriber.ptr)) {
-                signal.subscribers.emplace_back(subscriber.ptr);
+            if (expired > 0) signals.MarkStorageDirty(lock, index);
+            if (!sp::contains(signals.subscribers.Get(index), subscriber.ptr)) {
+                signals.subscribers.Add(index, subscriber.ptr);
                 signals.MarkStorageDirty(lock, index);
-                signals.signals[subIndex].dependencies.emplace_back(ptr);
+                signals.dependencies.Add(subIndex, ptr);
                 signals.MarkStorageDirty(lock, subIndex);
                 subscriber.MarkDirty(lock);
             }
         } else {
             index = signals.NewSignal(lock, *this, subscriber);
-            signals.signals[subIndex].dependencies.emplace_back(ptr);
+            signals.dependencies.Add(subIndex, ptr);
             signals.MarkStorageDirty(lock, subIndex);
             subscriber.MarkDirty(lock);
         }
@@ -119,20 +119,21 @@ namespace ecs {
         Assertf(ptr, "SignalRef::UnsubscribeDependencies() called on null SignalRef");
         auto &signals = lock.Get<Signals>();
         size_t &index = GetIndex();
-        if (index >= signals.signals.size()) return;
+        if (index >= signals.Size()) return;
 
-        auto &signal = signals.signals[index];
-        for (const auto &dep : signal.dependencies) {
+        auto dependencies = signals.dependencies.Get(index);
+        for (const auto &dep : dependencies) {
             auto dependency = SignalRef(dep.lock());
             if (!dependency) continue;
             const size_t &depIndex = dependency.GetIndex();
-            if (depIndex >= signals.signals.size()) continue;
-            auto &depSignal = signals.signals[depIndex];
-            sp::erase(depSignal.subscribers, ptr);
+            if (depIndex >= signals.Size()) continue;
+            signals.subscribers.EraseIf(depIndex, [&](auto &weakPtr) {
+                return ptr == weakPtr;
+            });
             signals.MarkStorageDirty(lock, depIndex);
         }
-        if (!signal.dependencies.empty()) signals.MarkStorageDirty(lock, index);
-        signal.dependencies.clear();
+        if (!dependencies.empty()) signals.MarkStorageDirty(lock, index);
+        signals.dependencies.Clear(index);
         RefreshUncacheable(lock);
     }
 
@@ -143,16 +144,16 @@ namespace ecs {
         Assertf(ptr, "SignalRef::MarkDirty() called on null SignalRef");
         auto &signals = lock.Get<Signals>();
         size_t &index = GetIndex();
-        if (index >= signals.signals.size()) return;
-        auto &signal = signals.signals[index];
-        if (!signal.lastValueDirty && depth <= MAX_SIGNAL_BINDING_DEPTH) {
-            signal.lastValueDirty = true;
+        if (index >= signals.Size()) return;
+        if (!signals.lastValueDirty[index] && depth <= MAX_SIGNAL_BINDING_DEPTH) {
+            signals.lastValueDirty[index] = true;
+            signals.QueueDirtyValue(index, depth);
             signals.MarkStorageDirty(lock, index);
             if (depth >= MAX_SIGNAL_BINDING_DEPTH) {
                 // Subscribers past this depth won't be able to evaluate this reference
                 return;
             }
-            for (const auto &sub : signal.subscribers) {
+            for (const auto &sub : signals.subscribers.Get(index)) {
                 auto subscriber = sub.lock();
                 if (subscriber) {
                     SignalRef(subscriber).MarkDirty(lock, depth + 1);
@@ -166,9 +167,8 @@ namespace ecs {
         Assertf(ptr, "SignalRef::IsCacheable() called on null SignalRef");
         auto &signals = lock.Get<Signals>();
         size_t &index = GetIndex();
-        if (index >= signals.signals.size()) return true;
-        auto &signal = signals.signals[index];
-        return !std::isinf(signal.value) || signal.expr.IsCacheable();
+        if (index >= signals.Size()) return true;
+        return signals.IsCacheable(index);
     }
 
     void SignalRef::RefreshUncacheable(const Lock<Write<Signals>> &lock) const {
@@ -176,59 +176,25 @@ namespace ecs {
         if (!ptr) return;
         auto &signals = lock.Get<Signals>();
         size_t &index = GetIndex();
-        if (index >= signals.signals.size()) return;
-        auto &signal = signals.signals[index];
+        if (index >= signals.Size()) return;
 
         SignalNodePtr signalNode = GetSignalManager().FindSignalNode(*this);
         if (signalNode) {
-            bool isCacheable = !std::isinf(signal.value) || signal.expr.IsCacheable();
-            for (auto &dep : signal.dependencies) {
+            bool isCacheable = signals.IsCacheable(index);
+            for (auto &dep : signals.dependencies.Get(index)) {
                 auto dependency = SignalRef(dep.lock());
                 if (!dependency) continue;
                 isCacheable &= dependency.IsCacheable(lock);
             }
             bool changed = signalNode->PropagateUncacheable(!isCacheable);
             if (changed) {
-                for (const auto &sub : signal.subscribers) {
+                for (const auto &sub : signals.subscribers.Get(index)) {
                     SignalRef(sub.lock()).RefreshUncacheable(lock);
                 }
             }
         }
     }
 
-    void SignalRef::UpdateDirtySubscribers(const DynamicLock<Write<Signals>, ReadSignalsLock> &lock,
-        uint32_t depth) const {
-        ZoneScoped;
-        DebugZoneStr(String());
-        Assertf(IsLive(lock), "SiganlRef::MarkDirty() called with staging lock");
-        Assertf(ptr, "SignalRef::MarkDirty() called on null SignalRef");
-        auto &signals = lock.Get<Signals>();
-        size_t &index = GetIndex();
-        if (index >= signals.signals.size()) return;
-        auto &signal = signals.signals[index];
-        bool isCacheable = !std::isinf(signal.value) || signal.expr.IsCacheable();
-        if (signal.lastValueDirty || !isCacheable) {
-            double oldValue = signal.lastValue;
-            signal.lastValue = signal.Value(lock);
-            if (isCacheable) {
-                signal.lastValueDirty = false;
-            } else if (signal.lastValue != oldValue) {
-                MarkDirty(lock, depth);
-            }
-            signals.MarkStorageDirty(lock, index);
-            if (depth >= MAX_SIGNAL_BINDING_DEPTH) {
-                // Subscribers past this depth won't be able to evaluate this reference
-                return;
-            }
-            for (const auto &sub : signal.subscribers) {
-                auto subscriber = sub.lock();
-                if (subscriber) {
-                    SignalRef(subscriber).UpdateDirtySubscribers(lock, depth + 1);
-                }
-            }
-        }
-    }
-
     double &SignalRef::SetValue(const Lock<Write<Signals>> &lock, double value) const {
         DebugZoneScoped;
         DebugZoneStr(String());
@@ -237,25 +203,23 @@ namespace ecs {
         Assertf(std::isfinite(value), "SignalRef::SetValue() called with non-finite value: %f", value);
         auto &signals = lock.Get<Signals>();
         size_t &index = GetIndex();
-        if (index < signals.signals.size()) {
-            auto &signal = signals.signals[index];
-            if (std::isinf(signal.value)) UnsubscribeDependencies(lock);
-            if (signal.value != value) {
-                signal.value = value;
+        if (index < signals.Size()) {
+            if (std::isinf(signals.values[index])) UnsubscribeDependencies(lock);
+            if (signals.values[index] != value) {
+                signals.values[index] = value;
                 signals.MarkStorageDirty(lock, index);
             }
-            if (signal.lastValue != value) {
-                signal.lastValue = value;
+            if (signals.lastValues[index] != value) {
+                signals.lastValues[index] = value;
                 MarkDirty(lock);
             }
-            signal.lastValueDirty = false;
-            return signal.value;
+            signals.lastValueDirty[index] = false;
+            return signals.values[index];
         } else {
             index = signals.NewSignal(lock, *this, value);
             if (value != 0.0) MarkDirty(lock);
-            auto &signal = signals.signals[index];
-            signal.lastValueDirty = false;
-            return signal.value;
+            signals.lastValueDirty[index] = false;
+            return signals.values[index];
         }
     }
 
@@ -266,22 +230,21 @@ namespace ecs {
         Assertf(ptr, "SignalRef::ClearValue() called on null SignalRef");
         auto &signals = lock.Get<Signals>();
         const size_t &index = GetIndex();
-        if (index >= signals.signals.size()) return; // Noop
+        if (index >= signals.Size()) return; // Noop
 
-        auto &signal = signals.signals[index];
-        if (!std::isinf(signal.value)) {
-            signal.value = -std::numeric_limits<double>::infinity();
+        if (!std::isinf(signals.values[index])) {
+            signals.values[index] = -std::numeric_limits<double>::infinity();
             signals.MarkStorageDirty(lock, index);
         }
-        if (signal.expr) {
-            signal.expr.rootNode->SubscribeToChildren(lock, *this);
+        if (signals.exprs[index]) {
+            signals.exprs[index].rootNode->SubscribeToChildren(lock, *this);
             MarkDirty(lock);
-        } else if (signal.lastValue != 0.0 || signal.lastValueDirty) {
-            signal.lastValue = 0.0;
+        } else if (signals.lastValues[index] != 0.0 || signals.lastValueDirty[index]) {
+            signals.lastValues[index] = 0.0;
             MarkDirty(lock);
-            signal.lastValueDirty = false;
+            signals.lastValueDirty[index] = false;
         }
-        if (!signal.expr && signal.subscribers.empty()) signals.FreeSignal(lock, index);
+        if (!signals.exprs[index] && signals.subscribers.Get(index).empty()) signals.FreeSignal(lock, index);
     }
 
     bool SignalRef::HasValue(const Lock<Read<Signals>> &lock) const {
@@ -289,11 +252,11 @@ namespace ecs {
         DebugZoneStr(String());
         Assertf(IsLive(lock), "SiganlRef::HasValue() called with staging lock. Use SignalOutput instead");
         if (!ptr) return false;
-        auto &signals = lock.Get<Signals>().signals;
+        auto &values = lock.Get<Signals>().values;
         const size_t &index = GetIndex();
-        if (index >= signals.size()) return false;
+        if (index >= values.size()) return false;
 
-        return !std::isinf(signals[index].value);
+        return !std::isinf(values[index]);
     }
 
     const double &SignalRef::GetValue(const Lock<Read<Signals>> &lock) const {
@@ -302,11 +265,11 @@ namespace ecs {
         Assertf(IsLive(lock), "SiganlRef::GetValue() called with staging lock. Use SignalOutput instead");
         static const double empty = 0.0;
         if (!ptr) return empty;
-        auto &signals = lock.Get<Signals>().signals;
+        auto &values = lock.Get<Signals>().values;
         const size_t &index = GetIndex();
-        if (index >= signals.size()) return empty;
+        if (index >= values.size()) return empty;
 
-        return signals[index].value;
+        return values[index];
     }
 
     SignalExpression &SignalRef::SetBinding(const Lock<Write<Signals>, ReadSignalsLock> &lock,
@@ -319,23 +282,22 @@ namespace ecs {
         auto &signals = lock.Get<Signals>();
         size_t &index = GetIndex();
 
-        if (index < signals.signals.size()) {
-            auto &signal = signals.signals[index];
-            if (signal.expr != expr) {
-                signal.expr = expr;
+        if (index < signals.Size()) {
+            if (signals.exprs[index] != expr) {
+                signals.SetExpression(index, expr);
                 UnsubscribeDependencies(lock);
-                signal.expr.rootNode->SubscribeToChildren(lock, *this);
+                signals.exprs[index].rootNode->SubscribeToChildren(lock, *this);
                 signals.MarkStorageDirty(lock, index);
                 MarkDirty(lock);
             }
             // SubscribeToChildren may create new signal indexes, so we can't hold this reference earlier
-            return signals.signals[index].expr;
+            return signals.exprs[index];
         } else {
             index = signals.NewSignal(lock, *this, expr);
-            signals.signals[index].expr.rootNode->SubscribeToChildren(lock, *this);
+            signals.exprs[index].rootNode->SubscribeToChildren(lock, *this);
             MarkDirty(lock);
             // SubscribeToChildren may create new signal indexes, so we can't hold this reference earlier
-            return signals.signals[index].expr;
+            return signals.exprs[index];
         }
     }
 
@@ -352,16 +314,17 @@ namespace ecs {
         Assertf(ptr, "SignalRef::ClearBinding() called on null SignalRef");
         auto &signals = lock.Get<Signals>();
         const size_t &index = GetIndex();
-        if (index >= signals.signals.size()) return; // Noop
+        if (index >= signals.Size()) return; // Noop
 
-        auto &signal = signals.signals[index];
-        if (signal.expr) {
-            signal.expr = SignalExpression();
+        if (signals.exprs[index]) {
+            signals.SetExpression(index, SignalExpression());
             UnsubscribeDependencies(lock);
             signals.MarkStorageDirty(lock, index);
             MarkDirty(lock);
         }
-        if (std::isinf(signal.value) && signal.subscribers.empty()) signals.FreeSignal(lock, index);
+        if (std::isinf(signals.values[index]) && signals.subscribers.Get(index).empty()) {
+            signals.FreeSignal(lock, index);
+        }
     }
 
     bool SignalRef::HasBinding(const Lock<Read<Signals>> &lock) const {
@@ -369,11 +332,11 @@ namespace ecs {
         DebugZoneStr(String());
         Assertf(IsLive(lock), "SiganlRef::HasBinding() called with staging lock. Use SignalBindings instead");
         if (!ptr) return false;
-        auto &signals = lock.Get<Signals>().signals;
+        auto &exprs = lock.Get<Signals>().exprs;
         const size_t &index = GetIndex();
-        if (index >= signals.size()) return false;
+        if (index >= exprs.size()) return false;
 
-        return !signals[index].expr.IsNull();
+        return !exprs[index].IsNull();
     }
 
     const SignalExpression &SignalRef::GetBinding(const Lock<Read<Signals>> &lock) const {
@@ -382,11 +345,11 @@ namespace ecs {
         Assertf(IsLive(lock), "SiganlRef::GetBinding() called with staging lock. Use SignalBindings instead");
         static const SignalExpression empty = {};
         if (!ptr) return empty;
-        auto &signals = lock.Get<Signals>().signals;
+        auto &exprs = lock.Get<Signals>().exprs;
         const size_t &index = GetIndex();
-        if (index >= signals.size()) return empty;
+        if (index >= exprs.size()) return empty;
 
-        return signals[index].expr;
+        return exprs[index];
     }
 
     double SignalRef::GetSignal(const DynamicLock<ReadSignalsLock> &lock, uint32_t depth) const {
@@ -394,30 +357,28 @@ namespace ecs {
         DebugZoneStr(String());
         Assertf(IsLive(lock), "SiganlRef::GetSignal() called with staging lock. Use SignalBindings instead");
         if (!ptr) return 0.0;
-        auto &readSignals = lock.Get<Signals>().signals;
+        auto &readSignals = lock.Get<Signals>();
         const size_t &index = GetIndex();
-        if (index >= readSignals.size()) return 0.0;
+        if (index >= readSignals.Size()) return 0.0;
 
-        auto &readSignal = readSignals[index];
-        bool isCacheable = !std::isinf(readSignal.value) || readSignal.expr.IsCacheable();
-        if (isCacheable && !readSignal.lastValueDirty) {
-            DebugAssertf(std::isfinite(readSignal.lastValue),
+        bool isCacheable = readSignals.IsCacheable(index);
+        if (isCacheable && !readSignals.lastValueDirty[index]) {
+            DebugAssertf(std::isfinite(readSignals.lastValues[index]),
                 "SignalRef::GetSignal() returned non-finite value: %f",
-                readSignal.lastValue);
-            return readSignal.lastValue;
+                readSignals.lastValues[index]);
+            return readSignals.lastValues[index];
         }
         auto writeLock = lock.TryLock<Write<Signals>>();
         if (writeLock) {
             auto &signals = writeLock->Get<Signals>();
-            auto &signal = signals.signals[index];
-            double newValue = signal.Value(lock, depth);
+            double newValue = signals.Evaluate(lock, index, depth);
             if (!isCacheable) return newValue;
-            signal.lastValue = newValue;
+            signals.lastValues[index] = newValue;
             signals.MarkStorageDirty(*writeLock, index);
-            signal.lastValueDirty = false;
+            signals.lastValueDirty[index] = false;
             return newValue;
         } else {
-            return readSignal.Value(lock, depth);
+            return readSignals.Evaluate(lock, index, depth);
         }
     }
 
@@ -10,6 +10,7 @@
 #include "ecs/Ecs.hh"
 #include "ecs/EntityRef.hh"
 
+#include <cstdint>
 #include <memory>
 #include <string_view>
 
@@ -23,6 +24,27 @@ namespace ecs {
 
     using ReadSignalsLock = Lock<Read<Name, Signals, SignalOutput, SignalBindings, EventInput, FocusLock>>;
 
+    /**
+     * A signal name with a precomputed hash, for use as a SignalRefCache key.
+     * Names declared as constexpr are hashed at compile time. The string must outlive the SignalName.
+     */
+    struct SignalName {
+        std::string_view name;
+        uint64_t hash;
+
+        constexpr SignalName(std::string_view name) : name(name), hash(Hash(name)) {}
+
+        // 64-bit FNV-1a
+        static constexpr uint64_t Hash(std::string_view str) {
+            uint64_t hash = 0xcbf29ce484222325ull;
+            for (char ch : str) {
+                hash ^= (uint8_t)ch;
+                hash *= 0x100000001b3ull;
+            }
+            return hash;
+        }
+    };
+
     class SignalRef {
     private:
         struct Ref;
@@ -54,7 +76,6 @@ namespace ecs {
         void MarkDirty(const Lock<Write<Signals>> &lock, uint32_t depth = 0) const;
         bool IsCacheable(const Lock<Read<Signals>> &lock) const;
         void RefreshUncacheable(const Lock<Write<Signals>> &lock) const;
-        void UpdateDirtySubscribers(const DynamicLock<Write<Signals>, ReadSignalsLock> &lock, uint32_t depth = 0) const;
 
         double &SetValue(const Lock<Write<Signals>> &lock, double value) const;
         void ClearValue(const Lock<Write<Signals>> &lock) const;
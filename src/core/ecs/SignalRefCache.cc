@@ -0,0 +1,44 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "SignalRefCache.hh"
+
+#include "common/Tracing.hh"
+#include "ecs/EcsImpl.hh"
+
+#include <algorithm>
+
+namespace ecs {
+    SignalRef SignalRefCache::Get(const Lock<> &lock, const Entity &ent, const SignalName &name) {
+        if (!ent) return SignalRef();
+        Key key{ent, name.hash};
+        auto it = refs.find(key);
+        // The entity id may have been reused since the ref was cached, or the name hash may collide
+        if (it != refs.end() && it->second == ent && it->second == name.name) return it->second;
+
+        SignalRef ref(ent, name.name);
+        if (it != refs.end()) {
+            it->second = ref;
+        } else {
+            if (refs.size() >= pruneThreshold) Prune(lock);
+            refs.emplace(key, ref);
+        }
+        return ref;
+    }
+
+    void SignalRefCache::Prune(const Lock<> &lock) {
+        ZoneScoped;
+        for (auto it = refs.begin(); it != refs.end();) {
+            if (it->first.ent.Exists(lock)) {
+                it++;
+            } else {
+                it = refs.erase(it);
+            }
+        }
+        pruneThreshold = std::max<size_t>(1024, refs.size() * 2);
+    }
+} // namespace ecs
@@ -0,0 +1,60 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "ecs/Ecs.hh"
+#include "ecs/SignalRef.hh"
+#include "strayphotons/Hashing.hh"
+
+#include <robin_hood.h>
+
+namespace ecs {
+    /**
+     * Caches the SignalRef for each entity and signal name pair that a system accesses every frame.
+     *
+     * Constructing a SignalRef by name builds a SignalKey and looks it up in the SignalManager, which allocates and
+     * may lock. After the first lookup, Get() is a single hash map lookup with no allocation, and the returned ref
+     * reads and writes its signal by index.
+     *
+     * A cache is not thread-safe, and should only be used by the system that owns it.
+     */
+    class SignalRefCache {
+    public:
+        SignalRef Get(const Lock<> &lock, const Entity &ent, const SignalName &name);
+
+        size_t Size() const {
+            return refs.size();
+        }
+
+        void Clear() {
+            refs.clear();
+        }
+
+    private:
+        // Drops refs whose entity has been removed
+        void Prune(const Lock<> &lock);
+
+        struct Key {
+            Entity ent;
+            uint64_t nameHash;
+
+            bool operator==(const Key &) const = default;
+        };
+
+        struct KeyHash {
+            size_t operator()(const Key &key) const {
+                size_t hash = robin_hood::hash<Entity>()(key.ent);
+                sp::hash_combine(hash, key.nameHash);
+                return hash;
+            }
+        };
+
+        robin_hood::unordered_flat_map<Key, SignalRef, KeyHash> refs;
+        size_t pruneThreshold = 1024;
+    };
+} // namespace ecs
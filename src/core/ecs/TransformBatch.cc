@@ -0,0 +1,431 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "TransformBatch.hh"
+
+#include "strayphotons/Logging.hh"
+
+#include <cmath>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define SP_TRANSFORM_BATCH_SIMD "avx2"
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define SP_TRANSFORM_BATCH_SIMD "sse2"
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    #include <arm_neon.h>
+    #define SP_TRANSFORM_BATCH_SIMD "neon"
+#endif
+
+namespace ecs {
+    static_assert(sizeof(Transform) == 15 * sizeof(float), "Transform is expected to be tightly packed floats");
+
+#ifdef SP_TRANSFORM_BATCH_SIMD
+    namespace {
+    #if defined(__AVX2__)
+        struct Lanes {
+            static constexpr size_t Width = 8;
+            __m256 v;
+
+            static Lanes Load(const float *src) {
+                return {_mm256_load_ps(src)};
+            }
+            void Store(float *dst) const {
+                _mm256_store_ps(dst, v);
+            }
+            friend Lanes operator+(Lanes a, Lanes b) {
+                return {_mm256_add_ps(a.v, b.v)};
+            }
+            friend Lanes operator-(Lanes a) {
+                return {_mm256_sub_ps(_mm256_setzero_ps(), a.v)};
+            }
+            friend Lanes operator*(Lanes a, Lanes b) {
+                return {_mm256_mul_ps(a.v, b.v)};
+            }
+            friend Lanes operator/(Lanes a, Lanes b) {
+                return {_mm256_div_ps(a.v, b.v)};
+            }
+            friend Lanes Sqrt(Lanes a) {
+                return {_mm256_sqrt_ps(a.v)};
+            }
+            static Lanes One() {
+                return {_mm256_set1_ps(1.0f)};
+            }
+            static Lanes Zero() {
+                return {_mm256_setzero_ps()};
+            }
+            static Lanes FromQuads(const __m128 *quads) {
+                return {_mm256_set_m128(quads[1], quads[0])};
+            }
+            void ToQuads(__m128 *quads) const {
+                quads[0] = _mm256_castps256_ps128(v);
+                quads[1] = _mm256_extractf128_ps(v, 1);
+            }
+        };
+    #elif defined(__ARM_NEON)
+        struct Lanes {
+            static constexpr size_t Width = 4;
+            float32x4_t v;
+
+            static Lanes Load(const float *src) {
+                return {vld1q_f32(src)};
+            }
+            void Store(float *dst) const {
+                vst1q_f32(dst, v);
+            }
+            friend Lanes operator+(Lanes a, Lanes b) {
+                return {vaddq_f32(a.v, b.v)};
+            }
+            friend Lanes operator-(Lanes a) {
+                return {vnegq_f32(a.v)};
+            }
+            friend Lanes operator*(Lanes a, Lanes b) {
+                return {vmulq_f32(a.v, b.v)};
+            }
+            friend Lanes operator/(Lanes a, Lanes b) {
+                return {vdivq_f32(a.v, b.v)};
+            }
+            friend Lanes Sqrt(Lanes a) {
+                return {vsqrtq_f32(a.v)};
+            }
+            static Lanes One() {
+                return {vdupq_n_f32(1.0f)};
+            }
+            static Lanes Zero() {
+                return {vdupq_n_f32(0.0f)};
+            }
+        };
+    #else
+        struct Lanes {
+            static constexpr size_t Width = 4;
+            __m128 v;
+
+            static Lanes Load(const float *src) {
+                return {_mm_load_ps(src)};
+            }
+            void Store(float *dst) const {
+                _mm_store_ps(dst, v);
+            }
+            friend Lanes operator+(Lanes a, Lanes b) {
+                return {_mm_add_ps(a.v, b.v)};
+            }
+            friend Lanes operator-(Lanes a) {
+                return {_mm_sub_ps(_mm_setzero_ps(), a.v)};
+            }
+            friend Lanes operator*(Lanes a, Lanes b) {
+                return {_mm_mul_ps(a.v, b.v)};
+            }
+            friend Lanes operator/(Lanes a, Lanes b) {
+                return {_mm_div_ps(a.v, b.v)};
+            }
+            friend Lanes Sqrt(Lanes a) {
+                return {_mm_sqrt_ps(a.v)};
+            }
+            static Lanes One() {
+                return {_mm_set1_ps(1.0f)};
+            }
+            static Lanes Zero() {
+                return {_mm_setzero_ps()};
+            }
+            static Lanes FromQuads(const __m128 *quads) {
+                return {quads[0]};
+            }
+            void ToQuads(__m128 *quads) const {
+                quads[0] = v;
+            }
+        };
+    #endif
+
+        const size_t Width = Lanes::Width;
+
+        // One Transform field per SIMD register, indexed the same as Transform::offset and Transform::scale
+        struct TransformLanes {
+            Lanes offset[4][3];
+            Lanes scale[3];
+        };
+
+        bool anyUndefined(const Transform *src) {
+            for (size_t lane = 0; lane < Width; lane++) {
+                if (std::isinf(src[lane].offset[0][0])) return true;
+            }
+            return false;
+        }
+
+    #if defined(__ARM_NEON)
+        TransformLanes loadTransforms(const Transform *src) {
+            alignas(32) float soa[15][Width];
+            for (size_t lane = 0; lane < Width; lane++) {
+                const float *floats = reinterpret_cast<const float *>(&src[lane]);
+                for (size_t i = 0; i < 15; i++) {
+                    soa[i][lane] = floats[i];
+                }
+            }
+            TransformLanes result;
+            for (size_t c = 0; c < 4; c++) {
+                for (size_t r = 0; r < 3; r++) {
+                    result.offset[c][r] = Lanes::Load(soa[c * 3 + r]);
+                }
+            }
+            for (size_t i = 0; i < 3; i++) {
+                result.scale[i] = Lanes::Load(soa[12 + i]);
+            }
+            return result;
+        }
+
+        void storeTransforms(const TransformLanes &src, Transform *dst) {
+            alignas(32) float soa[15][Width];
+            for (size_t c = 0; c < 4; c++) {
+                for (size_t r = 0; r < 3; r++) {
+                    src.offset[c][r].Store(soa[c * 3 + r]);
+                }
+            }
+            for (size_t i = 0; i < 3; i++) {
+                src.scale[i].Store(soa[12 + i]);
+            }
+            for (size_t lane = 0; lane < Width; lane++) {
+                float *floats = reinterpret_cast<float *>(&dst[lane]);
+                for (size_t i = 0; i < 15; i++) {
+                    floats[i] = soa[i][lane];
+                }
+            }
+        }
+
+        void storeMatrices(const Lanes (&columns)[4][4], glm::mat4 *dst) {
+            alignas(32) float soa[16][Width];
+            for (size_t c = 0; c < 4; c++) {
+                for (size_t r = 0; r < 4; r++) {
+                    columns[c][r].Store(soa[c * 4 + r]);
+                }
+            }
+            for (size_t lane = 0; lane < Width; lane++) {
+                glm::mat4 &matrix = dst[lane];
+                for (size_t c = 0; c < 4; c++) {
+                    for (size_t r = 0; r < 4; r++) {
+                        matrix[c][r] = soa[c * 4 + r][lane];
+                    }
+                }
+            }
+        }
+    #else
+        const size_t QuadCount = Width / 4;
+        // Each Transform is 15 floats, transposed 4 fields at a time. The last block overlaps the previous one.
+        const size_t TransformBlocks[] = {0, 4, 8, 11};
+
+        Lanes &fieldLanes(TransformLanes &lanes, size_t field) {
+            return field < 12 ? lanes.offset[field / 3][field % 3] : lanes.scale[field - 12];
+        }
+
+        const Lanes &fieldLanes(const TransformLanes &lanes, size_t field) {
+            return field < 12 ? lanes.offset[field / 3][field % 3] : lanes.scale[field - 12];
+        }
+
+        TransformLanes loadTransforms(const Transform *src) {
+            const float *floats = reinterpret_cast<const float *>(src);
+            TransformLanes result;
+            for (size_t block : TransformBlocks) {
+                __m128 quads[4][QuadCount];
+                for (size_t q = 0; q < QuadCount; q++) {
+                    __m128 rows[4];
+                    for (size_t i = 0; i < 4; i++) {
+                        rows[i] = _mm_loadu_ps(floats + (q * 4 + i) * 15 + block);
+                    }
+                    _MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+                    for (size_t i = 0; i < 4; i++) {
+                        quads[i][q] = rows[i];
+                    }
+                }
+                for (size_t i = 0; i < 4; i++) {
+                    fieldLanes(result, block + i) = Lanes::FromQuads(quads[i]);
+                }
+            }
+            return result;
+        }
+
+        void storeTransforms(const TransformLanes &src, Transform *dst) {
+            float *floats = reinterpret_cast<float *>(dst);
+            for (size_t block : TransformBlocks) {
+                __m128 quads[4][QuadCount];
+                for (size_t i = 0; i < 4; i++) {
+                    fieldLanes(src, block + i).ToQuads(quads[i]);
+                }
+                for (size_t q = 0; q < QuadCount; q++) {
+                    __m128 rows[4] = {quads[0][q], quads[1][q], quads[2][q], quads[3][q]};
+                    _MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+                    for (size_t i = 0; i < 4; i++) {
+                        _mm_storeu_ps(floats + (q * 4 + i) * 15 + block, rows[i]);
+                    }
+                }
+            }
+        }
+
+        void storeMatrices(const Lanes (&columns)[4][4], glm::mat4 *dst) {
+            for (size_t c = 0; c < 4; c++) {
+                __m128 quads[4][QuadCount];
+                for (size_t r = 0; r < 4; r++) {
+                    columns[c][r].ToQuads(quads[r]);
+                }
+                for (size_t q = 0; q < QuadCount; q++) {
+                    __m128 rows[4] = {quads[0][q], quads[1][q], quads[2][q], quads[3][q]};
+                    _MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+                    for (size_t i = 0; i < 4; i++) {
+                        _mm_storeu_ps(&dst[q * 4 + i][c][0], rows[i]);
+                    }
+                }
+            }
+        }
+    #endif
+
+        // Matches Transform(lhs.GetMatrix() * rhs.GetMatrix())
+        TransformLanes composeLanes(const TransformLanes &a, const TransformLanes &b) {
+            Lanes scaledA[3][3], scaledB[3][3];
+            for (size_t c = 0; c < 3; c++) {
+                for (size_t r = 0; r < 3; r++) {
+                    scaledA[c][r] = a.offset[c][r] * a.scale[c];
+                    scaledB[c][r] = b.offset[c][r] * b.scale[c];
+                }
+            }
+
+            TransformLanes result;
+            for (size_t c = 0; c < 3; c++) {
+                Lanes column[3];
+                for (size_t r = 0; r < 3; r++) {
+                    column[r] = scaledA[0][r] * scaledB[c][0] + scaledA[1][r] * scaledB[c][1] +
+                                scaledA[2][r] * scaledB[c][2];
+                }
+                Lanes length = Sqrt(column[0] * column[0] + column[1] * column[1] + column[2] * column[2]);
+                Lanes invLength = Lanes::One() / length;
+                result.scale[c] = length;
+                for (size_t r = 0; r < 3; r++) {
+                    result.offset[c][r] = column[r] * invLength;
+                }
+            }
+            for (size_t r = 0; r < 3; r++) {
+                result.offset[3][r] = scaledA[0][r] * b.offset[3][0] + scaledA[1][r] * b.offset[3][1] +
+                                      scaledA[2][r] * b.offset[3][2] + a.offset[3][r];
+            }
+            return result;
+        }
+
+        // Matches Transform::GetInverse()
+        TransformLanes invertLanes(const TransformLanes &a) {
+            // Transpose of the rotation with the inverse scale applied
+            Lanes inv[3][3];
+            for (size_t c = 0; c < 3; c++) {
+                for (size_t r = 0; r < 3; r++) {
+                    inv[c][r] = a.offset[r][c] / a.scale[r];
+                }
+            }
+
+            TransformLanes result;
+            for (size_t r = 0; r < 3; r++) {
+                result.offset[3][r] = inv[0][r] * -a.offset[3][0] + inv[1][r] * -a.offset[3][1] +
+                                      inv[2][r] * -a.offset[3][2];
+            }
+            for (size_t c = 0; c < 3; c++) {
+                Lanes length = Sqrt(inv[c][0] * inv[c][0] + inv[c][1] * inv[c][1] + inv[c][2] * inv[c][2]);
+                result.scale[c] = length;
+                for (size_t r = 0; r < 3; r++) {
+                    result.offset[c][r] = inv[c][r] / length;
+                }
+            }
+            return result;
+        }
+
+        // Matches Transform::GetMatrix()
+        void matrixLanes(const TransformLanes &a, glm::mat4 *dst) {
+            Lanes columns[4][4];
+            for (size_t c = 0; c < 3; c++) {
+                for (size_t r = 0; r < 3; r++) {
+                    columns[c][r] = a.offset[c][r] * a.scale[c];
+                }
+                columns[c][3] = Lanes::Zero();
+            }
+            for (size_t r = 0; r < 3; r++) {
+                columns[3][r] = a.offset[3][r];
+            }
+            columns[3][3] = Lanes::One();
+            storeMatrices(columns, dst);
+        }
+    } // namespace
+#endif
+
+    void ComposeTransforms(std::span<const Transform> lhs, std::span<const Transform> rhs, std::span<Transform> out) {
+        Assertf(lhs.size() == rhs.size() && out.size() >= lhs.size(),
+            "ComposeTransforms called with mismatched sizes: %u * %u -> %u",
+            lhs.size(),
+            rhs.size(),
+            out.size());
+        size_t i = 0;
+#ifdef SP_TRANSFORM_BATCH_SIMD
+        for (; i + Width <= lhs.size(); i += Width) {
+            if (anyUndefined(&lhs[i]) || anyUndefined(&rhs[i])) {
+                for (size_t lane = 0; lane < Width; lane++) {
+                    out[i + lane] = lhs[i + lane] * rhs[i + lane];
+                }
+                continue;
+            }
+            storeTransforms(composeLanes(loadTransforms(&lhs[i]), loadTransforms(&rhs[i])), &out[i]);
+        }
+#endif
+        for (; i < lhs.size(); i++) {
+            out[i] = lhs[i] * rhs[i];
+        }
+    }
+
+    void InvertTransforms(std::span<const Transform> in, std::span<Transform> out) {
+        Assertf(out.size() >= in.size(),
+            "InvertTransforms called with mismatched sizes: %u -> %u",
+            in.size(),
+            out.size());
+        size_t i = 0;
+#ifdef SP_TRANSFORM_BATCH_SIMD
+        for (; i + Width <= in.size(); i += Width) {
+            if (anyUndefined(&in[i])) {
+                for (size_t lane = 0; lane < Width; lane++) {
+                    out[i + lane] = in[i + lane].GetInverse();
+                }
+                continue;
+            }
+            storeTransforms(invertLanes(loadTransforms(&in[i])), &out[i]);
+        }
+#endif
+        for (; i < in.size(); i++) {
+            out[i] = in[i].GetInverse();
+        }
+    }
+
+    void TransformsToMatrices(std::span<const Transform> in, std::span<glm::mat4> out) {
+        Assertf(out.size() >= in.size(),
+            "TransformsToMatrices called with mismatched sizes: %u -> %u",
+            in.size(),
+            out.size());
+        size_t i = 0;
+#ifdef SP_TRANSFORM_BATCH_SIMD
+        for (; i + Width <= in.size(); i += Width) {
+            if (anyUndefined(&in[i])) {
+                for (size_t lane = 0; lane < Width; lane++) {
+                    out[i + lane] = in[i + lane].GetMatrix();
+                }
+                continue;
+            }
+            matrixLanes(loadTransforms(&in[i]), &out[i]);
+        }
+#endif
+        for (; i < in.size(); i++) {
+            out[i] = in[i].GetMatrix();
+        }
+    }
+
+    const char *TransformBatchInstructionSet() {
+#ifdef SP_TRANSFORM_BATCH_SIMD
+        return SP_TRANSFORM_BATCH_SIMD;
+#else
+        return "scalar";
+#endif
+    }
+} // namespace ecs
@@ -0,0 +1,32 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "ecs/components/Transform.h"
+
+#include <glm/glm.hpp>
+#include <span>
+
+/**
+ * Batch versions of the ecs::Transform math functions.
+ *
+ * Transforms are transposed into SIMD lanes (AVX2, SSE or NEON, chosen at compile time) and processed several at a
+ * time. Builds without SIMD support, leftover elements and undefined (infinite) transforms fall back to the scalar
+ * Transform methods. Results match the scalar versions within float rounding.
+ */
+namespace ecs {
+    // out[i] = lhs[i] * rhs[i]
+    void ComposeTransforms(std::span<const Transform> lhs, std::span<const Transform> rhs, std::span<Transform> out);
+    // out[i] = in[i].GetInverse()
+    void InvertTransforms(std::span<const Transform> in, std::span<Transform> out);
+    // out[i] = in[i].GetMatrix()
+    void TransformsToMatrices(std::span<const Transform> in, std::span<glm::mat4> out);
+
+    // The name of the SIMD instruction set used by the batch functions in this build
+    const char *TransformBatchInstructionSet();
+} // namespace ecs
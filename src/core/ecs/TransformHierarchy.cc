@@ -0,0 +1,264 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "TransformHierarchy.hh"
+
+#include "common/Tracing.hh"
+#include "ecs/EcsImpl.hh"
+#include "ecs/TransformBatch.hh"
+
+#include <algorithm>
+
+namespace ecs {
+    void TransformHierarchy::MarkModified(Lock<Read<TransformTree, TransformSnapshot>> lock, Entity entity) {
+        if (!entity.Has<TransformTree>(lock)) {
+            Remove(entity);
+            return;
+        }
+
+        auto *existing = nodeIndex.find(entity);
+        if (!existing) {
+            // A new entity may be the missing parent of an orphaned node
+            if (hasOrphans) needsSort = true;
+            uint32_t index = Track(lock, entity);
+            dirty[index] = DIRTY;
+            return;
+        }
+
+        uint32_t index = *existing;
+        dirty[index] = DIRTY;
+        uint32_t parentIndex = FindParent(lock, entity.Get<const TransformTree>(lock));
+        if (parentIndex == parents[index]) return;
+
+        parents[index] = parentIndex;
+        // Reparenting under a node that comes later in the array breaks parent-before-child order
+        if (parentIndex != NO_PARENT && parentIndex > index) needsSort = true;
+    }
+
+    const std::vector<Entity> &TransformHierarchy::UpdateSnapshots(
+        Lock<Read<TransformTree>, Write<TransformSnapshot>> lock) {
+        ZoneScoped;
+        if (!initialized) {
+            for (const Entity &ent : lock.EntitiesWith<TransformTree>()) {
+                Track(lock, ent);
+            }
+            initialized = true;
+        }
+        if (needsSort) Sort(lock);
+
+        updated.clear();
+        auto flushBatch = [&] {
+            if (batchNodes.empty()) return;
+            batchResults.resize(batchNodes.size());
+            ComposeTransforms(batchParents, batchLocals, batchResults);
+            for (size_t j = 0; j < batchNodes.size(); j++) {
+                uint32_t index = batchNodes[j];
+                globalPoses[index] = batchResults[j];
+                dirty[index] = DIRTY;
+                const Entity &ent = entities[index];
+                if (ent.Has<TransformSnapshot>(lock)) {
+                    ent.Get<TransformSnapshot>(lock).globalPose = batchResults[j];
+                }
+                updated.emplace_back(ent);
+            }
+            batchNodes.clear();
+            batchParents.clear();
+            batchLocals.clear();
+        };
+
+        for (size_t i = 0; i < entities.size(); i++) {
+            uint32_t parentIndex = parents[i];
+            if (!dirty[i]) {
+                if (parentIndex == NO_PARENT || !dirty[parentIndex]) continue;
+                dirty[i] = DIRTY;
+            }
+
+            const Entity &ent = entities[i];
+            if (!ent) continue;
+            if (!ent.Has<TransformTree>(lock)) {
+                // The TransformTree was removed without being reported, children become roots until the next Sort()
+                Remove(ent);
+                continue;
+            }
+
+            const Transform &pose = ent.Get<const TransformTree>(lock).pose.Get();
+            if (parentIndex == NO_PARENT || !entities[parentIndex]) {
+                globalPoses[i] = pose;
+                if (ent.Has<TransformSnapshot>(lock)) {
+                    ent.Get<TransformSnapshot>(lock).globalPose = pose;
+                }
+                updated.emplace_back(ent);
+                continue;
+            }
+
+            // Nodes are composed with their parent in batches, which must be flushed before any child can read them
+            if (dirty[parentIndex] == PENDING_BATCH) flushBatch();
+            batchNodes.emplace_back(i);
+            batchParents.emplace_back(globalPoses[parentIndex]);
+            batchLocals.emplace_back(pose);
+            dirty[i] = PENDING_BATCH;
+        }
+        flushBatch();
+        std::fill(dirty.begin(), dirty.end(), CLEAN);
+        return updated;
+    }
+
+    uint32_t TransformHierarchy::Track(Lock<Read<TransformTree, TransformSnapshot>> lock, Entity entity) {
+        auto *existing = nodeIndex.find(entity);
+        if (existing) return *existing;
+
+        // Collect any untracked ancestors so they can be added before their children
+        std::vector<Entity> chain = {entity};
+        uint32_t parentIndex = NO_PARENT;
+        while (true) {
+            auto &tree = chain.back().Get<const TransformTree>(lock);
+            Entity parent = tree.parent.Get(lock);
+            if (!parent.Has<TransformTree>(lock)) {
+                if (tree.parent) hasOrphans = true;
+                break;
+            }
+            auto *parentNode = nodeIndex.find(parent);
+            if (parentNode) {
+                parentIndex = *parentNode;
+                break;
+            }
+            if (std::find(chain.begin(), chain.end(), parent) != chain.end()) {
+                Errorf("TransformTree parent loop detected at entity: %s", std::to_string(parent));
+                break;
+            }
+            chain.emplace_back(parent);
+        }
+
+        for (auto it = chain.rbegin(); it != chain.rend(); it++) {
+            uint32_t index = entities.size();
+            entities.emplace_back(*it);
+            parents.emplace_back(parentIndex);
+            if (it->Has<TransformSnapshot>(lock)) {
+                // Snapshots are kept up to date for untouched entities, so they can seed the cached pose
+                globalPoses.emplace_back(it->Get<const TransformSnapshot>(lock).globalPose);
+                dirty.emplace_back(CLEAN);
+            } else {
+                globalPoses.emplace_back();
+                dirty.emplace_back(DIRTY);
+            }
+            nodeIndex[*it] = index;
+            trackedCount++;
+            parentIndex = index;
+        }
+        return parentIndex;
+    }
+
+    uint32_t TransformHierarchy::FindParent(Lock<Read<TransformTree, TransformSnapshot>> lock,
+        const TransformTree &tree) {
+        Entity parent = tree.parent.Get(lock);
+        if (!parent.Has<TransformTree>(lock)) {
+            if (tree.parent) hasOrphans = true;
+            return NO_PARENT;
+        }
+        return Track(lock, parent);
+    }
+
+    void TransformHierarchy::Remove(Entity entity) {
+        auto *existing = nodeIndex.find(entity);
+        if (!existing) return;
+
+        entities[*existing] = {};
+        nodeIndex.erase(entity);
+        trackedCount--;
+        needsSort = true;
+    }
+
+    void TransformHierarchy::Sort(Lock<Read<TransformTree, TransformSnapshot>> lock) {
+        ZoneScoped;
+        // Re-resolve every parent link, since a removed parent may have been replaced by a new entity.
+        // Track() may append newly found parents while iterating.
+        hasOrphans = false;
+        for (size_t i = 0; i < entities.size(); i++) {
+            Entity ent = entities[i];
+            if (!ent) continue;
+            if (!ent.Has<TransformTree>(lock)) {
+                Remove(ent);
+                continue;
+            }
+            uint32_t parentIndex = FindParent(lock, ent.Get<const TransformTree>(lock));
+            if (parentIndex != parents[i]) {
+                parents[i] = parentIndex;
+                dirty[i] = DIRTY;
+            }
+        }
+
+        static const uint32_t UNKNOWN_DEPTH = ~0u;
+        static const uint32_t VISITING = ~0u - 1;
+        std::vector<uint32_t> depths(entities.size(), UNKNOWN_DEPTH);
+        std::vector<uint32_t> depthCounts;
+        std::vector<uint32_t> path;
+        for (size_t i = 0; i < entities.size(); i++) {
+            if (!entities[i] || depths[i] != UNKNOWN_DEPTH) continue;
+
+            // Walk up until a root or an already sorted ancestor is found
+            uint32_t depth = 0;
+            path.clear();
+            uint32_t index = i;
+            while (true) {
+                depths[index] = VISITING;
+                path.emplace_back(index);
+                uint32_t parentIndex = parents[index];
+                if (parentIndex == NO_PARENT) break;
+                if (depths[parentIndex] == VISITING) {
+                    Errorf("TransformTree parent loop detected at entity: %s", std::to_string(entities[index]));
+                    parents[index] = NO_PARENT;
+                    dirty[index] = DIRTY;
+                    break;
+                }
+                if (depths[parentIndex] != UNKNOWN_DEPTH) {
+                    depth = depths[parentIndex] + 1;
+                    break;
+                }
+                index = parentIndex;
+            }
+            for (auto it = path.rbegin(); it != path.rend(); it++) {
+                if (depth >= depthCounts.size()) depthCounts.resize(depth + 1);
+                depthCounts[depth]++;
+                depths[*it] = depth++;
+            }
+        }
+
+        // Counting sort by depth, keeping the existing relative order within each depth
+        uint32_t offset = 0;
+        for (auto &count : depthCounts) {
+            uint32_t start = offset;
+            offset += count;
+            count = start;
+        }
+
+        std::vector<uint32_t> newIndex(entities.size(), NO_PARENT);
+        for (size_t i = 0; i < entities.size(); i++) {
+            if (entities[i]) newIndex[i] = depthCounts[depths[i]]++;
+        }
+
+        std::vector<Entity> sortedEntities(offset);
+        std::vector<uint32_t> sortedParents(offset);
+        std::vector<Transform> sortedPoses(offset);
+        std::vector<uint8_t> sortedDirty(offset);
+        nodeIndex.clear();
+        for (size_t i = 0; i < entities.size(); i++) {
+            uint32_t index = newIndex[i];
+            if (index == NO_PARENT) continue;
+            sortedEntities[index] = entities[i];
+            sortedParents[index] = parents[i] == NO_PARENT ? NO_PARENT : newIndex[parents[i]];
+            sortedPoses[index] = globalPoses[i];
+            sortedDirty[index] = dirty[i];
+            nodeIndex[entities[i]] = index;
+        }
+        entities = std::move(sortedEntities);
+        parents = std::move(sortedParents);
+        globalPoses = std::move(sortedPoses);
+        dirty = std::move(sortedDirty);
+        trackedCount = offset;
+        needsSort = false;
+    }
+} // namespace ecs
@@ -0,0 +1,73 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "ecs/Ecs.hh"
+#include "ecs/components/Transform.h"
+#include "strayphotons/EntityMap.hh"
+
+#include <vector>
+
+namespace ecs {
+    /**
+     * A flattened copy of the TransformTree hierarchy, sorted by depth so that parents always come before children.
+     * Global poses are recalculated in a single linear sweep over the flat arrays, instead of walking the parent
+     * chain of every modified entity through EntityRef lookups.
+     *
+     * Pose changes only flag a node as dirty. Adding a leaf or reparenting under an earlier node is applied in place,
+     * while removals and reparenting under a later node re-sort the arrays on the next UpdateSnapshots() call.
+     */
+    class TransformHierarchy {
+    public:
+        // Should be called for every entity with a modified or newly added TransformTree
+        void MarkModified(Lock<Read<TransformTree, TransformSnapshot>> lock, Entity entity);
+
+        // Recalculates the global pose of every modified entity and all of its descendants, and writes them to
+        // TransformSnapshot. The returned list of updated entities is in parent-before-child order.
+        const std::vector<Entity> &UpdateSnapshots(Lock<Read<TransformTree>, Write<TransformSnapshot>> lock);
+
+        size_t Size() const {
+            return trackedCount;
+        }
+
+    private:
+        static constexpr uint32_t NO_PARENT = ~0u;
+
+        enum DirtyState : uint8_t {
+            CLEAN = 0,
+            DIRTY,
+            // Queued for composing with its parent, but not calculated yet
+            PENDING_BATCH,
+        };
+
+        uint32_t Track(Lock<Read<TransformTree, TransformSnapshot>> lock, Entity entity);
+        uint32_t FindParent(Lock<Read<TransformTree, TransformSnapshot>> lock, const TransformTree &tree);
+        void Remove(Entity entity);
+        void Sort(Lock<Read<TransformTree, TransformSnapshot>> lock);
+
+        // Parallel arrays indexed by node, removed nodes are left as null entities until the next Sort()
+        std::vector<Entity> entities;
+        std::vector<uint32_t> parents;
+        std::vector<Transform> globalPoses;
+        std::vector<uint8_t> dirty;
+
+        sp::EntityMap<uint32_t> nodeIndex;
+        size_t trackedCount = 0;
+
+        bool initialized = false;
+        bool needsSort = false;
+        // Set when a node's parent ref doesn't currently resolve, so new entities trigger a re-link
+        bool hasOrphans = false;
+
+        std::vector<Entity> updated;
+
+        // Scratch buffers for composing global poses with ComposeTransforms()
+        std::vector<uint32_t> batchNodes;
+        std::vector<Transform> batchParents, batchLocals, batchResults;
+    };
+} // namespace ecs
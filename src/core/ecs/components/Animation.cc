@@ -40,7 +40,9 @@ namespace ecs {
         auto &animation = ent.Get<Animation>(lock);
         if (animation.states.empty()) return;
 
-        auto &transform = ent.Get<TransformTree>(lock);
+        // Only write the transform if the pose changes, so idle animations don't generate TransformTree modifications
+        auto &currentPose = ent.Get<const TransformTree>(lock).pose;
+        Transform pose = currentPose;
 
         double currentState = SignalRef(ent, "animation_state").GetSignal(lock);
         double targetState = SignalRef(ent, "animation_target").GetSignal(lock);
@@ -56,15 +58,15 @@ namespace ecs {
         glm::vec3 dPos, scale;
         switch (animation.interpolation) {
         case InterpolationMode::Step:
-            transform.pose.SetPosition(nextState.pos);
-            if (isNormal(nextState.scale)) transform.pose.SetScale(nextState.scale);
+            pose.SetPosition(nextState.pos);
+            if (isNormal(nextState.scale)) pose.SetScale(nextState.scale);
             break;
         case InterpolationMode::Linear:
             dPos = nextState.pos - currState.pos;
-            transform.pose.SetPosition(currState.pos + state.completion * dPos);
+            pose.SetPosition(currState.pos + state.completion * dPos);
 
             scale = currState.scale + state.completion * (nextState.scale - currState.scale);
-            if (isNormal(scale)) transform.pose.SetScale(scale);
+            if (isNormal(scale)) pose.SetScale(scale);
             break;
         case InterpolationMode::Cubic:
             float tangentScale = state.direction * nextState.delay;
@@ -79,12 +81,14 @@ namespace ecs {
 
             auto pos = av1 * currState.pos + at1 * currState.tangentPos + av2 * nextState.pos +
                        at2 * nextState.tangentPos;
-            transform.pose.SetPosition(pos);
+            pose.SetPosition(pos);
 
             scale = av1 * currState.scale + at1 * currState.tangentScale + av2 * nextState.scale +
                     at2 * nextState.tangentScale;
-            if (isNormal(scale)) transform.pose.SetScale(scale);
+            if (isNormal(scale)) pose.SetScale(scale);
             break;
         }
+
+        if (pose != currentPose) ent.Get<TransformTree>(lock).pose = pose;
     }
 } // namespace ecs
@@ -92,6 +92,25 @@ namespace ecs {
         return true;
     }
 
+    std::optional<NameAtoms> NameAtoms::Find(const Name &name) {
+        auto scene = sp::StringAtom::Find(name.scene);
+        if (!scene) return {};
+        auto entity = sp::StringAtom::Find(name.entity);
+        if (!entity) return {};
+        NameAtoms atoms;
+        atoms.scene = *scene;
+        atoms.entity = *entity;
+        return atoms;
+    }
+
+    Name NameAtoms::ToName() const {
+        // Atoms are only created from valid names, so the strings don't need to be validated again
+        Name name;
+        name.scene = scene.View();
+        name.entity = entity.View();
+        return name;
+    }
+
     std::ostream &operator<<(std::ostream &out, const Name &v) {
         return out << v.String();
     }
@@ -103,4 +122,10 @@ namespace std {
         sp::hash_combine<size_t, string_view>(val, n.entity);
         return val;
     }
+
+    std::size_t hash<ecs::NameAtoms>::operator()(const ecs::NameAtoms &n) const {
+        auto val = hash<sp::StringAtom>()(n.scene);
+        sp::hash_combine(val, n.entity);
+        return val;
+    }
 } // namespace std
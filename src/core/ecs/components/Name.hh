@@ -8,9 +8,11 @@
 #pragma once
 
 #include "strayphotons/InlineString.hh"
+#include "strayphotons/StringAtom.hh"
 
 #include <functional>
 #include <iostream>
+#include <optional>
 #include <string>
 #include <string_view>
 
@@ -20,6 +22,7 @@ namespace sp {
 
 namespace ecs {
     struct Name;
+    struct NameAtoms;
     using EntityScope = Name;
 
 #ifdef __GNUC__
@@ -54,6 +57,9 @@ The special `"scoperoot"` alias can also be used inside a template to reference
 
         bool Parse(std::string_view relativeName, const EntityScope &scope);
 
+        // Interns the scene and entity strings
+        NameAtoms Atoms() const;
+
         std::string String() const {
             if (scene.empty()) return entity.str();
             std::string result;
@@ -74,6 +80,38 @@ The special `"scoperoot"` alias can also be used inside a template to reference
         }
     };
 
+    /**
+     * The interned form of a Name: 8 bytes that compare and hash as integers instead of 128 bytes of strings.
+     * Used as the key for name lookups, the strings are only materialized through ToName() for display and
+     * serialization.
+     */
+    struct NameAtoms {
+        sp::StringAtom scene, entity;
+
+        NameAtoms() {}
+        explicit NameAtoms(const Name &name) : scene(name.scene), entity(name.entity) {}
+
+        // Returns the atoms for name only if both its strings have already been interned
+        static std::optional<NameAtoms> Find(const Name &name);
+
+        Name ToName() const;
+
+        explicit operator bool() const {
+            return !entity.empty();
+        }
+
+        bool operator==(const NameAtoms &) const = default;
+        // Same lexical order as Name, equal atoms are resolved without comparing strings
+        bool operator<(const NameAtoms &other) const {
+            if (scene != other.scene) return scene.View() < other.scene.View();
+            return entity != other.entity && entity.View() < other.entity.View();
+        }
+    };
+
+    inline NameAtoms Name::Atoms() const {
+        return NameAtoms(*this);
+    }
+
     std::ostream &operator<<(std::ostream &out, const Name &v);
 } // namespace ecs
 
@@ -82,4 +120,9 @@ namespace std {
     struct hash<ecs::Name> {
         std::size_t operator()(const ecs::Name &n) const;
     };
+
+    template<>
+    struct hash<ecs::NameAtoms> {
+        std::size_t operator()(const ecs::NameAtoms &n) const;
+    };
 } // namespace std
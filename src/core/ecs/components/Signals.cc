@@ -18,7 +18,7 @@
 
 namespace ecs {
     SignalKey::SignalKey(const EntityRef &entity, const std::string_view &signalName)
-        : entity(entity), signalName(signalName) {
+        : entity(entity), signalName(signalName), signalAtom(signalName) {
         Assertf(signalName.find_first_of(",():/# ") == std::string::npos,
             "Signal name has invalid character: '%s'",
             std::string(signalName));
@@ -33,6 +33,7 @@ namespace ecs {
         if (i == std::string::npos) {
             entity = {};
             signalName.clear();
+            signalAtom = {};
             Errorf("Invalid signal has no entity/signal separator: %s", std::string(str));
             return false;
         }
@@ -40,11 +41,13 @@ namespace ecs {
         if (!entityName) {
             entity = {};
             signalName.clear();
+            signalAtom = {};
             Errorf("Invalid signal has bad entity name: %s", std::string(str));
             return false;
         }
         entity = entityName;
         signalName = str.substr(i + 1);
+        signalAtom = sp::StringAtom(signalName);
         return true;
     }
 
@@ -55,49 +58,136 @@ namespace ecs {
 
 namespace std {
     std::size_t hash<ecs::SignalKey>::operator()(const ecs::SignalKey &key) const {
-        auto val = sp::StringHash{}(key.signalName);
-        sp::hash_combine(val, key.entity.Name());
+        auto val = hash<sp::StringAtom>()(key.signalAtom);
+        sp::hash_combine(val, key.entity.Atoms());
         return val;
     }
 } // namespace std
 
 namespace ecs {
-    Signals::Signal::Signal() : value(-std::numeric_limits<double>::infinity()), expr(), lastValueDirty(true) {}
-    Signals::Signal::Signal(const SignalRef &ref, double value) : value(value), expr(), ref(ref) {
-        if (!std::isinf(value)) {
-            this->lastValue = value;
-            this->lastValueDirty = false;
-        } else {
-            this->lastValue = 0.0;
-            this->lastValueDirty = true;
+    void Signals::EdgeList::Add(size_t index, const WeakSignalRef &edge) {
+        auto &range = ranges[index];
+        if (range.count == range.capacity) {
+            uint32_t newCapacity = std::max(4u, range.capacity * 2);
+            if (range.offset + range.capacity == edges.size()) {
+                // The range is already at the end of the array, so it can grow in place
+                edges.resize(range.offset + newCapacity);
+            } else {
+                size_t newOffset = edges.size();
+                edges.resize(newOffset + newCapacity);
+                auto first = edges.begin() + range.offset;
+                std::move(first, first + range.count, edges.begin() + newOffset);
+                unused += range.capacity;
+                range.offset = newOffset;
+            }
+            range.capacity = newCapacity;
         }
+        edges[range.offset + range.count++] = edge;
+        if (unused > std::max<size_t>(1024, edges.size() / 2)) Compact();
     }
-    Signals::Signal::Signal(const SignalRef &ref, const SignalExpression &expr)
-        : value(-std::numeric_limits<double>::infinity()), expr(expr), ref(ref), lastValueDirty(true) {}
-    Signals::Signal::Signal(const SignalRef &ref, const SignalRef &subscriber)
-        : value(-std::numeric_limits<double>::infinity()), expr(), ref(ref), lastValueDirty(true) {
-        subscribers.emplace_back(subscriber.GetWeakRef());
+
+    void Signals::EdgeList::Clear(size_t index) {
+        auto &range = ranges[index];
+        auto first = edges.begin() + range.offset;
+        std::fill(first, first + range.count, WeakSignalRef());
+        range.count = 0;
     }
 
-    double Signals::Signal::Value(const DynamicLock<ReadSignalsLock> &lock, uint32_t depth) const {
-        if (!std::isinf(value)) {
-            return value;
+    void Signals::EdgeList::Release(size_t index) {
+        Clear(index);
+        unused += ranges[index].capacity;
+        ranges[index] = {};
+    }
+
+    void Signals::EdgeList::Compact() {
+        ZoneScoped;
+        sp::HeapVector<WeakSignalRef> packed;
+        packed.reserve(edges.size() - unused);
+        for (auto &range : ranges) {
+            if (range.count == 0) {
+                range = {};
+                continue;
+            }
+            auto first = edges.begin() + range.offset;
+            range.offset = packed.size();
+            packed.insert(packed.end(), first, first + range.capacity);
+        }
+        edges = std::move(packed);
+        unused = 0;
+        generation++;
+    }
+
+    void Signals::EdgeList::CopyFrom(const EdgeList &other, const sp::FlatSet<size_t> &indexes) {
+        if (generation != other.generation) {
+            *this = other;
+            return;
+        }
+        // Ranges are only appended to the end of the array between compactions, and each appended range belongs to
+        // a signal with dirty storage, so only the ranges of dirty signals need to be copied.
+        if (ranges.size() != other.ranges.size()) ranges.resize(other.ranges.size());
+        if (edges.size() != other.edges.size()) edges.resize(other.edges.size());
+        for (size_t index : indexes) {
+            auto &range = other.ranges[index];
+            ranges[index] = range;
+            auto first = other.edges.begin() + range.offset;
+            std::copy(first, first + range.capacity, edges.begin() + range.offset);
+        }
+        unused = other.unused;
+    }
+
+    double Signals::Evaluate(const DynamicLock<ReadSignalsLock> &lock, size_t index, uint32_t depth) const {
+        if (!std::isinf(values[index])) {
+            return values[index];
         } else {
-            return expr.Evaluate(lock, depth);
+            return exprs[index].Evaluate(lock, depth);
         }
     }
 
-    size_t Signals::NewSignal(const Lock<Write<Signals>> &lock, const SignalRef &ref, double value) {
+    void Signals::SetExpression(size_t index, const SignalExpression &expr) {
+        exprs[index] = expr;
+        programs[index] = exprs[index].program.get();
+    }
+
+    size_t Signals::AllocateSignal(const SignalRef &ref) {
         size_t index;
         if (freeIndexes.empty()) {
-            index = signals.size();
-            signals.emplace_back(ref, value);
+            index = Size();
+            values.emplace_back();
+            lastValues.emplace_back();
+            lastValueDirty.emplace_back();
+            programs.emplace_back();
+            refs.emplace_back();
+            exprs.emplace_back();
+            subscribers.ranges.emplace_back();
+            dependencies.ranges.emplace_back();
         } else {
             index = freeIndexes.top();
             freeIndexes.pop();
-            signals[index] = Signal(ref, value);
+        }
+        ResetSignal(index);
+        refs[index] = ref;
+        return index;
+    }
+
+    void Signals::ResetSignal(size_t index) {
+        values[index] = -std::numeric_limits<double>::infinity();
+        lastValues[index] = 0.0;
+        lastValueDirty[index] = true;
+        refs[index] = SignalRef();
+        SetExpression(index, SignalExpression());
+        subscribers.Release(index);
+        dependencies.Release(index);
+    }
+
+    size_t Signals::NewSignal(const Lock<Write<Signals>> &lock, const SignalRef &ref, double value) {
+        size_t index = AllocateSignal(ref);
+        values[index] = value;
+        if (!std::isinf(value)) {
+            lastValues[index] = value;
+            lastValueDirty[index] = false;
         }
         MarkStorageDirty(lock, index);
+        if (lastValueDirty[index]) QueueDirtyValue(index, 0);
         Entity ent = ref.GetEntity().Get(lock);
         Assertf(ent.Exists(lock), "Setting signal value on missing entity: %s", ref.GetEntity().Name().String());
         return index;
@@ -106,101 +196,71 @@ namespace ecs {
     size_t Signals::NewSignal(const Lock<Write<Signals>, ReadSignalsLock> &lock,
         const SignalRef &ref,
         const SignalExpression &expr) {
-        size_t index;
-        if (freeIndexes.empty()) {
-            index = signals.size();
-            signals.emplace_back(ref, expr);
-        } else {
-            index = freeIndexes.top();
-            freeIndexes.pop();
-            signals[index] = Signal(ref, expr);
-        }
+        size_t index = AllocateSignal(ref);
+        SetExpression(index, expr);
         MarkStorageDirty(lock, index);
+        QueueDirtyValue(index, 0);
         Entity ent = ref.GetEntity().Get(lock);
         Assertf(ent.Exists(lock), "Setting signal expression on missing entity: %s", ref.GetEntity().Name().String());
         return index;
     }
 
     size_t Signals::NewSignal(const Lock<Write<Signals>> &lock, const SignalRef &ref, const SignalRef &subscriber) {
-        size_t index;
-        if (freeIndexes.empty()) {
-            index = signals.size();
-            signals.emplace_back(ref, subscriber);
-        } else {
-            index = freeIndexes.top();
-            freeIndexes.pop();
-            signals[index] = Signal(ref, subscriber);
-        }
+        size_t index = AllocateSignal(ref);
+        subscribers.Add(index, subscriber.GetWeakRef());
         MarkStorageDirty(lock, index);
+        QueueDirtyValue(index, 0);
         return index;
     }
 
     void Signals::FreeSignal(const Lock<Write<Signals>> &lock, size_t index) {
-        if (index >= signals.size()) return;
-        Signal &signal = signals[index];
-        DebugAssertf(signal.subscribers.empty(), "Signals::FreeSignal index has subscribers");
+        if (index >= Size()) return;
+        DebugAssertf(subscribers.Get(index).empty(), "Signals::FreeSignal index has subscribers");
         MarkStorageDirty(lock, index);
-        if (signal.ref) {
-            if (!std::isinf(signal.lastValue)) signal.ref.MarkDirty(lock);
-            signal.ref.GetIndex() = std::numeric_limits<size_t>::max();
+        auto &ref = refs[index];
+        if (ref) {
+            if (!std::isinf(lastValues[index])) ref.MarkDirty(lock);
+            ref.GetIndex() = std::numeric_limits<size_t>::max();
         }
-        signal = Signal();
+        ResetSignal(index);
         freeIndexes.push(index);
     }
 
     void Signals::FreeEntitySignals(const Lock<Write<Signals>> &lock, Entity entity) {
         ZoneScoped;
         std::vector<size_t> updatedIndexes;
-        for (size_t i = 0; i < signals.size(); i++) {
-            Signal &signal = signals[i];
-            if (signal.ref && signal.ref.GetEntity() == entity) {
-                MarkStorageDirty(lock, i);
-                signal.value = -std::numeric_limits<double>::infinity();
-                signal.expr = SignalExpression();
-                signal.ref.UnsubscribeDependencies(lock);
-                if (signal.lastValue != 0.0 || signal.lastValueDirty) {
-                    signal.lastValue = 0.0;
-                    signal.ref.MarkDirty(lock);
-                    signal.lastValueDirty = false;
-                }
-                updatedIndexes.emplace_back(i);
-            }
-        }
-        for (size_t i : updatedIndexes) {
-            Signal &signal = signals[i];
-            if (signal.subscribers.empty()) {
-                DebugAssertf(i == signal.ref.GetIndex(), "FreeEntitySignals index missmatch");
-                signal.ref.GetIndex() = std::numeric_limits<size_t>::max();
-                signal = Signal();
-                freeIndexes.push(i);
-            }
+        for (size_t i = 0; i < refs.size(); i++) {
+            if (refs[i] && refs[i].GetEntity() == entity) updatedIndexes.emplace_back(i);
         }
+        ClearEntitySignals(lock, updatedIndexes);
     }
 
     void Signals::UpdateMissingEntitySignals(const Lock<Write<Signals>> &lock) {
         ZoneScoped;
         std::vector<size_t> updatedIndexes;
-        for (size_t i = 0; i < signals.size(); i++) {
-            Signal &signal = signals[i];
-            if (signal.ref && !signal.ref.GetEntity().Get(lock).Exists(lock)) {
-                MarkStorageDirty(lock, i);
-                signal.value = -std::numeric_limits<double>::infinity();
-                signal.expr = SignalExpression();
-                signal.ref.UnsubscribeDependencies(lock);
-                if (signal.lastValue != 0.0 || signal.lastValueDirty) {
-                    signal.lastValue = 0.0;
-                    signal.ref.MarkDirty(lock);
-                    signal.lastValueDirty = false;
-                }
-                updatedIndexes.emplace_back(i);
+        for (size_t i = 0; i < refs.size(); i++) {
+            if (refs[i] && !refs[i].GetEntity().Get(lock).Exists(lock)) updatedIndexes.emplace_back(i);
+        }
+        ClearEntitySignals(lock, updatedIndexes);
+    }
+
+    void Signals::ClearEntitySignals(const Lock<Write<Signals>> &lock, const std::vector<size_t> &indexes) {
+        for (size_t i : indexes) {
+            MarkStorageDirty(lock, i);
+            values[i] = -std::numeric_limits<double>::infinity();
+            SetExpression(i, SignalExpression());
+            refs[i].UnsubscribeDependencies(lock);
+            if (lastValues[i] != 0.0 || lastValueDirty[i]) {
+                lastValues[i] = 0.0;
+                refs[i].MarkDirty(lock);
+                lastValueDirty[i] = false;
             }
         }
-        for (size_t i : updatedIndexes) {
-            Signal &signal = signals[i];
-            if (signal.subscribers.empty()) {
-                DebugAssertf(i == signal.ref.GetIndex(), "UpdateMissingEntitySignals index missmatch");
-                signal.ref.GetIndex() = std::numeric_limits<size_t>::max();
-                signal = Signal();
+        for (size_t i : indexes) {
+            if (subscribers.Get(i).empty()) {
+                DebugAssertf(i == refs[i].GetIndex(), "Signals::ClearEntitySignals index missmatch");
+                refs[i].GetIndex() = std::numeric_limits<size_t>::max();
+                ResetSignal(i);
                 freeIndexes.push(i);
             }
         }
@@ -214,26 +274,60 @@ namespace ecs {
             signals.dirtyIndices.clear();
             signals.changeCount++;
         }
-        Assertf(index < signals.signals.size(), "Signals::MarkStorageDirty index out of range");
+        Assertf(index < signals.Size(), "Signals::MarkStorageDirty index out of range");
         signals.dirtyIndices.emplace(index);
     }
 
+    void Signals::QueueDirtyValue(size_t index, uint32_t depth) {
+        dirtyValues.emplace_back(DirtyValue{index, depth});
+        if (dirtyValues.size() > Size() * 2 + 64) {
+            // Signals may be updated on demand by SignalRef::GetSignal() between frames, leaving clean entries behind
+            sp::erase_if(dirtyValues, [&](auto &entry) {
+                return entry.index >= Size() || !lastValueDirty[entry.index];
+            });
+        }
+    }
+
     Signals &Signals::operator=(const Signals &other) {
         ZoneScoped;
+        // Signals are always marked as changed when they are queued, so the worklist only needs copying with changes.
+        // Entries removed without a change are already clean, and are skipped by UpdateDirtySignals().
+        if (other.changeCount != changeCount) dirtyValues = other.dirtyValues;
         if (other.changeCount == changeCount) {
             // Noop
-            DebugAssertf(signals.size() == other.signals.size() && dirtyIndices == other.dirtyIndices,
-                "Changes are different");
+            DebugAssertf(Size() == other.Size() && dirtyIndices == other.dirtyIndices, "Changes are different");
         } else if (other.changeCount == changeCount + 1) {
-            if (signals.size() != other.signals.size()) signals.resize(other.signals.size());
+            if (Size() != other.Size()) {
+                size_t count = other.Size();
+                values.resize(count);
+                lastValues.resize(count);
+                lastValueDirty.resize(count);
+                programs.resize(count);
+                refs.resize(count);
+                exprs.resize(count);
+            }
             dirtyIndices = other.dirtyIndices;
             for (size_t index : other.dirtyIndices) {
-                signals[index] = other.signals[index];
+                values[index] = other.values[index];
+                lastValues[index] = other.lastValues[index];
+                lastValueDirty[index] = other.lastValueDirty[index];
+                programs[index] = other.programs[index];
+                refs[index] = other.refs[index];
+                exprs[index] = other.exprs[index];
             }
+            subscribers.CopyFrom(other.subscribers, other.dirtyIndices);
+            dependencies.CopyFrom(other.dependencies, other.dirtyIndices);
             freeIndexes = other.freeIndexes;
         } else {
             dirtyIndices = other.dirtyIndices;
-            signals = other.signals;
+            values = other.values;
+            lastValues = other.lastValues;
+            lastValueDirty = other.lastValueDirty;
+            programs = other.programs;
+            refs = other.refs;
+            exprs = other.exprs;
+            subscribers = other.subscribers;
+            dependencies = other.dependencies;
             freeIndexes = other.freeIndexes;
         }
         changeCount = other.changeCount;
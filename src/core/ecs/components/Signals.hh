@@ -15,8 +15,12 @@
 #include "strayphotons/FlatSet.hh"
 #include "strayphotons/Hashing.hh"
 #include "strayphotons/InlineString.hh"
+#include "strayphotons/StringAtom.hh"
 
+#include <algorithm>
+#include <cmath>
 #include <robin_hood.h>
+#include <span>
 
 namespace ecs {
     namespace expression {
@@ -25,30 +29,98 @@ namespace ecs {
 
     static const size_t MAX_SIGNAL_BINDING_DEPTH = 10;
 
+    /**
+     * Live signal storage, indexed by SignalRef::GetIndex().
+     *
+     * Each field is stored in its own array so per-frame updates only touch the values they read and write.
+     * A signal's value is -infinity when it is unset, in which case its expression is evaluated instead.
+     */
     struct Signals {
-        struct Signal {
-            double value;
-            SignalExpression expr;
-            SignalRef ref;
-
-            double lastValue = 0.0;
-            bool lastValueDirty = true;
-            std::vector<WeakSignalRef> subscribers;
-            std::vector<WeakSignalRef> dependencies;
-
-            Signal();
-            Signal(const SignalRef &ref, double value);
-            Signal(const SignalRef &ref, const SignalExpression &expr);
-            Signal(const SignalRef &ref, const SignalRef &subscriber);
-
-            double Value(const DynamicLock<ReadSignalsLock> &lock, uint32_t depth = 0) const;
+        /**
+         * The subscriber or dependency lists of every signal, packed into a single array.
+         *
+         * Each signal owns a range of the array with some spare capacity. A range that outgrows its capacity is moved
+         * to the end of the array, and the array is compacted once enough of it is unused.
+         * Callers must mark the signal's storage dirty after modifying its list.
+         */
+        struct EdgeList {
+            struct Range {
+                uint32_t offset = 0;
+                uint32_t count = 0;
+                uint32_t capacity = 0;
+            };
+
+            sp::HeapVector<Range> ranges;
+            sp::HeapVector<WeakSignalRef> edges;
+            // Number of edge slots not owned by any range
+            size_t unused = 0;
+            // Incremented each time the array is compacted, which moves every range
+            uint32_t generation = 0;
+
+            std::span<const WeakSignalRef> Get(size_t index) const {
+                auto &range = ranges[index];
+                return std::span(edges.data() + range.offset, range.count);
+            }
+
+            void Add(size_t index, const WeakSignalRef &edge);
+            // Removes matching edges while preserving the order of the rest, returns the number of edges removed
+            template<typename Predicate>
+            size_t EraseIf(size_t index, Predicate &&pred) {
+                auto &range = ranges[index];
+                auto first = edges.begin() + range.offset;
+                auto last = std::remove_if(first, first + range.count, pred);
+                size_t removed = (first + range.count) - last;
+                std::fill(last, first + range.count, WeakSignalRef());
+                range.count -= removed;
+                return removed;
+            }
+            void Clear(size_t index);
+            // Returns the range's capacity to the unused pool
+            void Release(size_t index);
+            void Compact();
+            // Copies the lists of the given indexes from other, or every list if other has been compacted since
+            void CopyFrom(const EdgeList &other, const sp::FlatSet<size_t> &indexes);
+        };
+
+        struct DirtyValue {
+            size_t index;
+            // Binding depth the signal was marked dirty at, subscribers are queued after their dependencies
+            uint32_t depth;
         };
 
         uint32_t changeCount = 0;
-        sp::HeapVector<Signal> signals;
+
+        // Values read and written every frame
+        sp::HeapVector<double> values;
+        sp::HeapVector<double> lastValues;
+        sp::HeapVector<bool> lastValueDirty;
+        // Points into exprs[i].program, nullptr if the signal has no compiled expression
+        sp::HeapVector<const expression::Program *> programs;
+
+        // Mostly accessed when signals are created, rebound, or freed
+        sp::HeapVector<SignalRef> refs;
+        sp::HeapVector<SignalExpression> exprs;
+        EdgeList subscribers;
+        EdgeList dependencies;
+
         sp::FlatSet<size_t> dirtyIndices;
+        // Signals with a dirty lastValue, updated once per frame by SignalManager::UpdateDirtySignals()
+        sp::HeapVector<DirtyValue> dirtyValues;
         std::priority_queue<size_t, sp::HeapVector<size_t>, std::greater<size_t>> freeIndexes;
 
+        size_t Size() const {
+            return refs.size();
+        }
+
+        bool IsCacheable(size_t index) const {
+            return !std::isinf(values[index]) || exprs[index].IsCacheable();
+        }
+
+        // Returns the signal's value if set, otherwise evaluates its expression
+        double Evaluate(const DynamicLock<ReadSignalsLock> &lock, size_t index, uint32_t depth = 0) const;
+
+        void SetExpression(size_t index, const SignalExpression &expr);
+
         size_t NewSignal(const Lock<Write<Signals>> &lock, const SignalRef &ref, double value);
         size_t NewSignal(const Lock<Write<Signals>, ReadSignalsLock> &lock,
             const SignalRef &ref,
@@ -59,13 +131,21 @@ namespace ecs {
         void UpdateMissingEntitySignals(const Lock<Write<Signals>> &lock);
 
         void MarkStorageDirty(const Lock<Write<Signals>> &lock, size_t index);
+        void QueueDirtyValue(size_t index, uint32_t depth);
 
         Signals &operator=(const Signals &other);
+
+    private:
+        size_t AllocateSignal(const SignalRef &ref);
+        void ResetSignal(size_t index);
+        void ClearEntitySignals(const Lock<Write<Signals>> &lock, const std::vector<size_t> &indexes);
     };
 
     struct SignalKey {
         EntityRef entity;
         sp::HeapString signalName;
+        // Interned signalName, keys compare and hash by the entity's and signal's atoms
+        sp::StringAtom signalAtom;
 
         SignalKey() {}
         SignalKey(const EntityRef &entity, const std::string_view &signalName);
@@ -82,9 +162,14 @@ namespace ecs {
             return entity && !signalName.empty();
         }
 
-        bool operator==(const SignalKey &) const = default;
+        bool operator==(const SignalKey &other) const {
+            return signalAtom == other.signalAtom && entity.Atoms() == other.entity.Atoms();
+        }
         bool operator<(const SignalKey &other) const {
-            return entity == other.entity ? signalName < other.signalName : entity < other.entity;
+            auto atoms = entity.Atoms();
+            auto otherAtoms = other.entity.Atoms();
+            if (atoms != otherAtoms) return atoms < otherAtoms;
+            return signalAtom != other.signalAtom && signalName < other.signalName;
         }
     };
 
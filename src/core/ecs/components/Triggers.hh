@@ -8,6 +8,7 @@
 #pragma once
 
 #include "ecs/Components.hh"
+#include "ecs/SignalRef.hh"
 #include "strayphotons/EnumTypes.hh"
 #include "strayphotons/FlatSet.hh"
 
@@ -23,10 +24,10 @@ namespace ecs {
 
     enum class TriggerShape : uint8_t { Box = 0, Sphere = 1 };
 
-    static sp::EnumArray<std::string, TriggerGroup> TriggerGroupSignalNames = {
-        "trigger_player_count",
-        "trigger_object_count",
-        "trigger_magnetic_count",
+    static constexpr sp::EnumArray<SignalName, TriggerGroup> TriggerGroupSignalNames = {
+        SignalName("trigger_player_count"),
+        SignalName("trigger_object_count"),
+        SignalName("trigger_magnetic_count"),
     };
 
     static sp::EnumArray<std::pair<std::string, std::string>, TriggerGroup> TriggerGroupEventNames = {
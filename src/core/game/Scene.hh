@@ -7,16 +7,19 @@
 
 #pragma once
 
+#include "common/ArenaAllocator.hh"
 #include "ecs/Ecs.hh"
 #include "ecs/EntityRef.hh"
 #include "ecs/components/Name.hh"
 #include "ecs/components/SceneInfo.hh"
 #include "ecs/components/SceneProperties.hh"
 #include "game/SceneRef.hh"
+#include "strayphotons/EntityMap.hh"
 
 namespace sp {
     class Asset;
     struct SceneMetadata;
+    class StagingChangeTracker;
 
     class Scene {
     public:
@@ -26,6 +29,20 @@ namespace sp {
 
         std::shared_ptr<const SceneMetadata> data;
 
+        struct ApplyStats {
+            size_t entities = 0;
+            size_t builtEntities = 0;
+            chrono_clock::duration buildTime = {};
+            chrono_clock::duration applyTime = {};
+            // Per-entity lists only, component data is allocated on the global heap
+            ArenaStats arena;
+        };
+
+        // Should only be called from SceneManager thread
+        const ApplyStats &GetLastApplyStats() const {
+            return lastApplyStats;
+        }
+
     private:
         Scene(SceneMetadata &&metadata, std::shared_ptr<const Asset> asset = nullptr);
         friend class SceneManager;
@@ -40,6 +57,15 @@ namespace sp {
         std::unordered_map<ecs::Name, ecs::Entity> namedEntities;
         std::vector<ecs::EntityRef> references;
 
+        struct AppliedEntity {
+            uint64_t version = 0;
+            size_t chainHash = 0;
+        };
+        // The staging version and entity chain each root staging entity had when it was last applied to live
+        EntityMap<AppliedEntity> appliedEntities;
+
+        ApplyStats lastApplyStats;
+
     public:
         // ==== Below functions are defined in game module: game/game/Scene.cc
 
@@ -76,7 +102,11 @@ namespace sp {
             const ecs::Lock<ecs::AddRemove> &)>;
 
         // Should only be called from SceneManager thread
-        void ApplyScene(bool resetLive = false, SceneApplyCallback callback = nullptr);
+        // If stagingChanges is provided, entities that haven't changed since the last apply are skipped,
+        // unless resetLive is set.
+        void ApplyScene(bool resetLive = false,
+            SceneApplyCallback callback = nullptr,
+            StagingChangeTracker *stagingChanges = nullptr);
 
         // Should only be called from SceneManager thread
         void RemoveScene(ecs::Lock<ecs::AddRemove> staging, ecs::Lock<ecs::AddRemove> live);
@@ -40,6 +40,7 @@ SP_EXPORT sp_game_t *sp_game_init(int argc, char **argv) {
             ("gpu", "Specify a graphics device ID to use (index or vendor:device)", value<std::string>())
             ("with-validation-layers", "Enable Vulkan validation layers")
             ("c,command", "Run a console command on init", value<std::vector<std::string>>())
+            ("affinity", "Thread core pinning policy (See g.ThreadAffinity)", value<std::string>())
             ("v,verbose", "Enable debug logging")
             ("log", "Set the path to the log output file", value<std::string>());
         // clang-format on
@@ -6,11 +6,14 @@
  */
 
 #include "assets/JsonHelpers.hh"
+#include "common/FramePipeline.hh"
 #include "common/Tracing.hh"
 #include "ecs/EcsImpl.hh"
 #include "ecs/SignalManager.hh"
 #include "game/GameEntities.hh"
 #include "game/SceneManager.hh"
+#include "strayphotons/AsyncTask.hh"
+#include "strayphotons/ContentionProfiler.hh"
 
 #ifdef SP_PHYSICS_SUPPORT_PHYSX
     #include "physx/PhysxManager.hh"
@@ -290,5 +293,71 @@ namespace sp {
                     Errorf("Invalid signal expression: %s", exprStr);
                 }
             });
+
+        funcs.Register("printframepipeline", "Print out per-phase frame pipeline timing (See g.FramePipeline)", []() {
+            static const std::array<const char *, FRAME_PHASE_COUNT> phaseNames = {"Logic", "Physics", "Render"};
+            auto stats = GetFramePipeline().GetStats();
+            Logf("Frame pipeline %s", stats.enabled ? "enabled" : "disabled");
+            for (size_t i = 0; i < FRAME_PHASE_COUNT; i++) {
+                auto &phase = stats.phases[i];
+                Logf("  %s: frame %llu, %u fps, frame %.3fms, wait avg %.3fms max %.3fms, %u timeouts",
+                    phaseNames[i],
+                    phase.lastFrame,
+                    phase.framesPerSecond,
+                    std::chrono::duration<double, std::milli>(phase.averageFrameTime).count(),
+                    std::chrono::duration<double, std::milli>(phase.averageWaitTime).count(),
+                    std::chrono::duration<double, std::milli>(phase.maxWaitTime).count(),
+                    phase.timeouts);
+            }
+        });
+
+        funcs.Register("printasynctasks", "Print AsyncTask coroutine frame pool statistics", []() {
+            auto stats = GetCoroutineFrameStats();
+            Logf("AsyncTask coroutines: %llu frames allocated, %llu reused from pool, %llu queued resumes",
+                stats.allocated,
+                stats.reused,
+                stats.queuedResumes);
+        });
+
+#ifdef SP_CONTENTION_PROFILING
+        funcs.Register("printcontention",
+            "Print lock contention statistics for LockFreeMutex and ECS transactions (See also: resetcontention)",
+            []() {
+                auto toMs = [](chrono_clock::duration d) {
+                    return std::chrono::duration<double, std::milli>(d).count();
+                };
+                Logf("Lock contention (waits <1us, <4us, <16us, <64us, <256us, <1ms, <4ms, >=4ms):");
+                for (auto &site : contention::GetAllStats()) {
+                    if (site.contended == 0) continue;
+                    auto &h = site.waitHistogram;
+                    Logf("  %s: %llu/%llu contended, %llu spins, wait total %.3fms max %.3fms [%llu %llu %llu %llu "
+                         "%llu %llu %llu %llu]",
+                        site.name,
+                        site.contended,
+                        site.acquires,
+                        site.spins,
+                        toMs(site.totalWait),
+                        toMs(site.maxWait),
+                        h[0],
+                        h[1],
+                        h[2],
+                        h[3],
+                        h[4],
+                        h[5],
+                        h[6],
+                        h[7]);
+                }
+                Logf("Top contending call sites:");
+                for (auto &callSite : contention::GetTopCallSites(10)) {
+                    Logf("  %s: %llu waits, %.3fms", callSite.siteName, callSite.contended, toMs(callSite.totalWait));
+                    for (auto &frame : callSite.frames) {
+                        if (!frame.empty()) Logf("    %s", frame);
+                    }
+                }
+            });
+        funcs.Register("resetcontention", "Reset lock contention statistics (See also: printcontention)", []() {
+            contention::ResetStats();
+        });
+#endif
     }
 } // namespace sp
@@ -649,12 +649,13 @@ namespace sp {
                 }
                 ImGui::Text("Binding eval = %.4f", binding.Evaluate(lock));
             }
-            auto &signals = lock.Get<ecs::Signals>().signals;
+            auto &signals = lock.Get<ecs::Signals>();
             auto &index = ref.GetIndex();
-            if (index < signals.size()) {
-                auto &signal = signals[index];
+            if (index < signals.Size()) {
                 if (ref.IsCacheable(lock)) {
-                    ImGui::Text("Cached value: %.4f %s", signal.lastValue, signal.lastValueDirty ? " (dirty)" : "");
+                    ImGui::Text("Cached value: %.4f %s",
+                        signals.lastValues[index],
+                        signals.lastValueDirty[index] ? " (dirty)" : "");
                 } else {
                     ImGui::TextUnformatted("Signal uncacheable");
                 }
@@ -663,8 +664,9 @@ namespace sp {
                     ImGui::Text("Node cacheable: %s", node->uncacheable ? "false" : "true");
                     ImGui::Text("Node references: %lu", node->references.size());
                 }
-                ImGui::Text("Subscribers: %lu", signal.subscribers.size());
-                for (auto &sub : signal.subscribers) {
+                auto subscribers = signals.subscribers.Get(index);
+                ImGui::Text("Subscribers: %lu", subscribers.size());
+                for (auto &sub : subscribers) {
                     auto subscriber = ecs::SignalRef(sub.lock());
                     if (subscriber) {
                         text = subscriber.String();
@@ -673,8 +675,9 @@ namespace sp {
                         }
                     }
                 }
-                ImGui::Text("Dependencies: %lu", signal.dependencies.size());
-                for (auto &dep : signal.dependencies) {
+                auto dependencies = signals.dependencies.Get(index);
+                ImGui::Text("Dependencies: %lu", dependencies.size());
+                for (auto &dep : dependencies) {
                     auto dependency = ecs::SignalRef(dep.lock());
                     if (dependency) {
                         text = dependency.String();
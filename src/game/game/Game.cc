@@ -16,6 +16,7 @@
 #include "game/CGameContext.hh"
 #include "game/SceneManager.hh"
 #include "strayphotons/Logging.hh"
+#include "strayphotons/ThreadAffinity.hh"
 
 #include <atomic>
 #include <cxxopts.hpp>
@@ -44,6 +45,13 @@ namespace sp {
             lock.Set<ecs::Signals>();
         }
 
+        if (options.count("affinity")) {
+            // Apply the policy before any more threads are started, GameLogic keeps it in sync with the CVar
+            auto affinity = options["affinity"].as<std::string>();
+            GetConsoleManager().ParseAndExecute("g.ThreadAffinity " + affinity);
+            SetThreadAffinityPolicy(affinity);
+        }
+
         std::string assetsPath = "";
         if (options.count("assets")) assetsPath = options["assets"].as<std::string>();
         sp::Assets().StartThread(assetsPath);
@@ -11,15 +11,37 @@
 #include "console/Console.hh"
 #include "ecs/EcsImpl.hh"
 #include "ecs/ScriptManager.hh"
+#include "ecs/SignalManager.hh"
+#include "ecs/SignalRefCache.hh"
+#include "strayphotons/ContentionProfiler.hh"
 #include "strayphotons/LockFreeEventQueue.hh"
+#include "strayphotons/ThreadAffinity.hh"
 #include "strayphotons/input/BindingNames.hh"
 #include "strayphotons/input/KeyCodes.hh"
 
 namespace sp {
     static CVar<uint32_t> CVarLogicFPS("g.LogicFPS", 144, "Target frame rate for game logic scripts (0 for unlimited)");
+    static CVar<uint32_t> CVarLogicFixedStep("g.LogicFixedStep",
+        0,
+        "Run game logic on a fixed timeline, catching up at most N missed frames (0 to disable)");
+    static CVar<uint32_t> CVarLogicSpinWait("g.LogicSpinWait",
+        0,
+        "Microseconds to spin before each fixed-step logic frame for precise timing (0 to only sleep)");
+    static CVar<bool> CVarFramePipeline("g.FramePipeline",
+        false,
+        "Pipeline logic, physics, and render frames using phase barriers instead of running them freely");
+    static CVar<bool> CVarBatchSignals("g.BatchSignals",
+        true,
+        "Update dirty signal bindings with the same expression shape together");
+
+    static CVar<std::string> CVarThreadAffinity("g.ThreadAffinity",
+        "",
+        "Thread core pinning policy, e.g. AudioManager=3,GameLogic=2,reserve=2-3,numa=auto (See also: --affinity)");
 
     GameLogic::GameLogic(LockFreeEventQueue<ecs::Event> &windowInputQueue)
         : RegisteredThread("GameLogic", CVarLogicFPS.Get(), true), windowInputQueue(windowInputQueue) {
+        SetFramePhase(FramePhase::Logic);
+
         funcs.Register<unsigned int>("steplogic",
             "Advance the game logic by N frames, default is 1",
             [this](unsigned int arg) {
@@ -31,6 +53,22 @@ namespace sp {
         funcs.Register("resumelogic", "Pause the game logic thread (See also: pauselogic)", [this] {
             this->Pause(false);
         });
+        funcs.Register("printtransactions",
+            "Print queued ECS transactions and lock acquisitions per logic frame since the last call",
+            [this] {
+                auto stats = ecs::GetTransactionQueueStats();
+                uint64_t frames = logicFrameCount - printedLogicFrameCount;
+                uint64_t queued = stats.queued - printedTransactionStats.queued;
+                uint64_t acquisitions = stats.lockAcquisitions - printedTransactionStats.lockAcquisitions;
+                printedTransactionStats = stats;
+                printedLogicFrameCount += frames;
+
+                double perFrame = std::max<uint64_t>(1, frames);
+                Logf("Transaction queue over %u logic frames: %.2f queued/frame, %.2f lock acquisitions/frame",
+                    frames,
+                    queued / perFrame,
+                    acquisitions / perFrame);
+            });
     }
 
     void GameLogic::StartThread(bool startPaused) {
@@ -44,6 +82,10 @@ namespace sp {
         } else {
             interval = std::chrono::nanoseconds(0);
         }
+        auto maxCatchUp = CVarLogicFixedStep.Get();
+        SetFixedStep(maxCatchUp > 0, maxCatchUp, std::chrono::microseconds(CVarLogicSpinWait.Get()));
+        GetFramePipeline().SetEnabled(CVarFramePipeline.Get());
+        if (CVarThreadAffinity.Changed()) SetThreadAffinityPolicy(CVarThreadAffinity.Get(true));
         return true;
     }
 
@@ -52,6 +94,28 @@ namespace sp {
         ZoneScoped;
         static const ecs::EntityRef keyboardEntity = ecs::Name("input", "keyboard");
         static const ecs::EntityRef mouseEntity = ecs::Name("input", "mouse");
+        static const robin_hood::unordered_node_map<KeyCode, std::string> keySignalStrings = [] {
+            robin_hood::unordered_node_map<KeyCode, std::string> names;
+            for (auto &[keyCode, keyName] : KeycodeNameLookup) {
+                names.emplace(keyCode, INPUT_SIGNAL_KEYBOARD_KEY_BASE + keyName);
+            }
+            return names;
+        }();
+        // Hashed once up front, the names point into keySignalStrings which is never modified
+        static const robin_hood::unordered_flat_map<KeyCode, ecs::SignalName> keySignalNames = [] {
+            robin_hood::unordered_flat_map<KeyCode, ecs::SignalName> names;
+            for (auto &[keyCode, signalName] : keySignalStrings) {
+                names.emplace(keyCode, ecs::SignalName(signalName));
+            }
+            return names;
+        }();
+        static const ecs::SignalName mouseCursorX(INPUT_SIGNAL_MOUSE_CURSOR_X);
+        static const ecs::SignalName mouseCursorY(INPUT_SIGNAL_MOUSE_CURSOR_Y);
+        static const ecs::SignalName mouseButtonLeft(INPUT_SIGNAL_MOUSE_BUTTON_LEFT);
+        static const ecs::SignalName mouseButtonMiddle(INPUT_SIGNAL_MOUSE_BUTTON_MIDDLE);
+        static const ecs::SignalName mouseButtonRight(INPUT_SIGNAL_MOUSE_BUTTON_RIGHT);
+        // Only accessed while holding the Signals write lock, which both the logic and physics threads take
+        static ecs::SignalRefCache signalRefs;
 
         auto keyboard = keyboardEntity.Get(lock);
         auto mouse = mouseEntity.Get(lock);
@@ -70,7 +134,7 @@ namespace sp {
                     std::string eventName = INPUT_EVENT_KEYBOARD_KEY_BASE + keyName->second;
                     ecs::EventBindings::SendEvent(lock, keyboardEntity, ecs::Event{eventName, keyboard, true});
 
-                    ecs::SignalRef signalRef(keyboard, INPUT_SIGNAL_KEYBOARD_KEY_BASE + keyName->second);
+                    auto signalRef = signalRefs.Get(lock, keyboard, keySignalNames.at(keyCode));
                     signalRef.SetValue(lock, 1.0);
                 }
             } else if (event.name == INPUT_EVENT_KEYBOARD_KEY_UP) {
@@ -80,31 +144,31 @@ namespace sp {
                     std::string eventName = INPUT_EVENT_KEYBOARD_KEY_BASE + keyName->second;
                     ecs::EventBindings::SendEvent(lock, keyboardEntity, ecs::Event{eventName, keyboard, false});
 
-                    ecs::SignalRef signalRef(keyboard, INPUT_SIGNAL_KEYBOARD_KEY_BASE + keyName->second);
+                    auto signalRef = signalRefs.Get(lock, keyboard, keySignalNames.at(keyCode));
                     signalRef.ClearValue(lock);
                 }
             } else if (event.name == INPUT_EVENT_MOUSE_POSITION) {
                 auto &mousePos = ecs::EventData::Get<glm::vec2>(event.data);
-                ecs::SignalRef refX(mouse, INPUT_SIGNAL_MOUSE_CURSOR_X);
-                ecs::SignalRef refY(mouse, INPUT_SIGNAL_MOUSE_CURSOR_Y);
+                auto refX = signalRefs.Get(lock, mouse, mouseCursorX);
+                auto refY = signalRefs.Get(lock, mouse, mouseCursorY);
                 refX.SetValue(lock, mousePos.x);
                 refY.SetValue(lock, mousePos.y);
             } else if (event.name == INPUT_EVENT_MOUSE_LEFT_CLICK) {
-                ecs::SignalRef signalRef(mouse, INPUT_SIGNAL_MOUSE_BUTTON_LEFT);
+                auto signalRef = signalRefs.Get(lock, mouse, mouseButtonLeft);
                 if (ecs::EventData::Get<bool>(event.data)) {
                     signalRef.SetValue(lock, 1.0);
                 } else {
                     signalRef.ClearValue(lock);
                 }
             } else if (event.name == INPUT_EVENT_MOUSE_MIDDLE_CLICK) {
-                ecs::SignalRef signalRef(mouse, INPUT_SIGNAL_MOUSE_BUTTON_MIDDLE);
+                auto signalRef = signalRefs.Get(lock, mouse, mouseButtonMiddle);
                 if (ecs::EventData::Get<bool>(event.data)) {
                     signalRef.SetValue(lock, 1.0);
                 } else {
                     signalRef.ClearValue(lock);
                 }
             } else if (event.name == INPUT_EVENT_MOUSE_RIGHT_CLICK) {
-                ecs::SignalRef signalRef(mouse, INPUT_SIGNAL_MOUSE_BUTTON_RIGHT);
+                auto signalRef = signalRefs.Get(lock, mouse, mouseButtonRight);
                 if (ecs::EventData::Get<bool>(event.data)) {
                     signalRef.SetValue(lock, 1.0);
                 } else {
@@ -125,11 +189,21 @@ namespace sp {
         {
             ZoneScopedN("UpdateSignals");
             auto lock = ecs::StartTransaction<ecs::Write<ecs::Signals>, ecs::ReadAll>();
-            auto &signals = lock.Get<const ecs::Signals>().signals;
-            for (size_t index = 0; index < signals.size(); index++) {
-                auto &signal = signals[index];
-                if (signal.ref && signal.lastValueDirty) signal.ref.UpdateDirtySubscribers(lock);
-            }
+            auto signalStats = ecs::GetSignalManager().UpdateDirtySignals(lock, CVarBatchSignals.Get());
+            TracyPlot("SignalsVisited", (int64_t)signalStats.visited);
+            TracyPlot("SignalsEvaluated", (int64_t)signalStats.evaluated);
+            TracyPlot("SignalsBatched", (int64_t)signalStats.batched);
+        }
+        {
+            auto stats = ecs::GetTransactionQueueStats();
+            TracyPlot("TransactionsQueued", (int64_t)(stats.queued - plottedTransactionStats.queued));
+            TracyPlot("TransactionLockAcquisitions",
+                (int64_t)(stats.lockAcquisitions - plottedTransactionStats.lockAcquisitions));
+            plottedTransactionStats = stats;
+            logicFrameCount++;
         }
+#ifdef SP_CONTENTION_PROFILING
+        contention::PlotStats();
+#endif
     }
 } // namespace sp
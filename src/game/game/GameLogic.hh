@@ -14,6 +14,8 @@
 #include "ecs/components/Events.hh"
 #include "strayphotons/LockFreeEventQueue.hh"
 
+#include <atomic>
+
 namespace sp {
 
     class GameLogic : public RegisteredThread {
@@ -31,6 +33,11 @@ namespace sp {
 
         LockFreeEventQueue<ecs::Event> &windowInputQueue;
 
+        std::atomic_uint64_t logicFrameCount = 0;
+        // Last stats plotted by the logic thread, and last stats printed by the console
+        ecs::TransactionQueueStats plottedTransactionStats, printedTransactionStats;
+        uint64_t printedLogicFrameCount = 0;
+
         CFuncCollection funcs;
     };
 
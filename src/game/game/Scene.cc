@@ -8,13 +8,23 @@
 #include "game/Scene.hh"
 
 #include "common/Tracing.hh"
+#include "console/CVar.hh"
 #include "ecs/EntityReferenceManager.hh"
 #include "ecs/ScriptManager.hh"
 #include "ecs/components/Transform.h"
 #include "game/SceneImpl.hh"
+#include "game/StagingChangeTracker.hh"
+#include "strayphotons/Hashing.hh"
+#include "strayphotons/JobSystem.hh"
 #include "strayphotons/Utility.hh"
 
+#include <algorithm>
+
 namespace sp {
+    static CVar<uint32_t> CVarApplySceneChunkSize("g.ApplySceneChunkSize",
+        64,
+        "Minimum number of entities flattened per job when applying a scene");
+
     std::shared_ptr<Scene> Scene::New(ecs::Lock<ecs::AddRemove> stagingLock,
         const std::string &name,
         const std::string &path,
@@ -196,7 +206,7 @@ namespace sp {
         ent.Destroy(stagingLock);
     }
 
-    void Scene::ApplyScene(bool resetLive, SceneApplyCallback callback) {
+    void Scene::ApplyScene(bool resetLive, SceneApplyCallback callback, StagingChangeTracker *stagingChanges) {
         ZoneScoped;
         ZoneStr(data->name);
         Debugf("Applying scene: %s", data->name);
@@ -212,9 +222,12 @@ namespace sp {
             data->name,
             data->sceneEntity.Name().String());
 
+        // Per-entity temporaries are released together at the end of the apply
+        ArenaAllocator applyArena;
+
         // Build a flattened list of entities to apply from the staging ECS
-        std::vector<ecs::Entity> entities;
-        std::vector<ecs::FlatEntity> components;
+        std::pmr::vector<ecs::Entity> entities(applyArena.Resource());
+        std::pmr::vector<ecs::FlatEntity> components(applyArena.Resource());
         for (auto &e : staging.EntitiesWith<ecs::SceneInfo>()) {
             auto &sceneInfo = e.Get<ecs::SceneInfo>(staging);
             if (sceneInfo.scene != *this) continue;
@@ -229,11 +242,56 @@ namespace sp {
             entities.emplace_back(e);
         }
         components.resize(entities.size());
+
+        // Entities with the same staging chain and no staging changes since the last apply don't need to be rebuilt
+        uint64_t stagingVersion = 0;
+        if (stagingChanges && stagingChanges->Watching()) stagingVersion = stagingChanges->Poll(staging);
+        std::pmr::vector<size_t> chainHashes(entities.size(), applyArena.Resource());
+        std::pmr::vector<bool> unchanged(entities.size(), applyArena.Resource());
         for (size_t i = 0; i < entities.size(); i++) {
-            scene_util::BuildEntity(ecs::Lock<ecs::ReadAll>(staging), entities[i], components[i]);
+            uint64_t version = 0;
+            ecs::Entity stagingId = entities[i];
+            while (stagingId.Has<ecs::SceneInfo>(staging)) {
+                auto &stagingInfo = stagingId.Get<const ecs::SceneInfo>(staging);
+                hash_combine(chainHashes[i], stagingId);
+                if (stagingVersion > 0) {
+                    version = std::max(version, stagingChanges->Version(stagingId));
+                    // Scene properties are applied to root transforms, so include changes to the scene entity
+                    if (stagingInfo.scene) {
+                        auto sceneId = stagingInfo.scene.data->sceneEntity.Get(staging);
+                        version = std::max(version, stagingChanges->Version(sceneId));
+                    }
+                }
+                stagingId = stagingInfo.nextStagingId;
+            }
+
+            if (stagingVersion > 0 && !resetLive) {
+                auto *applied = appliedEntities.find(entities[i]);
+                if (applied && applied->version >= version && applied->chainHash == chainHashes[i]) {
+                    unchanged[i] = true;
+                }
+            }
         }
+        auto buildStart = chrono_clock::now();
+        {
+            ZoneScopedN("BuildEntities");
+            // BuildEntity only reads from staging, so entities are flattened in parallel.
+            // Script instances are created afterwards in a deterministic order.
+            ecs::Lock<ecs::ReadAll> stagingRead = staging;
+            ParallelFor(entities.size(), CVarApplySceneChunkSize.Get(), [&](size_t i) {
+                if (unchanged[i]) return;
+                scene_util::BuildEntity(stagingRead, entities[i], components[i], false);
+            });
+            for (size_t i = 0; i < entities.size(); i++) {
+                if (!unchanged[i]) scene_util::InstantiateScripts(components[i]);
+            }
+        }
+        lastApplyStats.entities = entities.size();
+        lastApplyStats.builtEntities = std::count(unchanged.begin(), unchanged.end(), false);
+        lastApplyStats.buildTime = chrono_clock::now() - buildStart;
 
         auto live = ecs::StartTransaction<ecs::AddRemove>();
+        auto applyStart = chrono_clock::now();
 
         auto liveSceneId = data->sceneEntity.Get(live);
         if (!liveSceneId.Exists(live)) {
@@ -266,8 +324,11 @@ namespace sp {
                 sceneInfo.SetLiveId(staging, sceneInfo.liveId);
                 liveSceneInfo = sceneInfo.rootStagingId.Get<ecs::SceneInfo>(staging);
 
-                scene_util::ApplyFlatEntity(live, sceneInfo.liveId, flatEntity, resetLive);
+                if (!unchanged[i]) scene_util::ApplyFlatEntity(live, sceneInfo.liveId, flatEntity, resetLive);
                 continue;
+            } else if (unchanged[i]) {
+                // The live entity was removed since the last apply, so it needs to be recreated
+                scene_util::BuildEntity(ecs::Lock<ecs::ReadAll>(staging), e, flatEntity);
             }
 
             auto &entityName = e.Get<const ecs::Name>(staging);
@@ -296,6 +357,16 @@ namespace sp {
                 scene_util::ApplyFlatEntity(live, sceneInfo.liveId, flatEntity, resetLive);
             }
         }
+
+        lastApplyStats.applyTime = chrono_clock::now() - applyStart;
+        lastApplyStats.arena = applyArena.Stats();
+
+        appliedEntities.clear();
+        if (stagingVersion > 0) {
+            for (size_t i = 0; i < entities.size(); i++) {
+                appliedEntities[entities[i]] = {stagingVersion, chainHashes[i]};
+            }
+        }
         {
             ZoneScopedN("AnimationUpdate");
             for (auto &e : live.EntitiesWith<ecs::Animation>()) {
@@ -375,6 +446,7 @@ namespace sp {
         auto stagingSceneId = data->sceneEntity.Get(staging);
         if (liveSceneId.Exists(live)) liveSceneId.Destroy(live);
         if (stagingSceneId.Exists(staging)) stagingSceneId.Destroy(staging);
+        appliedEntities.clear();
 
         live.Get<ecs::Signals>().UpdateMissingEntitySignals(live);
         {
@@ -16,11 +16,15 @@ namespace sp::scene_util {
     // Build a flattened set of components from the staging ECS.
     // The result includes staging components from the provided entity and all lower priority entities.
     // Transform components will have their scene root transforms applied to their poses.
-    // Scripts will be initialized and their event queues will be created.
+    // Scripts will be initialized and their event queues will be created, unless newScriptInstances is false.
+    // In that case the scripts still reference their staging state, and InstantiateScripts() must be called later.
+    // BuildEntity only reads from the staging ECS, and can be called from multiple threads with newScriptInstances
+    // set to false.
     template<typename... AllComponentTypes, template<typename...> typename ECSType>
     void BuildEntity(const Tecs::Lock<ECSType<AllComponentTypes...>, ReadAll> &staging,
         const Entity &e,
-        FlatEntity &flatEntity) {
+        FlatEntity &flatEntity,
+        bool newScriptInstances = true) {
         ZoneScoped;
         flatEntity = FlatEntity();
         if (!e.Has<SceneInfo>(staging)) return;
@@ -84,10 +88,12 @@ namespace sp::scene_util {
                         } else if constexpr (std::is_same_v<T, Scripts>) {
                             auto scripts = stagingId.Get<Scripts>(staging);
 
-                            // Create a new script instance for each staging definition
-                            for (auto &script : scripts.scripts) {
-                                if (!script.state) continue;
-                                script.state = GetScriptManager().NewScriptInstance(*script.state, true);
+                            if (newScriptInstances) {
+                                // Create a new script instance for each staging definition
+                                for (auto &script : scripts.scripts) {
+                                    if (!script.state) continue;
+                                    script.state = GetScriptManager().NewScriptInstance(*script.state, true);
+                                }
                             }
 
                             LookupComponent<Scripts>().ApplyComponent(*component, scripts, false);
@@ -133,6 +139,16 @@ namespace sp::scene_util {
         }
     }
 
+    // Create new script instances for an entity built with newScriptInstances set to false.
+    inline void InstantiateScripts(FlatEntity &flatEntity) {
+        auto &scripts = std::get<std::optional<Scripts>>(flatEntity);
+        if (!scripts) return;
+        for (auto &script : scripts->scripts) {
+            if (!script.state) continue;
+            script.state = GetScriptManager().NewScriptInstance(*script.state, true);
+        }
+    }
+
     template<typename... AllComponentTypes, template<typename...> typename ECSType>
     void ApplyFlatEntity(const Tecs::Lock<ECSType<AllComponentTypes...>, AddRemove> &live,
         const Entity &liveId,
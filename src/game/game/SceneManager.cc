@@ -10,6 +10,7 @@
 #include "assets/Asset.hh"
 #include "assets/AssetManager.hh"
 #include "assets/JsonHelpers.hh"
+#include "common/ArenaAllocator.hh"
 #include "common/Tracing.hh"
 #include "ecs/EcsImpl.hh"
 #include "ecs/EntityReferenceManager.hh"
@@ -76,6 +77,16 @@ namespace sp {
             QueueActionAndBlock(SceneAction::ReloadBindings);
         });
         funcs.Register(this, "printscene", "Print info about currently loaded scenes", &SceneManager::PrintScene);
+        funcs.Register("printapplystats", "Print timing of the last ApplyScene for each loaded scene", [this]() {
+            QueueActionAndBlock([this]() {
+                PrintApplyStats();
+            });
+        });
+
+        {
+            auto stagingLock = ecs::StartStagingTransaction<ecs::AddRemove>();
+            stagingChanges.Watch(stagingLock);
+        }
 
         StartThread();
     }
@@ -107,6 +118,7 @@ namespace sp {
         auto stagingLock = ecs::StartStagingTransaction<ecs::AddRemove>();
         auto liveLock = ecs::StartTransaction<ecs::AddRemove>();
 
+        stagingChanges.Stop(stagingLock);
         for (auto &list : scenes) {
             list.clear();
         }
@@ -172,7 +184,7 @@ namespace sp {
                         item.editSceneCallback(stagingLock, scene);
                     }
                     Tracef("Applying system scene: %s", scene->data->path);
-                    scene->ApplyScene();
+                    scene->ApplyScene(false, nullptr, &stagingChanges);
                 }
                 item.promise.set_value();
             } else if (item.action == SceneAction::EditStagingScene) {
@@ -431,7 +443,7 @@ namespace sp {
 
                 bindingsScene = LoadBindingsJson();
                 if (bindingsScene) {
-                    bindingsScene->ApplyScene();
+                    bindingsScene->ApplyScene(false, nullptr, &stagingChanges);
                 } else {
                     Errorf("Failed to load bindings scene!");
                 }
@@ -615,13 +627,16 @@ namespace sp {
             }
         }
 
-        scene->ApplyScene(resetLive, [&](auto &stagingLock, auto &liveLock) {
-            if (callback) callback(stagingLock, liveLock, scene);
-            {
-                std::lock_guard lock(preloadMutex);
-                preloadScene.reset();
-            }
-        });
+        scene->ApplyScene(
+            resetLive,
+            [&](auto &stagingLock, auto &liveLock) {
+                if (callback) callback(stagingLock, liveLock, scene);
+                {
+                    std::lock_guard lock(preloadMutex);
+                    preloadScene.reset();
+                }
+            },
+            &stagingChanges);
     }
 
     std::string_view SceneManager::GetSceneName(std::string_view scenePath) {
@@ -717,9 +732,12 @@ namespace sp {
             }
         }
 
-        std::vector<ecs::FlatEntity> entities;
+        // The flattened entity lists are discarded together once the scene is staged
+        ArenaAllocator loadArena;
+        std::pmr::vector<ecs::FlatEntity> entities(loadArena.Resource());
         if (sceneObj.count("entities")) {
             auto &entityList = sceneObj["entities"];
+            entities.reserve(entityList.get<picojson::array>().size());
             for (auto &value : entityList.get<picojson::array>()) {
                 auto &entSrc = value.get<picojson::object>();
                 auto &entDst = entities.emplace_back();
@@ -747,7 +765,7 @@ namespace sp {
         auto lock = ecs::StartStagingTransaction<ecs::AddRemove>();
         auto scene = Scene::New(lock, sceneName, scenePath, sceneType, priority, asset, sceneProperties, libraries);
 
-        std::vector<ecs::Entity> scriptEntities;
+        std::pmr::vector<ecs::Entity> scriptEntities(loadArena.Resource());
         for (auto &flatEnt : entities) {
             auto &name_ptr = std::get<std::optional<ecs::Name>>(flatEnt);
             auto name = name_ptr ? *name_ptr : ecs::Name();
@@ -772,6 +790,15 @@ namespace sp {
         for (auto &e : scriptEntities) {
             scriptManager.RunPrefabs(lock, e);
         }
+
+        auto &arenaStats = loadArena.Stats();
+        // Only the entity lists live in the arena, component data inside each FlatEntity uses the global heap
+        Debugf("Loaded scene %s: %u entity list arena allocations, %u bytes (%u bytes in %u blocks)",
+            sceneName,
+            arenaStats.allocations,
+            arenaStats.allocatedBytes,
+            arenaStats.reservedBytes,
+            arenaStats.blocks);
         return scene;
     }
 
@@ -919,6 +946,31 @@ namespace sp {
         }
     }
 
+    void SceneManager::PrintApplyStats() {
+        auto toMs = [](chrono_clock::duration d) {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count() / 1000000.0;
+        };
+        auto printStats = [&](const std::shared_ptr<Scene> &scene) {
+            if (!scene) return;
+            auto &stats = scene->GetLastApplyStats();
+            Logf("%s: built %u/%u entities in %.3fms, applied in %.3fms, %u entity list arena allocations (%u bytes)",
+                scene->data->name,
+                stats.builtEntities,
+                stats.entities,
+                toMs(stats.buildTime),
+                toMs(stats.applyTime),
+                stats.arena.allocations,
+                stats.arena.allocatedBytes);
+        };
+        for (auto &list : scenes) {
+            for (auto &scene : list) {
+                printStats(scene);
+            }
+        }
+        printStats(playerScene);
+        printStats(bindingsScene);
+    }
+
     void SceneManager::PrintScene(std::string filterName) {
         {
             auto stagingLock = ecs::StartStagingTransaction<ecs::Read<ecs::Name, ecs::SceneInfo>>();
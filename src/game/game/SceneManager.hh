@@ -14,6 +14,7 @@
 #include "ecs/components/SceneInfo.hh"
 #include "game/Scene.hh"
 #include "game/SceneRef.hh"
+#include "game/StagingChangeTracker.hh"
 #include "strayphotons/EnumTypes.hh"
 #include "strayphotons/LockFreeMutex.hh"
 
@@ -102,6 +103,7 @@ namespace sp {
         void Frame() override;
 
         void PrintScene(std::string sceneName);
+        void PrintApplyStats();
         void RespawnPlayer(
             ecs::Lock<ecs::Read<ecs::Name>, ecs::Write<ecs::TransformSnapshot, ecs::TransformTree>> lock);
 
@@ -132,7 +134,7 @@ namespace sp {
         };
 
         std::atomic_bool shutdown;
-        LockFreeMutex actionMutex, preloadMutex;
+        LockFreeMutex actionMutex{"SceneManager Action"}, preloadMutex{"SceneManager Preload"};
         std::deque<QueuedAction> actionQueue;
         std::shared_ptr<Scene> preloadScene;
         std::atomic_flag graphicsPreload, physicsPreload;
@@ -140,13 +142,14 @@ namespace sp {
         bool enablePhysicsPreload = true;
         bool enableDynamicLibraries = true;
 
-        LockFreeMutex activeSceneMutex;
+        LockFreeMutex activeSceneMutex{"SceneManager ActiveScene"};
         std::vector<SceneRef> activeSceneCache;
 
         PreservingMap<std::string, Scene, 1000> stagedScenes;
         using SceneList = std::vector<std::shared_ptr<Scene>>;
         EnumArray<SceneList, SceneType> scenes;
         std::shared_ptr<Scene> playerScene, bindingsScene;
+        StagingChangeTracker stagingChanges;
         CFuncCollection funcs;
 
         friend class Scene;
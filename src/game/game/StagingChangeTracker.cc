@@ -0,0 +1,67 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "StagingChangeTracker.hh"
+
+#include "common/Tracing.hh"
+#include "ecs/EcsImpl.hh"
+
+namespace sp {
+    namespace detail {
+        template<typename... AllComponentTypes, typename Func>
+        void forEachTrackedComponent(Tecs::ECS<AllComponentTypes...> *, Func &&func) {
+            (func((AllComponentTypes *)nullptr), ...);
+        }
+    } // namespace detail
+
+    void StagingChangeTracker::Watch(ecs::Lock<ecs::AddRemove> staging) {
+        Assertf(ecs::IsStaging(staging), "StagingChangeTracker::Watch must be called with a staging lock");
+        detail::forEachTrackedComponent((ecs::ECS *)nullptr, [&](auto *ptr) {
+            using T = std::remove_pointer_t<decltype(ptr)>;
+            if constexpr (IsTracked<T>()) {
+                std::get<AddRemoveObserver<T>>(observers.addRemove) =
+                    staging.Watch<ecs::ComponentAddRemoveEvent<T>>();
+                std::get<ModifiedObserver<T>>(observers.modified) = staging.Watch<ecs::ComponentModifiedEvent<T>>();
+            }
+        });
+        watching = true;
+    }
+
+    void StagingChangeTracker::Stop(ecs::Lock<ecs::AddRemove> staging) {
+        if (!watching) return;
+        detail::forEachTrackedComponent((ecs::ECS *)nullptr, [&](auto *ptr) {
+            using T = std::remove_pointer_t<decltype(ptr)>;
+            if constexpr (IsTracked<T>()) {
+                std::get<AddRemoveObserver<T>>(observers.addRemove).Stop(staging);
+                std::get<ModifiedObserver<T>>(observers.modified).Stop(staging);
+            }
+        });
+        versions.clear();
+        watching = false;
+    }
+
+    uint64_t StagingChangeTracker::Poll(ecs::Lock<ecs::ReadAll> staging) {
+        ZoneScoped;
+        if (!watching) return currentVersion;
+
+        currentVersion++;
+        detail::forEachTrackedComponent((ecs::ECS *)nullptr, [&](auto *ptr) {
+            using T = std::remove_pointer_t<decltype(ptr)>;
+            if constexpr (IsTracked<T>()) {
+                ecs::ComponentAddRemoveEvent<T> addRemoveEvent;
+                while (std::get<AddRemoveObserver<T>>(observers.addRemove).Poll(staging, addRemoveEvent)) {
+                    versions[addRemoveEvent.entity] = currentVersion;
+                }
+                ecs::ComponentModifiedEvent<T> modifiedEvent;
+                while (std::get<ModifiedObserver<T>>(observers.modified).Poll(staging, modifiedEvent)) {
+                    versions[modifiedEvent] = currentVersion;
+                }
+            }
+        });
+        return currentVersion;
+    }
+} // namespace sp
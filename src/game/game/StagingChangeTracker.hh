@@ -0,0 +1,70 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "ecs/Ecs.hh"
+#include "strayphotons/EntityMap.hh"
+
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <variant>
+
+namespace sp {
+    /**
+     * Assigns each staging entity a version number that increases whenever one of its components is added, removed,
+     * or written to. Scenes compare these against the version they last applied to skip unchanged entities.
+     *
+     * SceneInfo is not tracked, since it is written by every ApplyScene(). Changes to the staging entity chain are
+     * detected by the scene instead.
+     */
+    class StagingChangeTracker {
+    public:
+        void Watch(ecs::Lock<ecs::AddRemove> staging);
+        void Stop(ecs::Lock<ecs::AddRemove> staging);
+
+        bool Watching() const {
+            return watching;
+        }
+
+        // Consumes pending change events and returns the current version.
+        // Entities changed after this call will have a version greater than the returned value.
+        uint64_t Poll(ecs::Lock<ecs::ReadAll> staging);
+
+        // Returns 0 for entities that have not changed since Watch() was called
+        uint64_t Version(const ecs::Entity &stagingId) const {
+            auto *version = versions.find(stagingId);
+            return version ? *version : 0;
+        }
+
+    private:
+        template<typename T>
+        static constexpr bool IsTracked() {
+            return !Tecs::is_global_component<T>() && !std::is_same_v<T, ecs::SceneInfo>;
+        }
+
+        template<typename T>
+        using AddRemoveObserver =
+            std::conditional_t<IsTracked<T>(), ecs::ComponentAddRemoveObserver<T>, std::monostate>;
+        template<typename T>
+        using ModifiedObserver = std::conditional_t<IsTracked<T>(), ecs::ComponentModifiedObserver<T>, std::monostate>;
+
+        template<typename>
+        struct ObserverSet {};
+        template<typename... AllComponentTypes>
+        struct ObserverSet<Tecs::ECS<AllComponentTypes...>> {
+            std::tuple<AddRemoveObserver<AllComponentTypes>...> addRemove;
+            std::tuple<ModifiedObserver<AllComponentTypes>...> modified;
+        };
+
+        ObserverSet<ecs::ECS> observers;
+        EntityMap<uint64_t> versions;
+        uint64_t currentVersion = 1;
+        bool watching = false;
+    };
+} // namespace sp
@@ -32,6 +32,8 @@ namespace sp {
 
     GraphicsManager::GraphicsManager(Game &game)
         : RegisteredThread("RenderThread", CVarMaxFPS.Get(), true), game(game) {
+        SetFramePhase(FramePhase::Render);
+
         if (game.options.count("window-size")) {
             std::istringstream ss(game.options["window-size"].as<std::string>());
             glm::ivec2 size = glm::ivec2(0);
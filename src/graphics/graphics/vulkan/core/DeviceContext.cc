@@ -123,8 +123,8 @@ namespace sp::vulkan {
 
     DeviceContext::DeviceContext(Game &game)
         : game(game), graphics(*game.graphics), mainThread(std::this_thread::get_id()), allocator(nullptr, nullptr),
-          threadContexts(32), frameBeginQueue("BeginFrame", 0, {}), frameEndQueue("EndFrame", 0, {}),
-          allocatorQueue("GPUAllocator", 1, {}), graph(*this) {
+          threadContexts(32 + GetJobSystem().GetWorkerCount()), frameBeginQueue("BeginFrame", 0, {}),
+          frameEndQueue("EndFrame", 0, {}), allocatorQueue("GPUAllocator", 1, {}, JobPriority::High), graph(*this) {
         ZoneScoped;
 
         try {
@@ -9,6 +9,7 @@
 
 #include "assets/GltfImpl.hh"
 #include "ecs/EcsImpl.hh"
+#include "ecs/TransformBatch.hh"
 #include "graphics/vulkan/core/CommandContext.hh"
 #include "graphics/vulkan/core/DeviceContext.hh"
 #include "graphics/vulkan/scene/Mesh.hh"
@@ -57,6 +58,9 @@ namespace sp::vulkan {
         meshes.clear();
         opticEntities.clear();
         jointPoses.clear();
+        renderableTransforms.clear();
+        jointTransforms.clear();
+        jointInverseBindPoses.clear();
         renderableCount = 0;
         primitiveCount = 0;
         vertexCount = 0;
@@ -73,10 +77,10 @@ namespace sp::vulkan {
             auto vkMesh = LoadMesh(model, renderable.meshIndex);
             if (!vkMesh || !vkMesh->CheckReady()) continue;
 
-            auto &transform = ent.Get<ecs::TransformSnapshot>(lock).globalPose;
+            // modelToWorld is filled in after the loop so all the matrices can be converted in one batch
+            renderableTransforms.emplace_back(ent.Get<ecs::TransformSnapshot>(lock).globalPose);
 
             GPURenderableEntity gpuRenderable;
-            gpuRenderable.modelToWorld = transform.GetMatrix();
             gpuRenderable.visibilityMask = (uint32_t)renderable.visibility;
             gpuRenderable.meshIndex = vkMesh->SceneIndex();
             gpuRenderable.vertexOffset = vertexCount;
@@ -100,15 +104,16 @@ namespace sp::vulkan {
                 gpuRenderable.visibilityMask &= (uint32_t)~ecs::VisibilityMask::Optics;
             }
 
-            if (!renderable.joints.empty()) gpuRenderable.jointPosesOffset = jointPoses.size();
+            if (!renderable.joints.empty()) gpuRenderable.jointPosesOffset = jointTransforms.size();
 
             for (auto &joint : renderable.joints) {
                 auto jointEntity = joint.entity.Get(lock);
                 if (jointEntity.Has<ecs::TransformSnapshot>(lock)) {
-                    auto &jointTransform = jointEntity.Get<ecs::TransformSnapshot>(lock).globalPose;
-                    jointPoses.push_back(jointTransform.GetMatrix() * joint.inverseBindPose);
+                    jointTransforms.emplace_back(jointEntity.Get<ecs::TransformSnapshot>(lock).globalPose);
+                    jointInverseBindPoses.emplace_back(&joint.inverseBindPose);
                 } else {
-                    jointPoses.emplace_back(); // missing joints get an identity matrix
+                    jointTransforms.emplace_back();
+                    jointInverseBindPoses.emplace_back(nullptr); // missing joints get an identity matrix
                 }
             }
 
@@ -125,6 +130,25 @@ namespace sp::vulkan {
             renderables.size(),
             meshes.size());
 
+        {
+            ZoneScopedN("TransformsToMatrices");
+            renderableMatrices.resize(renderableTransforms.size());
+            ecs::TransformsToMatrices(renderableTransforms, renderableMatrices);
+            for (size_t i = 0; i < renderables.size(); i++) {
+                renderables[i].modelToWorld = renderableMatrices[i];
+            }
+
+            jointPoses.resize(jointTransforms.size());
+            ecs::TransformsToMatrices(jointTransforms, jointPoses);
+            for (size_t i = 0; i < jointPoses.size(); i++) {
+                if (jointInverseBindPoses[i]) {
+                    jointPoses[i] *= *jointInverseBindPoses[i];
+                } else {
+                    jointPoses[i] = glm::mat4();
+                }
+            }
+        }
+
         primitiveCountPowerOfTwo = CeilToPowerOfTwo(primitiveCount);
 
         textures.Flush();
@@ -9,6 +9,7 @@
 
 #include "assets/Gltf.hh"
 #include "common/PreservingMap.hh"
+#include "ecs/components/Transform.h"
 #include "ecs/components/View.hh"
 #include "graphics/vulkan/core/VkCommon.hh"
 #include "graphics/vulkan/render_graph/RenderGraph.hh"
@@ -192,5 +193,11 @@ namespace sp::vulkan {
         std::vector<GPURenderableEntity> renderables;
         std::vector<std::pair<rg::ResourceName, size_t>> renderableTextureOverrides;
         std::vector<std::weak_ptr<Mesh>> meshes;
+
+        // Scratch buffers for converting transforms to matrices with TransformsToMatrices()
+        std::vector<ecs::Transform> renderableTransforms;
+        std::vector<glm::mat4> renderableMatrices;
+        std::vector<ecs::Transform> jointTransforms;
+        std::vector<const glm::mat4 *> jointInverseBindPoses;
     };
 } // namespace sp::vulkan
@@ -50,11 +50,16 @@ namespace sp::vulkan {
         if (asyncPtr->Ready()) return Add(asyncPtr->Get());
 
         auto i = AllocateTextureIndex();
-        return {i, workQueue.Dispatch<void>(asyncPtr, [this, i](ImageViewPtr view) {
-                    DebugAssertf(view, "TextureSet::Add missing image view");
-                    textures[i] = view;
-                    texturesToFlush.push_back(i);
-                })};
+        return {i, SetTextureWhenReady(i, asyncPtr)};
+    }
+
+    AsyncTask<void> TextureSet::SetTextureWhenReady(TextureIndex i, AsyncPtr<ImageView> asyncPtr) {
+        // Textures are only modified during Flush()
+        co_await ResumeOn(workQueue);
+        auto view = co_await asyncPtr;
+        DebugAssertf(view, "TextureSet::Add missing image view");
+        textures[i] = view;
+        texturesToFlush.push_back(i);
     }
 
     TextureIndex TextureSet::AllocateTextureIndex() {
@@ -12,6 +12,7 @@
 #include "graphics/vulkan/core/Memory.hh"
 #include "graphics/vulkan/core/VkCommon.hh"
 #include "strayphotons/Async.hh"
+#include "strayphotons/AsyncTask.hh"
 #include "strayphotons/DispatchQueue.hh"
 #include "strayphotons/Utility.hh"
 
@@ -68,6 +69,7 @@ namespace sp::vulkan {
     private:
         void ReleaseTexture(TextureIndex i);
         TextureIndex AllocateTextureIndex();
+        AsyncTask<void> SetTextureWhenReady(TextureIndex i, AsyncPtr<ImageView> asyncPtr);
 
         std::vector<ImageViewPtr> textures;
         std::vector<ImageViewPtr> texturesPendingDelete;
@@ -14,6 +14,9 @@
 #include "strayphotons/Logging.hh"
 
 namespace sp {
+    static constexpr ecs::SignalName SIGNAL_ANIMATION_STATE("animation_state");
+    static constexpr ecs::SignalName SIGNAL_ANIMATION_TARGET("animation_target");
+
     AnimationSystem::AnimationSystem(PhysxManager &manager) : manager(manager) {}
 
     void AnimationSystem::Frame(ecs::Lock<ecs::ReadSignalsLock,
@@ -26,9 +29,9 @@ namespace sp {
             auto &animation = ent.Get<ecs::Animation>(lock);
             if (animation.states.empty()) continue;
 
-            ecs::SignalRef stateRef(ent, "animation_state");
+            ecs::SignalRef stateRef = signalRefs.Get(lock, ent, SIGNAL_ANIMATION_STATE);
             double currentState = stateRef.GetSignal(lock);
-            double targetState = ecs::SignalRef(ent, "animation_target").GetSignal(lock);
+            double targetState = signalRefs.Get(lock, ent, SIGNAL_ANIMATION_TARGET).GetSignal(lock);
             double originalState = currentState;
             currentState = std::clamp(currentState, 0.0, animation.states.size() - 1.0);
             targetState = std::clamp(targetState, 0.0, animation.states.size() - 1.0);
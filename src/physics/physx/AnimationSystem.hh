@@ -9,6 +9,7 @@
 
 #include "ecs/Ecs.hh"
 #include "ecs/SignalExpression.hh"
+#include "ecs/SignalRefCache.hh"
 
 namespace sp {
     class PhysxManager;
@@ -24,5 +25,6 @@ namespace sp {
 
     private:
         PhysxManager &manager;
+        ecs::SignalRefCache signalRefs;
     };
 } // namespace sp
@@ -13,14 +13,31 @@
 #include "physx/PhysxUtils.hh"
 
 #include <PxQueryReport.h>
+#include <algorithm>
 
 namespace sp {
     using namespace physx;
 
+    static constexpr ecs::SignalName SIGNAL_LASER_COLOR_R("laser_color_r");
+    static constexpr ecs::SignalName SIGNAL_LASER_COLOR_G("laser_color_g");
+    static constexpr ecs::SignalName SIGNAL_LASER_COLOR_B("laser_color_b");
+    static constexpr ecs::SignalName SIGNAL_LIGHT_VALUE_R("light_value_r");
+    static constexpr ecs::SignalName SIGNAL_LIGHT_VALUE_G("light_value_g");
+    static constexpr ecs::SignalName SIGNAL_LIGHT_VALUE_B("light_value_b");
+    static constexpr ecs::SignalName SIGNAL_SENSOR_VALUE("value");
+
     CVar<int> CVarLaserRecursion("x.LaserRecursion", 10, "maximum number of laser bounces");
     CVar<float> CVarLaserBounceOffset("x.LaserBounceOffset", 0.001f, "Distance to offset laser bounces");
 
-    LaserSystem::LaserSystem(PhysxManager &manager) : manager(manager) {}
+    LaserSystem::LaserSystem(PhysxManager &manager) : manager(manager) {
+        auto lock = ecs::StartTransaction<ecs::AddRemove>();
+        sensorCursor.Watch(lock);
+    }
+
+    LaserSystem::~LaserSystem() {
+        auto lock = ecs::StartTransaction<ecs::AddRemove>();
+        sensorCursor.Stop(lock);
+    }
 
     struct OpticFilterCallback : PxQueryFilterCallback {
         OpticFilterCallback(ecs::Lock<ecs::Read<ecs::OpticalElement>> lock) : lock(lock) {}
@@ -75,10 +92,16 @@ namespace sp {
 
         static std::vector<LaserStart> emitterQueue;
 
-        for (const ecs::Entity &entity : lock.EntitiesWith<ecs::LaserSensor>()) {
-            auto &sensor = entity.Get<ecs::LaserSensor>(lock);
-            sensor.illuminance = glm::vec3(0);
+        // Only sensors that were lit last frame, or have been added or modified since, need to be reset and updated
+        auto &changedSensors = sensorCursor.Poll(lock);
+        updatedSensors.assign(changedSensors.begin(), changedSensors.end());
+        updatedSensors.insert(updatedSensors.end(), litSensors.begin(), litSensors.end());
+        for (const ecs::Entity &entity : updatedSensors) {
+            if (!entity.Has<ecs::LaserSensor>(lock)) continue;
+            if (entity.Get<const ecs::LaserSensor>(lock).illuminance == glm::vec3(0)) continue;
+            entity.Get<ecs::LaserSensor>(lock).illuminance = glm::vec3(0);
         }
+        litSensors.clear();
         for (const ecs::Entity &entity : lock.EntitiesWith<ecs::LaserEmitter>()) {
             if (!entity.Has<ecs::TransformSnapshot, ecs::LaserLine>(lock)) continue;
 
@@ -97,9 +120,9 @@ namespace sp {
             segments.clear();
 
             color_t signalColor = glm::vec3{
-                ecs::SignalRef(entity, "laser_color_r").GetSignal(lock),
-                ecs::SignalRef(entity, "laser_color_g").GetSignal(lock),
-                ecs::SignalRef(entity, "laser_color_b").GetSignal(lock),
+                signalRefs.Get(lock, entity, SIGNAL_LASER_COLOR_R).GetSignal(lock),
+                signalRefs.Get(lock, entity, SIGNAL_LASER_COLOR_G).GetSignal(lock),
+                signalRefs.Get(lock, entity, SIGNAL_LASER_COLOR_B).GetSignal(lock),
             };
 
             std::array<physx::PxRaycastHit, 128> hitBuffer;
@@ -207,6 +230,7 @@ namespace sp {
                             if (hitEntity.Has<ecs::LaserSensor>(lock)) {
                                 auto &sensor = hitEntity.Get<ecs::LaserSensor>(lock);
                                 sensor.illuminance += glm::vec3(laserStart.color * emitter.intensity);
+                                litSensors.emplace_back(hitEntity);
                             }
                             if (hitEntity.Has<ecs::OpticalElement>(lock)) {
                                 auto &optic = hitEntity.Get<ecs::OpticalElement>(lock);
@@ -224,12 +248,16 @@ namespace sp {
                 }
             }
         }
-        for (const ecs::Entity &entity : lock.EntitiesWith<ecs::LaserSensor>()) {
-            auto &sensor = entity.Get<ecs::LaserSensor>(lock);
-            ecs::SignalRef(entity, "light_value_r").SetValue(lock, sensor.illuminance.r);
-            ecs::SignalRef(entity, "light_value_g").SetValue(lock, sensor.illuminance.g);
-            ecs::SignalRef(entity, "light_value_b").SetValue(lock, sensor.illuminance.b);
-            ecs::SignalRef(entity, "value")
+        updatedSensors.insert(updatedSensors.end(), litSensors.begin(), litSensors.end());
+        std::sort(updatedSensors.begin(), updatedSensors.end());
+        updatedSensors.erase(std::unique(updatedSensors.begin(), updatedSensors.end()), updatedSensors.end());
+        for (const ecs::Entity &entity : updatedSensors) {
+            if (!entity.Has<ecs::LaserSensor>(lock)) continue;
+            auto &sensor = entity.Get<const ecs::LaserSensor>(lock);
+            signalRefs.Get(lock, entity, SIGNAL_LIGHT_VALUE_R).SetValue(lock, sensor.illuminance.r);
+            signalRefs.Get(lock, entity, SIGNAL_LIGHT_VALUE_G).SetValue(lock, sensor.illuminance.g);
+            signalRefs.Get(lock, entity, SIGNAL_LIGHT_VALUE_B).SetValue(lock, sensor.illuminance.b);
+            signalRefs.Get(lock, entity, SIGNAL_SENSOR_VALUE)
                 .SetValue(lock, glm::all(glm::greaterThanEqual(sensor.illuminance, sensor.threshold)));
         }
     }
@@ -7,8 +7,10 @@
 
 #pragma once
 
+#include "ecs/ComponentChangeCursor.hh"
 #include "ecs/Ecs.hh"
 #include "ecs/SignalExpression.hh"
+#include "ecs/SignalRefCache.hh"
 
 namespace sp {
     class PhysxManager;
@@ -16,7 +18,7 @@ namespace sp {
     class LaserSystem {
     public:
         LaserSystem(PhysxManager &manager);
-        ~LaserSystem() {}
+        ~LaserSystem();
 
         void Frame(ecs::Lock<ecs::ReadSignalsLock,
             ecs::Read<ecs::TransformSnapshot, ecs::LaserEmitter, ecs::OpticalElement>,
@@ -24,5 +26,11 @@ namespace sp {
 
     private:
         PhysxManager &manager;
+
+        ecs::ComponentChangeCursor<ecs::LaserSensor> sensorCursor;
+        // Sensors hit by a laser during the last frame
+        std::vector<ecs::Entity> litSensors;
+        std::vector<ecs::Entity> updatedSensors;
+        ecs::SignalRefCache signalRefs;
     };
 } // namespace sp
@@ -30,6 +30,7 @@
 #include <PxActor.h>
 #include <PxRigidActor.h>
 #include <PxScene.h>
+#include <algorithm>
 #include <chrono>
 #include <glm/ext/matrix_relational.hpp>
 #include <glm/gtx/string_cast.hpp>
@@ -41,11 +42,15 @@ namespace sp {
 
     CVar<bool> CVarPhysxDebugCollision("x.DebugColliders", false, "Show physx colliders");
     static CVar<uint32_t> CVarPhysicsFPS("x.PhysicsFPS", 144, "Target frame rate for physics to run");
+    static CVar<uint32_t> CVarPhysicsFixedStep("x.PhysicsFixedStep",
+        0,
+        "Run physics on a fixed timeline, catching up at most N missed frames (0 to disable)");
 
     PhysxManager::PhysxManager(LockFreeEventQueue<ecs::Event> &windowInputQueue)
         : RegisteredThread("PhysX", CVarPhysicsFPS.Get(), true), windowInputQueue(windowInputQueue),
           characterControlSystem(*this), constraintSystem(*this), physicsQuerySystem(*this), laserSystem(*this),
-          animationSystem(*this), workQueue("PhysXHullLoading") {
+          animationSystem(*this), workQueue("PhysXHullLoading", GetJobSystem().GetWorkerCount()) {
+        SetFramePhase(FramePhase::Physics);
         Logf("PhysX %d.%d.%d starting up",
             PX_PHYSICS_VERSION_MAJOR,
             PX_PHYSICS_VERSION_MINOR,
@@ -114,10 +119,12 @@ namespace sp {
             }
         }
         joints.clear();
-        for (auto &actor : actors) {
-            RemoveActor(actor.second);
+        // RemoveActor() erases from the actor maps, so the first entry changes each iteration
+        while (!actors.empty()) {
+            auto [ent, actor] = *actors.begin();
+            RemoveActor(actor);
+            actors.erase(ent);
         }
-        actors.clear();
         subActors.clear();
         scene.reset();
         cache.DropAll();
@@ -190,6 +197,8 @@ namespace sp {
         } else {
             interval = std::chrono::nanoseconds(0);
         }
+        auto maxCatchUp = CVarPhysicsFixedStep.Get();
+        SetFixedStep(maxCatchUp > 0, maxCatchUp);
         return true;
     }
 
@@ -263,6 +272,10 @@ namespace sp {
                 ZoneScopedN("UpdateTransformChildList");
                 ecs::ComponentAddRemoveEvent<ecs::TransformSnapshot> transformSnapshotEvent;
                 while (transformSnapshotObserver.Poll(lock, transformSnapshotEvent)) {
+                    if (transformSnapshotEvent.type == Tecs::EventType::ADDED) {
+                        modifiedTransformTrees.emplace_back(transformSnapshotEvent.entity);
+                        continue;
+                    }
                     if (transformSnapshotEvent.type != Tecs::EventType::REMOVED) continue;
                     const auto &parent = transformSnapshotEvent.component.firstParent;
                     if (!parent.Has<ecs::TransformSnapshot>(lock)) continue;
@@ -306,30 +319,29 @@ namespace sp {
                 auto &newTree = entity.Get<const ecs::TransformTree>(lock);
                 if (oldTree != newTree) modifiedTransformTrees.emplace_back(entity);
             }
-            // Deduplicate modified transform trees and enumerate all child transforms
-            FlatSet<ecs::Entity> modifiedTransformEntities;
-            while (!modifiedTransformTrees.empty()) {
-                ecs::Entity ent = modifiedTransformTrees.back();
-                modifiedTransformTrees.pop_back();
-                bool exists = !modifiedTransformEntities.emplace(ent).second;
-                if (exists) continue;
-                // Logf("Modified transform: %s", ecs::EntityRef(ent).Name().String());
-                if (ent.Has<ecs::TransformSnapshot>(lock)) {
-                    auto &snapshot = ent.Get<const ecs::TransformSnapshot>(lock);
-                    if (snapshot.childEntities.empty()) continue;
-                    modifiedTransformTrees.insert(modifiedTransformTrees.end(),
-                        snapshot.childEntities.begin(),
-                        snapshot.childEntities.end());
-                }
-            }
+            // Recalculate the modified transforms and all their children in one parent-before-child sweep
+            std::vector<ecs::Entity> modifiedTransformEntities;
             {
                 ZoneScopedN("UpdateSnapshots(NonDynamic)");
-                // Only recalculate the transform snapshot for entities that were modified.
-                for (const ecs::Entity &ent : modifiedTransformEntities) {
+                for (const ecs::Entity &ent : modifiedTransformTrees) {
+                    transformHierarchy.MarkModified(lock, ent);
+                    // Removed transforms are still passed on so their actors get cleaned up
+                    if (!ent.Has<ecs::TransformTree>(lock)) modifiedTransformEntities.emplace_back(ent);
+                }
+                std::sort(modifiedTransformEntities.begin(), modifiedTransformEntities.end());
+                modifiedTransformEntities.erase(
+                    std::unique(modifiedTransformEntities.begin(), modifiedTransformEntities.end()),
+                    modifiedTransformEntities.end());
+
+                auto &updatedEntities = transformHierarchy.UpdateSnapshots(lock);
+                modifiedTransformEntities.insert(modifiedTransformEntities.end(),
+                    updatedEntities.begin(),
+                    updatedEntities.end());
+
+                for (const ecs::Entity &ent : updatedEntities) {
                     if (!ent.Has<ecs::TransformTree, ecs::TransformSnapshot>(lock)) continue;
 
-                    auto transform = ent.Get<const ecs::TransformTree>(lock).GetGlobalTransform(lock);
-                    ent.Get<ecs::TransformSnapshot>(lock).globalPose = transform;
+                    auto &transform = ent.Get<const ecs::TransformSnapshot>(lock).globalPose;
 
                     triggerSystem.UpdateEntityTriggers(lock, ent);
 
@@ -547,19 +559,7 @@ namespace sp {
                 set = cache.Load(settings->name);
                 if (set) return set;
 
-                set = workQueue.Dispatch<ConvexHullSet>([this, modelPtr, settingsPtr, name = settings->name]() {
-                    ZoneScopedN("LoadConvexHullSet::Dispatch");
-                    ZoneStr(name);
-
-                    auto set = hullgen::LoadCollisionCache(*pxSerialization, modelPtr, settingsPtr);
-                    if (set) return set;
-
-                    Logf("Updating physics collision cache: %s", name);
-                    set = hullgen::BuildConvexHulls(*pxCooking, *pxPhysics, modelPtr, settingsPtr);
-                    hullgen::SaveCollisionCache(*pxSerialization, modelPtr, settingsPtr, *set);
-
-                    return set;
-                });
+                set = BuildConvexHullSet(modelPtr, settingsPtr, settings->name);
                 cache.Register(settings->name, set);
             }
         }
@@ -567,6 +567,22 @@ namespace sp {
         return set;
     }
 
+    AsyncTask<ConvexHullSet> PhysxManager::BuildConvexHullSet(AsyncPtr<Gltf> modelPtr,
+        AsyncPtr<HullSettings> settingsPtr,
+        AssetName name) {
+        co_await ResumeOn(workQueue);
+        ZoneScopedN("LoadConvexHullSet::Dispatch");
+        ZoneStr(name);
+
+        auto set = hullgen::LoadCollisionCache(*pxSerialization, modelPtr, settingsPtr);
+        if (set) co_return set;
+
+        Logf("Updating physics collision cache: %s", name);
+        set = hullgen::BuildConvexHulls(*pxCooking, *pxPhysics, modelPtr, settingsPtr);
+        hullgen::SaveCollisionCache(*pxSerialization, modelPtr, settingsPtr, *set);
+        co_return set;
+    }
+
     size_t PhysxManager::UpdateShapes(ecs::Lock<ecs::Read<ecs::Name, ecs::Physics>> lock,
         const ecs::Entity &owner,
         const ecs::Entity &actorEnt,
@@ -842,7 +858,7 @@ namespace sp {
             userData->linearDamping = ph.linearDamping;
         }
 
-        actors[e] = actor;
+        actors.insert_or_assign(e, actor);
         if (shapeCount == 0) return actor;
         scene->addActor(*actor);
         SceneUserData *sceneUserData = (SceneUserData *)scene->userData;
@@ -889,21 +905,21 @@ namespace sp {
             if (subActors.count(e) > 0) {
                 if (subActors[e] != actors[actorEnt]) {
                     RemoveActor(subActors[e]);
-                    subActors[e] = actors[actorEnt];
+                    subActors.insert_or_assign(e, actors[actorEnt]);
                 }
             } else {
-                subActors[e] = actors[actorEnt];
+                subActors.insert_or_assign(e, actors[actorEnt]);
             }
         }
 
-        auto &actor = actors[actorEnt];
+        auto actor = actors[actorEnt];
         auto dynamic = actor->is<PxRigidDynamic>();
         if (actorEnt == e) {
             bool requestDynamicActor = ph.type == ecs::PhysicsActorType::Dynamic ||
                                        ph.type == ecs::PhysicsActorType::Kinematic;
             if (requestDynamicActor != !!dynamic) {
                 RemoveActor(actor);
-                CreateActor(lock, e);
+                actor = CreateActor(lock, e);
             }
         }
 
@@ -13,6 +13,7 @@
 #include "cooking/ConvexHull.hh"
 #include "ecs/Ecs.hh"
 #include "ecs/EntityRef.hh"
+#include "ecs/TransformHierarchy.hh"
 #include "ecs/components/Physics.hh"
 #include "ecs/components/PhysicsJoints.hh"
 #include "ecs/components/Transform.h"
@@ -24,6 +25,7 @@
 #include "physx/SimulationCallbackHandler.hh"
 #include "physx/TriggerSystem.hh"
 #include "strayphotons/Async.hh"
+#include "strayphotons/AsyncTask.hh"
 #include "strayphotons/DispatchQueue.hh"
 #include "strayphotons/EntityMap.hh"
 #include "strayphotons/FlatSet.hh"
@@ -140,6 +142,9 @@ namespace sp {
         void RegisterDebugCommands();
 
         AsyncPtr<ConvexHullSet> LoadConvexHullSet(AsyncPtr<Gltf> model, AsyncPtr<HullSettings> settings);
+        AsyncTask<ConvexHullSet> BuildConvexHullSet(AsyncPtr<Gltf> model,
+            AsyncPtr<HullSettings> settings,
+            AssetName name);
 
         physx::PxGeometryHolder GeometryFromShape(const ecs::PhysicsShape &shape,
             glm::vec3 parentScale = glm::vec3(1)) const;
@@ -172,6 +177,7 @@ namespace sp {
         ecs::ComponentModifiedObserver<ecs::Physics> physicsObserver;
         ecs::ComponentModifiedObserver<ecs::TransformTree> transformTreeObserver;
         ecs::ComponentAddRemoveObserver<ecs::TransformSnapshot> transformSnapshotObserver;
+        ecs::TransformHierarchy transformHierarchy;
         ecs::EntityRef debugLineEntity = ecs::Name("physx", "debug_lines");
 
         CharacterControlSystem characterControlSystem;
@@ -181,7 +187,8 @@ namespace sp {
         TriggerSystem triggerSystem;
         AnimationSystem animationSystem;
 
-        EntityMap<physx::PxRigidActor *> actors, subActors;
+        // Indexed by value so RemoveActor() can erase an actor and all of its sub-actors in O(1)
+        EntityMap<physx::PxRigidActor *, true> actors, subActors;
         EntityMap<physx::PxController *> controllers;
 
         EntityMap<std::vector<JointState>> joints;
@@ -97,7 +97,7 @@ namespace sp {
 
                 ecs::EventBindings::SendEvent(lock, areaEnt, ecs::Event{*eventName, areaEnt, entity});
 
-                ecs::SignalRef(areaEnt, ecs::TriggerGroupSignalNames[triggerGroup])
+                signalRefs.Get(lock, areaEnt, ecs::TriggerGroupSignalNames[triggerGroup])
                     .SetValue(lock, (double)containedEntities.size());
             }
         }
@@ -8,6 +8,7 @@
 #pragma once
 
 #include "ecs/Ecs.hh"
+#include "ecs/SignalRefCache.hh"
 #include "ecs/components/Events.hh"
 
 namespace sp {
@@ -28,5 +29,8 @@ namespace sp {
             ecs::Entity entity);
 
         ecs::ComponentAddRemoveObserver<ecs::TriggerGroup> triggerGroupObserver;
+
+    private:
+        ecs::SignalRefCache signalRefs;
     };
 } // namespace sp
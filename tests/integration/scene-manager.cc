@@ -194,5 +194,63 @@ namespace SceneManagerTests {
         }
     }
 
+    void TestApplySkipsUnchangedEntities() {
+        const ecs::Name nameA("apply-skip", "a"), nameB("apply-skip", "b");
+        std::shared_ptr<sp::Scene> applyScene;
+        auto statsAfterApply = [&](sp::SceneManager::EditSceneCallback callback) {
+            sp::Scene::ApplyStats stats;
+            Scenes().QueueActionAndBlock(sp::SceneAction::ApplySystemScene, "apply-skip", callback);
+            Scenes().QueueActionAndBlock([&] {
+                stats = applyScene->GetLastApplyStats();
+            });
+            return stats;
+        };
+
+        size_t entityCount;
+        {
+            Timer t("Apply new system scene");
+            auto stats = statsAfterApply([&](ecs::Lock<ecs::AddRemove> lock, std::shared_ptr<sp::Scene> scene) {
+                applyScene = scene;
+                auto a = scene->NewSystemEntity(lock, scene, nameA);
+                a.Set<ecs::TransformSnapshot>(lock, ecs::Transform(glm::vec3(1, 2, 3)));
+                auto b = scene->NewSystemEntity(lock, scene, nameB);
+                b.Set<ecs::TransformSnapshot>(lock, ecs::Transform(glm::vec3(4, 5, 6)));
+            });
+            AssertTrue(stats.entities >= 2, "Expected scene to contain the new entities");
+            AssertEqual(stats.builtEntities, stats.entities, "Expected all entities to be built on first apply");
+            entityCount = stats.entities;
+        }
+        {
+            Timer t("Reapply unchanged system scene");
+            auto stats = statsAfterApply([](auto, auto) {});
+            AssertEqual(stats.entities, entityCount, "Unexpected scene entity count");
+            AssertEqual(stats.builtEntities, 0u, "Expected unchanged entities to be skipped");
+        }
+        {
+            Timer t("Reapply system scene with one changed entity");
+            auto stats = statsAfterApply([&](ecs::Lock<ecs::AddRemove> lock, std::shared_ptr<sp::Scene> scene) {
+                auto a = scene->GetStagingEntity(nameA);
+                a.Get<ecs::TransformSnapshot>(lock).globalPose.SetPosition(glm::vec3(7, 8, 9));
+            });
+            AssertEqual(stats.entities, entityCount, "Unexpected scene entity count");
+            AssertEqual(stats.builtEntities, 1u, "Expected only the changed entity to be rebuilt");
+
+            auto liveLock = ecs::StartTransaction<ecs::Read<ecs::Name, ecs::TransformSnapshot>>();
+            auto a = EntityWith<ecs::Name>(liveLock, nameA);
+            AssertTrue(a.Has<ecs::TransformSnapshot>(liveLock), "Expected live entity to have a transform");
+            AssertEqual(a.Get<ecs::TransformSnapshot>(liveLock).globalPose.GetPosition(),
+                glm::vec3(7, 8, 9),
+                "Expected changed entity to be applied to live");
+            auto b = EntityWith<ecs::Name>(liveLock, nameB);
+            AssertTrue(b.Has<ecs::TransformSnapshot>(liveLock), "Expected live entity to have a transform");
+            AssertEqual(b.Get<ecs::TransformSnapshot>(liveLock).globalPose.GetPosition(),
+                glm::vec3(4, 5, 6),
+                "Expected unchanged entity to keep its live transform");
+        }
+        applyScene.reset();
+        Scenes().QueueActionAndBlock(sp::SceneAction::RemoveScene, "apply-skip");
+    }
+
     Test test(&TestBasicLoadAddRemove);
+    Test test2(&TestApplySkipsUnchangedEntities);
 } // namespace SceneManagerTests
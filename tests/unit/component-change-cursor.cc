@@ -0,0 +1,79 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "ecs/ComponentChangeCursor.hh"
+#include "ecs/EcsImpl.hh"
+
+#include <algorithm>
+#include <glm/glm.hpp>
+#include <tests.hh>
+#include <vector>
+
+namespace ComponentChangeCursorTests {
+    using namespace testing;
+
+    void TestComponentChangeCursor() {
+        const size_t ENTITY_COUNT = 1000;
+        ecs::ComponentChangeCursor<ecs::LaserSensor> cursor;
+        std::vector<Tecs::Entity> entities;
+        {
+            Timer t("Create " + std::to_string(ENTITY_COUNT) + " laser sensors");
+            auto lock = ecs::StartTransaction<ecs::AddRemove>();
+            cursor.Watch(lock);
+            for (size_t i = 0; i < ENTITY_COUNT; i++) {
+                auto &ent = entities.emplace_back(lock.NewEntity());
+                ent.Set<ecs::LaserSensor>(lock);
+            }
+        }
+        {
+            Timer t("First poll returns every entity");
+            auto lock = ecs::StartTransaction<ecs::Read<ecs::LaserSensor>>();
+            AssertEqual(cursor.Poll(lock).size(), ENTITY_COUNT, "Expected a full resync on the first poll");
+            AssertTrue(cursor.Resynced(), "Expected the first poll to be a resync");
+        }
+        {
+            Timer t("Poll with no changes");
+            auto lock = ecs::StartTransaction<ecs::Read<ecs::LaserSensor>>();
+            AssertEqual(cursor.Poll(lock).size(), 0u, "Expected no changes");
+            AssertTrue(!cursor.Resynced(), "Expected an incremental poll");
+        }
+        {
+            Timer t("Modify and remove sensors");
+            {
+                auto lock = ecs::StartTransaction<ecs::Write<ecs::LaserSensor>>();
+                entities[3].Get<ecs::LaserSensor>(lock).threshold = glm::vec3(1);
+                entities[7].Get<ecs::LaserSensor>(lock).threshold = glm::vec3(2);
+                entities[3].Get<ecs::LaserSensor>(lock).threshold = glm::vec3(3);
+            }
+            {
+                auto lock = ecs::StartTransaction<ecs::AddRemove>();
+                entities[9].Unset<ecs::LaserSensor>(lock);
+            }
+            auto lock = ecs::StartTransaction<ecs::Read<ecs::LaserSensor>>();
+            auto &changed = cursor.Poll(lock);
+            AssertEqual(changed.size(), 3u, "Expected each changed entity to be returned once");
+            AssertTrue(std::find(changed.begin(), changed.end(), entities[9]) != changed.end(),
+                "Expected the removed sensor to be returned");
+            AssertEqual(cursor.Poll(lock).size(), 0u, "Expected changes to be consumed");
+        }
+        {
+            Timer t("Request a full resync");
+            cursor.RequestResync();
+            auto lock = ecs::StartTransaction<ecs::Read<ecs::LaserSensor>>();
+            AssertEqual(cursor.Poll(lock).size(), ENTITY_COUNT - 1, "Expected every remaining entity after a resync");
+        }
+        {
+            auto lock = ecs::StartTransaction<ecs::AddRemove>();
+            cursor.Stop(lock);
+            for (auto &ent : entities) {
+                ent.Destroy(lock);
+            }
+        }
+    }
+
+    Test test(&TestComponentChangeCursor);
+} // namespace ComponentChangeCursorTests
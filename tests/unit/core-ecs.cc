@@ -72,6 +72,75 @@ namespace CoreEcsTests {
         }
     }
 
+    void TryCoalescedTransactions() {
+        Timer t("Test coalesced ecs::QueueTransaction");
+
+        const size_t transactionCount = 1000;
+        auto startStats = ecs::GetTransactionQueueStats();
+        auto entFuture = ecs::QueueTransaction<ecs::AddRemove>([](auto lock) {
+            auto ent = lock.NewEntity();
+            ent.template Set<ecs::Name>(lock, "test", "coalesced");
+            return ent;
+        });
+
+        // Only accessed from the transaction queue thread
+        std::vector<size_t> order;
+        // Only the last future is kept, so the transactions before it can be coalesced
+        sp::AsyncPtr<void> lastFuture;
+        for (size_t i = 0; i < transactionCount; i++) {
+            if (i % 2 == 0) {
+                lastFuture = ecs::QueueTransaction<ecs::Write<ecs::Name>>([entFuture, &order, i](auto &lock) {
+                    AssertTrue(entFuture->Ready(), "Expected result of first transaction to be available");
+                    ecs::Entity ent = *entFuture->Get();
+                    ent.Get<ecs::Name>(lock).entity = "coalesced" + std::to_string(i);
+                    order.emplace_back(i);
+                });
+            } else {
+                lastFuture = ecs::QueueTransaction<ecs::Read<ecs::Name>>([entFuture, &order, i](auto &lock) {
+                    ecs::Entity ent = *entFuture->Get();
+                    auto &name = ent.Get<const ecs::Name>(lock);
+                    AssertEqual(name.entity.str(), "coalesced" + std::to_string(i - 1), "Expected previous write");
+                    order.emplace_back(i);
+                });
+            }
+        }
+        lastFuture->Get();
+
+        AssertEqual(order.size(), transactionCount, "Expected all transactions to run");
+        for (size_t i = 0; i < order.size(); i++) {
+            AssertEqual(order[i], i, "Expected transactions to run in queue order");
+        }
+
+        auto stats = ecs::GetTransactionQueueStats();
+        AssertEqual(stats.queued - startStats.queued, transactionCount + 1, "Unexpected queued transaction count");
+        AssertTrue(stats.lockAcquisitions - startStats.lockAcquisitions <= transactionCount + 1,
+            "Expected at most 1 lock per transaction");
+        {
+            auto lock = ecs::StartTransaction<ecs::AddRemove>();
+            ecs::Entity ent = *entFuture->Get();
+            AssertEqual(ent.Get<ecs::Name>(lock).entity.str(),
+                "coalesced" + std::to_string(transactionCount - 2),
+                "Expected last write to be committed");
+            ent.Destroy(lock);
+        }
+    }
+
+    void TryDependentTransactions() {
+        Timer t("Test queued transactions waiting on earlier ones");
+
+        for (size_t i = 0; i < 100; i++) {
+            auto first = ecs::QueueTransaction<ecs::Write<ecs::Name>>([](auto &) {});
+            // Compatible with the first transaction, but has to wait for its future instead of sharing its lock
+            auto second = ecs::QueueTransaction<ecs::Read<ecs::Name>>([first](auto &) {
+                AssertTrue(first->Ready(), "Expected earlier transaction to be resolved");
+                first->Get();
+            });
+            second->Get();
+        }
+    }
+
     Test test1(&TryAddRemove);
     Test test2(&TryQueueTransaction);
+    Test test3(&TryCoalescedTransactions);
+    Test test4(&TryDependentTransactions);
 } // namespace CoreEcsTests
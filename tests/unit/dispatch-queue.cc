@@ -0,0 +1,302 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "strayphotons/AsyncTask.hh"
+#include "strayphotons/DispatchQueue.hh"
+#include "strayphotons/JobSystem.hh"
+
+#include <atomic>
+#include <tests.hh>
+#include <thread>
+#include <vector>
+
+namespace DispatchQueueTests {
+    using namespace testing;
+
+    void TestDispatchQueueChaining() {
+        sp::DispatchQueue parallelQueue("TestParallel", 4);
+        sp::DispatchQueue serialQueue("TestSerial", 1);
+
+        std::atomic_int concurrent = 0, maxConcurrent = 0;
+        std::vector<sp::AsyncPtr<int>> results;
+        {
+            Timer t("Dispatch chained work items across queues");
+            for (int i = 0; i < 1000; i++) {
+                auto a = parallelQueue.Dispatch<int>([i] {
+                    return std::make_shared<int>(i);
+                });
+                auto b = serialQueue.Dispatch<int>(a, [&](std::shared_ptr<int> value) {
+                    int current = ++concurrent;
+                    int max = maxConcurrent;
+                    while (current > max && !maxConcurrent.compare_exchange_weak(max, current)) {}
+                    concurrent--;
+                    return std::make_shared<int>(*value * 2);
+                });
+                results.emplace_back(parallelQueue.Dispatch<int>(b, [](std::shared_ptr<int> value) {
+                    return std::make_shared<int>(*value + 1);
+                }));
+            }
+            for (int i = 0; i < 1000; i++) {
+                AssertEqual(*results[i]->Get(), i * 2 + 1, "Unexpected chained result");
+            }
+        }
+        AssertEqual(maxConcurrent.load(), 1, "Serial queue ran work items concurrently");
+    }
+
+    void TestDispatchQueueBlockingWorkItems() {
+        sp::DispatchQueue outerQueue("TestOuter", sp::GetJobSystem().GetWorkerCount());
+        sp::DispatchQueue innerQueue("TestInner", 1);
+
+        Timer t("Block every worker on dependent work items");
+        std::vector<sp::AsyncPtr<int>> results;
+        for (size_t i = 0; i < sp::GetJobSystem().GetWorkerCount() * 2; i++) {
+            results.emplace_back(outerQueue.Dispatch<int>([&innerQueue, i] {
+                auto inner = innerQueue.Dispatch<int>([i] {
+                    return std::make_shared<int>((int)i);
+                });
+                return std::make_shared<int>(*inner->Get() + 1);
+            }));
+        }
+        for (size_t i = 0; i < results.size(); i++) {
+            AssertEqual(*results[i]->Get(), (int)i + 1, "Unexpected blocking result");
+        }
+    }
+
+    thread_local bool waitingOnInner = false;
+
+    void TestWaitOnlyHelpsProducer() {
+        sp::DispatchQueue outerQueue("TestOuter", sp::GetJobSystem().GetWorkerCount());
+        sp::DispatchQueue innerQueue("TestInner", 1);
+
+        Timer t("Wait on dependent work items alongside unrelated jobs");
+        std::atomic_int unrelatedRuns = 0, nestedRuns = 0;
+        std::vector<sp::AsyncPtr<int>> results;
+        size_t count = sp::GetJobSystem().GetWorkerCount() * 8;
+        for (size_t i = 0; i < count; i++) {
+            results.emplace_back(outerQueue.Dispatch<int>([&innerQueue, &nestedRuns, i] {
+                if (waitingOnInner) nestedRuns++;
+                auto inner = innerQueue.Dispatch<int>([i] {
+                    std::this_thread::sleep_for(std::chrono::microseconds(100));
+                    return std::make_shared<int>((int)i);
+                });
+                waitingOnInner = true;
+                int value = *inner->Get();
+                waitingOnInner = false;
+                return std::make_shared<int>(value + 1);
+            }));
+            sp::GetJobSystem().Submit([&unrelatedRuns, &nestedRuns] {
+                if (waitingOnInner) nestedRuns++;
+                unrelatedRuns++;
+            });
+        }
+        for (size_t i = 0; i < results.size(); i++) {
+            AssertEqual(*results[i]->Get(), (int)i + 1, "Unexpected blocking result");
+        }
+        while (unrelatedRuns < (int)count) {
+            std::this_thread::yield();
+        }
+        AssertEqual(nestedRuns.load(), 0, "Unrelated job ran while waiting on a future");
+    }
+
+    void TestParallelFor() {
+        std::vector<std::atomic_int> visits(10000);
+        sp::ParallelFor(visits.size(), 16, [&](size_t i) {
+            visits[i]++;
+        });
+        for (size_t i = 0; i < visits.size(); i++) {
+            AssertEqual(visits[i].load(), 1, "Expected every index to be visited once: " + std::to_string(i));
+        }
+    }
+
+    void TestManualDispatchQueue() {
+        sp::DispatchQueue queue("TestManual", 0);
+
+        auto result = queue.Dispatch<int>([] {
+            return std::make_shared<int>(42);
+        });
+        AssertTrue(!result->Ready(), "Manual queue ran work item before Flush()");
+        queue.Flush();
+        AssertTrue(result->Ready(), "Manual queue didn't run work item during Flush()");
+        AssertEqual(*result->Get(), 42, "Unexpected manual queue result");
+
+        auto input = std::make_shared<sp::Async<int>>();
+        auto waiting = queue.Dispatch<int>(sp::AsyncPtr<int>(input), [](std::shared_ptr<int> value) {
+            return std::make_shared<int>(*value + 1);
+        });
+        queue.Flush();
+        AssertTrue(!waiting->Ready(), "Manual queue ran work item before its input was ready");
+        std::thread setter([input] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            input->Set(std::make_shared<int>(1));
+        });
+        queue.Flush(true);
+        AssertTrue(waiting->Ready(), "Flush(true) returned before waiting work item was processed");
+        AssertEqual(*waiting->Get(), 2, "Unexpected manual queue result");
+        setter.join();
+    }
+
+    void BenchmarkDispatchChainLatency() {
+        sp::DispatchQueue queueA("TestChainA", 4);
+        sp::DispatchQueue queueB("TestChainB", 1);
+
+        // Each step does a small amount of work, alternating between queues like Asset -> Gltf -> HullSettings.
+        auto step = [](std::shared_ptr<int> value) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            return std::make_shared<int>(*value + 1);
+        };
+
+        MultiTimer timer("Benchmark 5-deep dispatch chain latency");
+        for (int i = 0; i < 200; i++) {
+            Timer t(timer);
+            auto future = queueA.Dispatch<int>([] {
+                return std::make_shared<int>(0);
+            });
+            for (int depth = 1; depth < 5; depth++) {
+                future = (depth % 2 ? queueB : queueA).Dispatch<int>(future, step);
+            }
+            AssertEqual(*future->Get(), 4, "Unexpected chain result");
+        }
+    }
+
+    sp::AsyncTask<int> AddOneTask(sp::DispatchQueue &queue, sp::AsyncPtr<int> input) {
+        co_await sp::ResumeOn(queue);
+        auto value = co_await input;
+        co_return std::make_shared<int>(*value + 1);
+    }
+
+    void TestAsyncTaskChaining() {
+        sp::DispatchQueue parallelQueue("TestParallel", 4);
+        sp::DispatchQueue serialQueue("TestSerial", 1);
+
+        std::atomic_int concurrent = 0, maxConcurrent = 0;
+        auto chain = [&](int i) -> sp::AsyncTask<int> {
+            co_await sp::ResumeOn(parallelQueue);
+            auto a = std::make_shared<int>(i);
+            co_await sp::ResumeOn(serialQueue);
+            int current = ++concurrent;
+            int max = maxConcurrent;
+            while (current > max && !maxConcurrent.compare_exchange_weak(max, current)) {}
+            concurrent--;
+            auto b = co_await AddOneTask(parallelQueue, sp::make_async<int>(*a * 2));
+            co_return b;
+        };
+
+        std::vector<sp::AsyncPtr<int>> results;
+        {
+            Timer t("Run chained coroutines across queues");
+            for (int i = 0; i < 1000; i++) {
+                results.emplace_back(chain(i));
+            }
+            for (int i = 0; i < 1000; i++) {
+                AssertEqual(*results[i]->Get(), i * 2 + 1, "Unexpected coroutine result");
+            }
+        }
+        AssertEqual(maxConcurrent.load(), 1, "Serial queue ran coroutines concurrently");
+    }
+
+    void TestAsyncTaskManualQueue() {
+        sp::DispatchQueue queue("TestManual", 0);
+
+        // Moves onto the queue before waiting, so the queue tracks it like a work item with a pending input
+        auto addOneOnQueue = [&queue](sp::AsyncPtr<int> input) -> sp::AsyncTask<int> {
+            co_await sp::ResumeOn(queue);
+            auto value = co_await input;
+            co_return std::make_shared<int>(*value + 1);
+        };
+
+        auto input = std::make_shared<sp::Async<int>>();
+        sp::AsyncPtr<int> result = addOneOnQueue(input);
+        queue.Flush();
+        AssertTrue(!result->Ready(), "Coroutine continued before its input was ready");
+
+        input->Set(std::make_shared<int>(41));
+        AssertTrue(!result->Ready(), "Coroutine continued outside of Flush()");
+        queue.Flush();
+        AssertTrue(result->Ready(), "Coroutine didn't continue during Flush()");
+        AssertEqual(*result->Get(), 42, "Unexpected coroutine result");
+
+        auto waitingInput = std::make_shared<sp::Async<int>>();
+        auto waiting = addOneOnQueue(waitingInput).Future();
+        queue.Flush();
+        std::thread setter([waitingInput] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            waitingInput->Set(std::make_shared<int>(1));
+        });
+        queue.Flush(true);
+        AssertTrue(waiting->Ready(), "Flush(true) returned before waiting coroutine was processed");
+        AssertEqual(*waiting->Get(), 2, "Unexpected coroutine result");
+        setter.join();
+    }
+
+    sp::AsyncTask<int> HoldUntilReady(sp::DispatchQueue &queue, sp::AsyncPtr<int> input, std::shared_ptr<int> held) {
+        co_await sp::ResumeOn(queue);
+        auto value = co_await input;
+        co_return std::make_shared<int>(*value + *held);
+    }
+
+    void TestAsyncTaskQueueDestroyed() {
+        auto readyInput = sp::make_async<int>(1);
+        auto pendingInput = std::make_shared<sp::Async<int>>();
+        auto queuedHeld = std::make_shared<int>(1);
+        auto waitingHeld = std::make_shared<int>(1);
+        std::weak_ptr<int> queuedFrame = queuedHeld, waitingFrame = waitingHeld;
+        sp::AsyncPtr<int> queued, waiting;
+        {
+            sp::DispatchQueue queue("TestDestroyed", 0);
+            waiting = HoldUntilReady(queue, pendingInput, std::move(waitingHeld));
+            queue.Flush();
+            queued = HoldUntilReady(queue, readyInput, std::move(queuedHeld));
+            AssertTrue(!queuedFrame.expired(), "Queued coroutine was destroyed before its queue");
+        }
+        AssertTrue(queuedFrame.expired(), "Queued coroutine frame leaked after its queue was destroyed");
+        AssertTrue(!queued->Ready(), "Queued coroutine continued after its queue was destroyed");
+
+        AssertTrue(!waitingFrame.expired(), "Waiting coroutine was destroyed before its input resolved");
+        pendingInput->Set(std::make_shared<int>(1));
+        AssertTrue(waitingFrame.expired(), "Waiting coroutine frame leaked after its queue was destroyed");
+        AssertTrue(!waiting->Ready(), "Waiting coroutine continued after its queue was destroyed");
+    }
+
+    void BenchmarkAsyncTaskChainLatency() {
+        sp::DispatchQueue queueA("TestChainA", 4);
+        sp::DispatchQueue queueB("TestChainB", 1);
+
+        // Same chain as BenchmarkDispatchChainLatency, written as a single coroutine
+        auto chain = [&]() -> sp::AsyncTask<int> {
+            int value = 0;
+            for (int depth = 0; depth < 5; depth++) {
+                co_await sp::ResumeOn(depth % 2 ? queueB : queueA);
+                if (depth > 0) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(100));
+                    value++;
+                }
+            }
+            co_return std::make_shared<int>(value);
+        };
+
+        auto startStats = sp::GetCoroutineFrameStats();
+        MultiTimer timer("Benchmark 5-deep coroutine chain latency");
+        for (int i = 0; i < 200; i++) {
+            Timer t(timer);
+            sp::AsyncPtr<int> future = chain();
+            AssertEqual(*future->Get(), 4, "Unexpected chain result");
+        }
+        auto stats = sp::GetCoroutineFrameStats();
+        AssertEqual(stats.allocated - startStats.allocated, 200u, "Expected 1 coroutine frame per chain");
+    }
+
+    Test test1(&TestDispatchQueueChaining);
+    Test test2(&TestDispatchQueueBlockingWorkItems);
+    Test test3(&TestManualDispatchQueue);
+    Test test4(&BenchmarkDispatchChainLatency);
+    Test test5(&TestAsyncTaskChaining);
+    Test test6(&TestAsyncTaskManualQueue);
+    Test test7(&BenchmarkAsyncTaskChainLatency);
+    Test test8(&TestAsyncTaskQueueDestroyed);
+    Test test9(&TestWaitOnlyHelpsProducer);
+    Test test10(&TestParallelFor);
+} // namespace DispatchQueueTests
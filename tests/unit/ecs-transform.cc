@@ -6,11 +6,16 @@
  */
 
 #include "ecs/EcsImpl.hh"
+#include "ecs/TransformBatch.hh"
+#include "ecs/TransformHierarchy.hh"
 
 #include <glm/glm.hpp>
+#include <glm/gtc/epsilon.hpp>
 #include <glm/gtc/matrix_access.hpp>
 #include <glm/gtx/transform.hpp>
+#include <limits>
 #include <tests.hh>
+#include <vector>
 
 namespace EcsTransformTests {
     using namespace testing;
@@ -144,5 +149,169 @@ namespace EcsTransformTests {
         }
     }
 
+    void TestTransformHierarchy() {
+        const size_t CHAIN_COUNT = 100;
+        const size_t CHAIN_DEPTH = 100;
+        std::vector<Tecs::Entity> entities;
+        {
+            Timer t("Create " + std::to_string(CHAIN_COUNT) + " transform chains of depth " +
+                    std::to_string(CHAIN_DEPTH));
+            auto lock = ecs::StartTransaction<ecs::AddRemove>();
+            for (size_t i = 0; i < CHAIN_COUNT; i++) {
+                Tecs::Entity parent;
+                for (size_t j = 0; j < CHAIN_DEPTH; j++) {
+                    auto ent = entities.emplace_back(lock.NewEntity());
+                    // Parents are referenced by name, so each node needs one to be used as a parent
+                    auto name = "node" + std::to_string(i) + "_" + std::to_string(j);
+                    ecs::EntityRef ref(ecs::Name("", name), ent);
+                    ent.Set<ecs::Name>(lock, "", name);
+                    auto &tree = ent.Set<ecs::TransformTree>(lock,
+                        glm::vec3(1, 0, 0),
+                        glm::angleAxis(glm::radians(10.0f), glm::vec3(0, 0, 1)));
+                    tree.parent = parent;
+                    ent.Set<ecs::TransformSnapshot>(lock);
+                    parent = ent;
+                }
+            }
+        }
+        auto assertSnapshotsMatch = [&](auto &lock, const std::string &message) {
+            for (auto &ent : entities) {
+                auto globalPose = ent.Get<ecs::TransformTree>(lock).GetGlobalTransform(lock);
+                auto &snapshot = ent.Get<ecs::TransformSnapshot>(lock);
+                AssertTrue(glm::all(glm::epsilonEqual(snapshot.globalPose.GetPosition(),
+                               globalPose.GetPosition(),
+                               0.001f)),
+                    message);
+            }
+        };
+
+        ecs::TransformHierarchy hierarchy;
+        {
+            Timer t("Update all snapshots from the hierarchy");
+            auto lock = ecs::StartTransaction<ecs::Write<ecs::TransformTree, ecs::TransformSnapshot>>();
+            AssertTrue(entities[1].Get<ecs::TransformTree>(lock).parent.Get(lock) == entities[0],
+                "Expected chain nodes to be parented");
+            for (auto &ent : entities) {
+                hierarchy.MarkModified(lock, ent);
+            }
+            AssertEqual(hierarchy.UpdateSnapshots(lock).size(), entities.size(), "Expected all entities to update");
+            AssertEqual(hierarchy.Size(), entities.size(), "Expected all entities to be tracked");
+            assertSnapshotsMatch(lock, "Snapshot doesn't match GetGlobalTransform()");
+        }
+        {
+            Timer t("Move the first chain root and update its descendants");
+            auto lock = ecs::StartTransaction<ecs::Write<ecs::TransformTree, ecs::TransformSnapshot>>();
+            entities[0].Get<ecs::TransformTree>(lock).pose.SetPosition(glm::vec3(0, 5, 0));
+            hierarchy.MarkModified(lock, entities[0]);
+            AssertEqual(hierarchy.UpdateSnapshots(lock).size(), CHAIN_DEPTH, "Expected only one chain to update");
+            assertSnapshotsMatch(lock, "Snapshot doesn't match GetGlobalTransform() after moving a root");
+        }
+        {
+            Timer t("Reparent the first chain under the end of the last chain");
+            auto lock = ecs::StartTransaction<ecs::Write<ecs::TransformTree, ecs::TransformSnapshot>>();
+            entities[0].Get<ecs::TransformTree>(lock).parent = entities.back();
+            hierarchy.MarkModified(lock, entities[0]);
+            auto &updated = hierarchy.UpdateSnapshots(lock);
+            AssertEqual(updated.size(), CHAIN_DEPTH, "Expected only the reparented chain to update");
+            AssertTrue(updated.front() == entities[0], "Expected the reparented root to update first");
+            assertSnapshotsMatch(lock, "Snapshot doesn't match GetGlobalTransform() after reparenting");
+        }
+        {
+            Timer t("Benchmark GetGlobalTransform() for every entity");
+            auto lock = ecs::StartTransaction<ecs::Write<ecs::TransformTree, ecs::TransformSnapshot>>();
+            for (auto &ent : entities) {
+                auto &tree = ent.Get<const ecs::TransformTree>(lock);
+                ent.Get<ecs::TransformSnapshot>(lock).globalPose = tree.GetGlobalTransform(lock);
+            }
+        }
+        {
+            Timer t("Benchmark UpdateSnapshots() after moving every chain root");
+            auto lock = ecs::StartTransaction<ecs::Write<ecs::TransformTree, ecs::TransformSnapshot>>();
+            for (size_t i = 0; i < CHAIN_COUNT; i++) {
+                hierarchy.MarkModified(lock, entities[i * CHAIN_DEPTH]);
+            }
+            AssertEqual(hierarchy.UpdateSnapshots(lock).size(), entities.size(), "Expected all entities to update");
+        }
+        {
+            auto lock = ecs::StartTransaction<ecs::AddRemove>();
+            for (auto &ent : entities) {
+                ent.Destroy(lock);
+            }
+        }
+    }
+
+    void TestTransformBatch() {
+        const size_t TRANSFORM_COUNT = 1000000;
+        std::vector<ecs::Transform> lhs, rhs;
+        lhs.reserve(TRANSFORM_COUNT);
+        rhs.reserve(TRANSFORM_COUNT);
+        for (size_t i = 0; i < TRANSFORM_COUNT; i++) {
+            float f = (float)(i % 100);
+            ecs::Transform a(glm::vec3(f, 1, -2), glm::angleAxis(f * 0.01f, glm::normalize(glm::vec3(1, f, 2))));
+            a.SetScale(glm::vec3(1.0f + (i % 3), 0.5f, 2.0f));
+            ecs::Transform b(glm::vec3(3, -f, 0.5f), glm::angleAxis(f * 0.02f, glm::normalize(glm::vec3(f, 1, -1))));
+            b.SetScale(glm::vec3(0.25f, 1.0f + (i % 5), 1.0f));
+            lhs.emplace_back(a);
+            rhs.emplace_back(b);
+        }
+        // Undefined transforms must fall back to the scalar math
+        lhs[5].offset[0][0] = std::numeric_limits<float>::infinity();
+
+        auto assertTransformsMatch = [](const std::vector<ecs::Transform> &batch,
+                                         const std::vector<ecs::Transform> &scalar,
+                                         const std::string &message) {
+            for (size_t i = 0; i < batch.size(); i++) {
+                AssertTrue(glm::all(glm::epsilonEqual(batch[i].GetPosition(), scalar[i].GetPosition(), 0.001f)) &&
+                               glm::all(glm::epsilonEqual(batch[i].GetScale(), scalar[i].GetScale(), 0.001f)),
+                    message);
+            }
+        };
+
+        std::string suffix = " transforms (" + std::string(ecs::TransformBatchInstructionSet()) + ")";
+        std::vector<ecs::Transform> scalarOut(TRANSFORM_COUNT), batchOut(TRANSFORM_COUNT);
+        {
+            Timer t("Scalar compose 1M" + suffix);
+            for (size_t i = 0; i < TRANSFORM_COUNT; i++) {
+                scalarOut[i] = lhs[i] * rhs[i];
+            }
+        }
+        {
+            Timer t("Batch compose 1M" + suffix);
+            ecs::ComposeTransforms(lhs, rhs, batchOut);
+        }
+        assertTransformsMatch(batchOut, scalarOut, "ComposeTransforms() doesn't match operator*");
+        {
+            Timer t("Scalar invert 1M" + suffix);
+            for (size_t i = 0; i < TRANSFORM_COUNT; i++) {
+                scalarOut[i] = lhs[i].GetInverse();
+            }
+        }
+        {
+            Timer t("Batch invert 1M" + suffix);
+            ecs::InvertTransforms(lhs, batchOut);
+        }
+        assertTransformsMatch(batchOut, scalarOut, "InvertTransforms() doesn't match GetInverse()");
+
+        std::vector<glm::mat4> scalarMatrices(TRANSFORM_COUNT), batchMatrices(TRANSFORM_COUNT);
+        {
+            Timer t("Scalar GetMatrix 1M" + suffix);
+            for (size_t i = 0; i < TRANSFORM_COUNT; i++) {
+                scalarMatrices[i] = lhs[i].GetMatrix();
+            }
+        }
+        {
+            Timer t("Batch TransformsToMatrices 1M" + suffix);
+            ecs::TransformsToMatrices(lhs, batchMatrices);
+        }
+        for (size_t i = 0; i < TRANSFORM_COUNT; i++) {
+            for (int c = 0; c < 4; c++) {
+                AssertTrue(glm::all(glm::epsilonEqual(batchMatrices[i][c], scalarMatrices[i][c], 0.001f)),
+                    "TransformsToMatrices() doesn't match GetMatrix()");
+            }
+        }
+    }
+
     Test test1(&TestTransformTree);
+    Test test2(&TestTransformHierarchy);
+    Test test3(&TestTransformBatch);
 } // namespace EcsTransformTests
@@ -0,0 +1,79 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "ecs/EcsImpl.hh"
+#include "strayphotons/EntityMap.hh"
+
+#include <tests.hh>
+#include <vector>
+
+namespace EntityMapTests {
+    using namespace testing;
+
+    void TestEntityMap() {
+        const size_t ENTITY_COUNT = 10000;
+        std::vector<Tecs::Entity> entities;
+        {
+            auto lock = ecs::StartTransaction<ecs::AddRemove>();
+            for (size_t i = 0; i < ENTITY_COUNT; i++) {
+                entities.emplace_back(lock.NewEntity());
+            }
+        }
+
+        sp::EntityMap<size_t> map;
+        {
+            Timer t("Insert and erase every other entity");
+            for (size_t i = 0; i < ENTITY_COUNT; i++) {
+                map[entities[i]] = i;
+            }
+            for (size_t i = 0; i < ENTITY_COUNT; i += 2) {
+                map.erase(entities[i]);
+            }
+            AssertEqual(map.size(), ENTITY_COUNT / 2, "Expected half of the entities to be erased");
+        }
+        {
+            Timer t("Lookup and iterate remaining entities");
+            for (size_t i = 0; i < ENTITY_COUNT; i++) {
+                AssertEqual(map.count(entities[i]), i % 2, "Unexpected EntityMap count");
+            }
+            size_t total = 0;
+            for (auto &entry : map) {
+                AssertEqual(entry.second, map[entry.first], "Expected iteration to match lookup");
+                total++;
+            }
+            AssertEqual(total, ENTITY_COUNT / 2, "Expected iteration to only visit stored entries");
+        }
+
+        sp::EntityMap<size_t *, true> indexed;
+        std::vector<size_t> values(ENTITY_COUNT / 10);
+        {
+            Timer t("Erase indexed entries by value");
+            for (size_t i = 0; i < ENTITY_COUNT; i++) {
+                indexed.insert_or_assign(entities[i], &values[i % values.size()]);
+            }
+            // Reassigning a value must move the entry to the new value's index
+            indexed.insert_or_assign(entities[0], &values[1]);
+            for (size_t i = 0; i < values.size(); i += 2) {
+                indexed.erase(&values[i]);
+            }
+            AssertEqual(indexed.size(), ENTITY_COUNT / 2 + 1, "Expected every entry with an erased value to be removed");
+            AssertEqual(indexed.count(entities[0]), 1u, "Expected reassigned entry to be kept");
+            for (auto &entry : indexed) {
+                AssertTrue((entry.second - values.data()) % 2 == 1, "Expected only odd values to remain");
+            }
+        }
+
+        {
+            auto lock = ecs::StartTransaction<ecs::AddRemove>();
+            for (auto &ent : entities) {
+                ent.Destroy(lock);
+            }
+        }
+    }
+
+    Test test(&TestEntityMap);
+} // namespace EntityMapTests
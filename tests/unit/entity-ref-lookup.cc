@@ -0,0 +1,107 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "ecs/EcsImpl.hh"
+#include "ecs/EntityReferenceManager.hh"
+
+#include <atomic>
+#include <tests.hh>
+#include <thread>
+#include <vector>
+
+namespace EntityRefLookupTests {
+    using namespace testing;
+
+    const size_t ENTITY_COUNT = 4096;
+    const size_t THREAD_COUNT = 8;
+    const size_t LOOKUPS_PER_THREAD = 200000;
+
+    size_t HammerLookups(const std::vector<ecs::Name> &names, const std::vector<ecs::Entity> &entities) {
+        size_t mismatches = 0;
+        uint32_t seed = (uint32_t)std::hash<std::thread::id>()(std::this_thread::get_id());
+        for (size_t i = 0; i < LOOKUPS_PER_THREAD; i++) {
+            seed = seed * 1664525u + 1013904223u;
+            size_t index = (seed >> 8) % ENTITY_COUNT;
+            if (i % 2 == 0) {
+                ecs::EntityRef ref(names[index]);
+                if (ref.GetLive() != entities[index]) mismatches++;
+            } else {
+                ecs::EntityRef ref(entities[index]);
+                if (!ref || ref.GetLive() != entities[index]) mismatches++;
+            }
+        }
+        return mismatches;
+    }
+
+    void TestConcurrentEntityRefLookups() {
+        std::vector<ecs::Name> names;
+        std::vector<ecs::Entity> entities;
+        std::vector<ecs::EntityRef> refs;
+        {
+            Timer t("Create " + std::to_string(ENTITY_COUNT) + " named entities");
+            auto lock = ecs::StartTransaction<ecs::AddRemove>();
+            for (size_t i = 0; i < ENTITY_COUNT; i++) {
+                auto &name = names.emplace_back("lookup", "ent" + std::to_string(i));
+                auto &ent = entities.emplace_back(lock.NewEntity());
+                ent.Set<ecs::Name>(lock, name);
+                refs.emplace_back(name, ent);
+            }
+        }
+        {
+            Timer t("Look up " + std::to_string(LOOKUPS_PER_THREAD) + " refs from 1 thread");
+            AssertEqual(HammerLookups(names, entities), 0u, "Lookups returned the wrong entity");
+        }
+        {
+            Timer t("Look up " + std::to_string(LOOKUPS_PER_THREAD) + " refs from each of " +
+                    std::to_string(THREAD_COUNT) + " threads");
+            std::atomic_size_t mismatches = 0;
+            std::vector<std::thread> threads;
+            for (size_t i = 0; i < THREAD_COUNT; i++) {
+                threads.emplace_back([&] {
+                    mismatches += HammerLookups(names, entities);
+                });
+            }
+            for (auto &thread : threads) {
+                thread.join();
+            }
+            AssertEqual(mismatches.load(), 0u, "Concurrent lookups returned the wrong entity");
+        }
+        {
+            Timer t("Look up refs from " + std::to_string(THREAD_COUNT) + " threads while creating new refs");
+            std::atomic_size_t mismatches = 0;
+            std::vector<std::thread> threads;
+            for (size_t i = 0; i < THREAD_COUNT; i++) {
+                threads.emplace_back([&, i] {
+                    if (i == 0) {
+                        // Grows the name table underneath the readers
+                        for (size_t j = 0; j < ENTITY_COUNT * 4; j++) {
+                            ecs::EntityRef ref(ecs::Name("lookup_new", "ent" + std::to_string(j)));
+                            if (!ref || ref.GetLive()) mismatches++;
+                        }
+                    } else {
+                        mismatches += HammerLookups(names, entities);
+                    }
+                });
+            }
+            for (auto &thread : threads) {
+                thread.join();
+            }
+            AssertEqual(mismatches.load(), 0u, "Lookups returned the wrong entity while the table was growing");
+        }
+        for (size_t i = 0; i < ENTITY_COUNT; i++) {
+            AssertTrue(ecs::EntityRef(names[i]) == refs[i], "Expected the same ref to be returned for a name");
+        }
+        {
+            auto lock = ecs::StartTransaction<ecs::AddRemove>();
+            for (auto &ent : entities) {
+                ent.Destroy(lock);
+            }
+        }
+    }
+
+    Test test(&TestConcurrentEntityRefLookups);
+} // namespace EntityRefLookupTests
@@ -0,0 +1,101 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "common/FramePipeline.hh"
+
+#include <atomic>
+#include <tests.hh>
+#include <thread>
+#include <vector>
+
+namespace FramePipelineTests {
+    using namespace testing;
+
+    void TestFramePipelineOrdering() {
+        sp::FramePipeline pipeline;
+        pipeline.SetEnabled(true);
+        for (size_t i = 0; i < sp::FRAME_PHASE_COUNT; i++) {
+            pipeline.SetPhaseActive((sp::FramePhase)i, true);
+        }
+
+        const int frameCount = 200;
+        std::array<std::atomic_int, sp::FRAME_PHASE_COUNT> running = {};
+        std::array<std::atomic_int, sp::FRAME_PHASE_COUNT> completed = {};
+        std::atomic_bool orderViolation = false, leadViolation = false;
+
+        Timer t("Run 200 pipelined frames across 3 phases");
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < sp::FRAME_PHASE_COUNT; i++) {
+            threads.emplace_back([&, i] {
+                auto phase = (sp::FramePhase)i;
+                while (completed[0] < frameCount || (i > 0 && completed[i] < completed[i - 1])) {
+                    pipeline.BeginPhase(phase);
+                    running[i]++;
+                    // An upstream phase must have finished at least one frame more than this phase
+                    if (i > 0 && completed[i - 1] <= completed[i]) orderViolation = true;
+                    // A downstream phase may lag by at most 2 completed frames (1 in flight, 1 being produced)
+                    if (i + 1 < sp::FRAME_PHASE_COUNT && completed[i] - completed[i + 1] > 2) leadViolation = true;
+                    std::this_thread::sleep_for(std::chrono::microseconds(100 * (i + 1)));
+                    running[i]--;
+                    completed[i]++;
+                    pipeline.EndPhase(phase);
+                }
+                pipeline.SetPhaseActive(phase, false);
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+
+        AssertTrue(!orderViolation, "Phase started before upstream phase produced a new frame");
+        AssertTrue(!leadViolation, "Phase ran more than one frame ahead of downstream phase");
+        auto stats = pipeline.GetStats();
+        for (auto &phase : stats.phases) {
+            AssertEqual(phase.timeouts, 0u, "Frame pipeline barrier timed out");
+        }
+    }
+
+    void TestFramePipelineDownstreamStall() {
+        sp::FramePipeline pipeline;
+        pipeline.SetEnabled(true);
+        pipeline.SetPhaseActive(sp::FramePhase::Logic, true);
+        pipeline.SetPhaseActive(sp::FramePhase::Physics, true);
+
+        // Physics completes a single frame and then stops making progress while still active
+        pipeline.BeginPhase(sp::FramePhase::Logic);
+        pipeline.EndPhase(sp::FramePhase::Logic);
+        pipeline.BeginPhase(sp::FramePhase::Physics);
+        pipeline.EndPhase(sp::FramePhase::Physics);
+
+        const int frameCount = 20;
+        {
+            Timer t("Run 20 logic frames with a stalled physics phase");
+            auto start = chrono_clock::now();
+            for (int i = 0; i < frameCount; i++) {
+                pipeline.BeginPhase(sp::FramePhase::Logic);
+                pipeline.EndPhase(sp::FramePhase::Logic);
+            }
+            // Only the first wait on the stalled phase should time out, rather than one wait per frame
+            AssertTrue(chrono_clock::now() - start < std::chrono::milliseconds(500),
+                "Logic phase kept waiting on a stalled physics phase");
+        }
+
+        // Once physics completes another frame the barrier applies again
+        pipeline.BeginPhase(sp::FramePhase::Physics);
+        pipeline.EndPhase(sp::FramePhase::Physics);
+        pipeline.BeginPhase(sp::FramePhase::Logic);
+        pipeline.EndPhase(sp::FramePhase::Logic);
+        auto start = chrono_clock::now();
+        pipeline.BeginPhase(sp::FramePhase::Logic);
+        pipeline.EndPhase(sp::FramePhase::Logic);
+        AssertTrue(chrono_clock::now() - start >= std::chrono::milliseconds(10),
+            "Logic phase ran ahead of a resumed physics phase");
+    }
+
+    Test test1(&TestFramePipelineOrdering);
+    Test test2(&TestFramePipelineDownstreamStall);
+} // namespace FramePipelineTests
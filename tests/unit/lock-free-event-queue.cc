@@ -0,0 +1,137 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "strayphotons/LockFreeEventQueue.hh"
+
+#include <tests.hh>
+#include <thread>
+#include <vector>
+
+namespace LockFreeEventQueueTests {
+    using namespace testing;
+
+    struct TestEvent {
+        int producer = -1;
+        int sequence = -1;
+    };
+
+    void TestEventQueueOrdering() {
+        sp::LockFreeEventQueue<TestEvent, 16> queue;
+
+        for (int i = 0; i < 10; i++) {
+            queue.PushEvent(TestEvent{0, i});
+        }
+        int expected = 0;
+        queue.PollEvents([&](const TestEvent &event) {
+            AssertEqual(event.sequence, expected++, "Events polled out of order");
+        });
+        AssertEqual(expected, 10, "Expected all events to be polled");
+
+        for (int i = 0; i < 40; i++) {
+            queue.PushEvent(TestEvent{0, i});
+        }
+        AssertEqual(queue.GetOverflowCount(), 24u, "Expected events beyond ring capacity to spill");
+        expected = 0;
+        AssertTrue(queue.TryPollEvents([&](const TestEvent &event) {
+            AssertEqual(event.sequence, expected++, "Spilled events polled out of order");
+        }),
+            "Expected TryPollEvents to succeed");
+        AssertEqual(expected, 40, "Expected spilled events to be polled");
+        AssertEqual(queue.GetDroppedCount(), 0u, "Expected no events to be dropped");
+    }
+
+    void TestEventQueueDropOnOverflow() {
+        sp::LockFreeEventQueue<TestEvent, 16, false> queue;
+
+        for (int i = 0; i < 20; i++) {
+            queue.PushEvent(TestEvent{0, i});
+        }
+        AssertEqual(queue.GetDroppedCount(), 4u, "Expected events beyond ring capacity to be dropped");
+        int count = 0;
+        queue.PollEvents([&](const TestEvent &) {
+            count++;
+        });
+        AssertEqual(count, 16, "Expected a full ring of events");
+    }
+
+    void TestEventQueueMultipleProducers() {
+        const int producerCount = 4;
+        const int eventCount = 10000;
+        sp::LockFreeEventQueue<TestEvent, 256> queue;
+
+        Timer t("Push events from multiple threads while polling");
+        std::vector<std::thread> producers;
+        for (int p = 0; p < producerCount; p++) {
+            producers.emplace_back([&queue, p] {
+                for (int i = 0; i < eventCount; i++) {
+                    queue.PushEvent(TestEvent{p, i});
+                }
+            });
+        }
+
+        std::vector<int> received(producerCount, 0);
+        auto pollCallback = [&](const TestEvent &event) {
+            AssertTrue(event.producer >= 0 && event.producer < producerCount, "Invalid event producer");
+            AssertEqual(event.sequence, received[event.producer]++, "Events from a producer polled out of order");
+        };
+        int total = 0;
+        while (total < producerCount * eventCount) {
+            queue.PollEvents(pollCallback);
+            total = 0;
+            for (auto count : received) {
+                total += count;
+            }
+        }
+        for (auto &producer : producers) {
+            producer.join();
+        }
+        AssertEqual(total, producerCount * eventCount, "Expected every event to be polled");
+        AssertEqual(queue.GetDroppedCount(), 0u, "Expected no events to be dropped");
+    }
+
+    void TestEventQueueSpillOrdering() {
+        const int producerCount = 4;
+        const int eventCount = 20000;
+        // A tiny ring forces producers onto the spill path while the consumer is draining it
+        sp::LockFreeEventQueue<TestEvent, 4> queue;
+
+        Timer t("Push spilled events from multiple threads while polling");
+        std::vector<std::thread> producers;
+        for (int p = 0; p < producerCount; p++) {
+            producers.emplace_back([&queue, p] {
+                for (int i = 0; i < eventCount; i++) {
+                    queue.PushEvent(TestEvent{p, i});
+                    if (i % 64 == 0) std::this_thread::yield();
+                }
+            });
+        }
+
+        std::vector<int> received(producerCount, 0);
+        auto pollCallback = [&](const TestEvent &event) {
+            AssertTrue(event.producer >= 0 && event.producer < producerCount, "Invalid event producer");
+            AssertEqual(event.sequence, received[event.producer]++, "Spilled events from a producer out of order");
+        };
+        int total = 0;
+        while (total < producerCount * eventCount) {
+            queue.PollEvents(pollCallback);
+            total = 0;
+            for (auto count : received) {
+                total += count;
+            }
+        }
+        for (auto &producer : producers) {
+            producer.join();
+        }
+        AssertTrue(queue.GetOverflowCount() > 0, "Expected events to spill from the ring");
+        AssertEqual(total, producerCount * eventCount, "Expected every event to be polled");
+    }
+
+    Test test1(&TestEventQueueOrdering);
+    Test test2(&TestEventQueueDropOnOverflow);
+    Test test3(&TestEventQueueMultipleProducers);
+    Test test4(&TestEventQueueSpillOrdering);
+} // namespace LockFreeEventQueueTests
@@ -62,5 +62,85 @@ namespace PreservingMapTests {
         }
     }
 
+    sp::PreservingMap<int, int, 100> largeMap;
+
+    void TestIncrementalTick() {
+        const int ENTRY_COUNT = 100000;
+        std::vector<std::shared_ptr<int>> held;
+        {
+            Timer t("Register large preserving map");
+            largeMap.Tick(std::chrono::milliseconds(1));
+            for (int i = 0; i < ENTRY_COUNT; i++) {
+                auto ptr = std::make_shared<int>(i);
+                largeMap.Register(i, ptr);
+                if (i % 10 == 0) held.emplace_back(ptr);
+            }
+            AssertEqual(largeMap.Size(), (size_t)ENTRY_COUNT, "Expected all entries to be registered");
+        }
+        {
+            Timer t("Incrementally tick large preserving map");
+            // Each tick only scans part of the map, but time between scans still counts towards expiry
+            for (int i = 0; i < 200; i++) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                largeMap.Tick(std::chrono::milliseconds(10));
+            }
+            AssertEqual(largeMap.Size(), held.size(), "Expected only referenced entries to remain");
+            for (int i = 0; i < ENTRY_COUNT; i++) {
+                auto ptr = largeMap.Load(i);
+                AssertEqual(ptr != nullptr, i % 10 == 0, "Expected only referenced entries to remain");
+            }
+        }
+        held.clear();
+        AssertEqual(largeMap.DropAll(), (size_t)ENTRY_COUNT / 10, "Expected remaining entries to be dropped");
+        AssertEqual(largeMap.Size(), 0u, "Expected preserving map to be empty");
+    }
+
+    sp::PreservingMap<int, int, 100> rotationMap;
+
+    void TestShardRotation() {
+        const int ENTRY_COUNT = 100000;
+        std::vector<std::shared_ptr<int>> held;
+        rotationMap.Tick(std::chrono::milliseconds(1));
+        for (int i = 0; i < ENTRY_COUNT; i++) {
+            auto ptr = std::make_shared<int>(i);
+            rotationMap.Register(i, ptr);
+            held.emplace_back(ptr);
+        }
+        {
+            Timer t("Tick large preserving map while all entries are referenced");
+            // A full rotation over every shard takes longer than the preserve age
+            for (int i = 0; i < 40; i++) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                rotationMap.Tick(std::chrono::milliseconds(10));
+            }
+        }
+        for (int i = 0; i < ENTRY_COUNT; i += 100) {
+            held[i].reset();
+        }
+        {
+            Timer t("Rotate through every shard right after releasing entries");
+            for (int i = 0; i < 30; i++) {
+                rotationMap.Tick(std::chrono::milliseconds(10));
+            }
+            for (int i = 0; i < ENTRY_COUNT; i += 100) {
+                AssertTrue(rotationMap.Contains(i), "Expected released entry to be preserved after its last use");
+            }
+        }
+        {
+            Timer t("Tick large preserving map until released entries expire");
+            for (int i = 0; i < 60; i++) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                rotationMap.Tick(std::chrono::milliseconds(10));
+            }
+            for (int i = 0; i < ENTRY_COUNT; i++) {
+                AssertEqual(rotationMap.Contains(i), i % 100 != 0, "Expected only released entries to expire");
+            }
+        }
+        held.clear();
+        rotationMap.DropAll();
+    }
+
     Test test(&TestPreservingMap);
+    Test test2(&TestIncrementalTick);
+    Test test3(&TestShardRotation);
 } // namespace PreservingMapTests
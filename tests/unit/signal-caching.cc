@@ -36,16 +36,16 @@ namespace SignalCachingTests {
     }
 
     void AssertSubscribers(const ecs::Signals &signals, size_t index, std::initializer_list<size_t> subscriberIndexes) {
-        auto &signal = signals.signals[index];
-        AssertEqual(signal.subscribers.size(), subscriberIndexes.size(), "Wrong number of subscribers");
+        auto subscribers = signals.subscribers.Get(index);
+        AssertEqual(subscribers.size(), subscriberIndexes.size(), "Wrong number of subscribers");
         size_t i = 0;
-        for (auto &sub : signal.subscribers) {
+        for (auto &sub : subscribers) {
             auto subscriber = sub.lock();
             if (!subscriber) continue;
             AssertEqual(subscriber->index, *(subscriberIndexes.begin() + i), "Wrong subscriber index");
-            AssertTrue(subscriber->index < signals.signals.size(), "Wrong subscriber index");
+            AssertTrue(subscriber->index < signals.Size(), "Wrong subscriber index");
             bool found = false;
-            for (auto &dep : signals.signals[subscriber->index].dependencies) {
+            for (auto &dep : signals.dependencies.Get(subscriber->index)) {
                 auto dependency = dep.lock();
                 if (!dependency) continue;
                 if (dependency->index == index) {
@@ -59,25 +59,26 @@ namespace SignalCachingTests {
     }
 
     void CheckSignals(const ecs::Signals &signals, const std::map<size_t, std::optional<double>> &lastValues) {
-        for (size_t index = 0; index < signals.signals.size(); index++) {
+        for (size_t index = 0; index < signals.Size(); index++) {
             auto it = lastValues.find(index);
             AssertTrue(it != lastValues.end(), "Signal index not in expected list: " + std::to_string(index));
-            auto &signal = signals.signals[index];
-            AssertTrue((bool)signal.ref, "Expected all signals to have refs");
-            if (!std::isinf(signal.value)) {
-                AssertTrue(!signal.lastValueDirty, "Expected value signal not to be dirty");
-                AssertEqual(signal.value, signal.lastValue, "Expected value signal to have correct lastValue");
-                AssertEqual(signal.value,
+            AssertTrue((bool)signals.refs[index], "Expected all signals to have refs");
+            if (!std::isinf(signals.values[index])) {
+                AssertTrue(!signals.lastValueDirty[index], "Expected value signal not to be dirty");
+                AssertEqual(signals.values[index],
+                    signals.lastValues[index],
+                    "Expected value signal to have correct lastValue");
+                AssertEqual(signals.values[index],
                     it->second,
                     "Unexpected signal value for signal index: " + std::to_string(index));
             } else {
-                if (signal.lastValueDirty) {
+                if (signals.lastValueDirty[index]) {
                     AssertEqual(it->second,
                         std::optional<size_t>(),
                         "Unexpected signal value for signal index: " + std::to_string(index));
                 } else {
                     AssertEqual(it->second,
-                        signal.lastValue,
+                        signals.lastValues[index],
                         "Unexpected signal value for signal index: " + std::to_string(index));
                 }
             }
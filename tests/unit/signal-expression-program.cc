@@ -0,0 +1,193 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "ecs/EcsImpl.hh"
+#include "ecs/SignalExpression.hh"
+#include "ecs/SignalExpressionNode.hh"
+#include "ecs/SignalExpressionProgram.hh"
+#include "ecs/SignalManager.hh"
+
+#include <limits>
+#include <tests.hh>
+#include <vector>
+
+namespace SignalExpressionProgramTests {
+    using namespace testing;
+
+    const size_t BENCHMARK_EXPRESSION_COUNT = 100000;
+
+    std::string BenchmarkExpression(size_t i) {
+        auto n = std::to_string(i % 97);
+        switch (i % 5) {
+        case 0:
+            return "source/a + " + n + " * source/b";
+        case 1:
+            return "source/a > " + std::to_string(i % 7) + " ? max(source/b, source/c) : -source/d";
+        case 2:
+            return "sin(source/a) * cos(source/b) + abs(source/c - " + n + ")";
+        case 3:
+            return "(source/a + 1) * (source/a + 1) / (" + n + " + 2 * 3)";
+        default:
+            return "!(source/c >= 2) || (source/d * 0.5 <= " + n + " && source/a != 0)";
+        }
+    }
+
+    void TestProgramCompile() {
+        ecs::Entity source;
+        {
+            auto lock = ecs::StartTransaction<ecs::AddRemove>();
+            source = lock.NewEntity();
+            ecs::EntityRef sourceRef(ecs::Name("bench", "source"), source);
+            source.Set<ecs::Name>(lock, "bench", "source");
+            ecs::SignalRef(source, "a").SetValue(lock, 3.0);
+            ecs::SignalRef(source, "b").SetValue(lock, -2.0);
+            ecs::SignalRef(source, "c").SetValue(lock, 5.0);
+            ecs::SignalRef(source, "d").SetValue(lock, 0.25);
+            // Component fields aren't sanitized like signal values, and can feed non-finite values into expressions
+            float inf = std::numeric_limits<float>::infinity();
+            source.Set<ecs::TransformSnapshot>(lock, ecs::Transform(glm::vec3(inf, 0, 0)));
+        }
+        {
+            Timer t("Compile signal expression programs");
+            auto lock = ecs::StartTransaction<ecs::ReadSignalsLock>();
+
+            ecs::SignalExpression folded("1 + 2 * 3 - max(4, 2) / 2");
+            AssertTrue(folded.program != nullptr, "Expected expression to be compiled");
+            AssertEqual(folded.program->InstructionCount(), 0u, "Expected constant expression to be folded");
+            AssertEqual(folded.Evaluate(lock), 5.0, "Unexpected folded expression result");
+
+            // The repeated subexpression is a single shared node, so it should only be computed once
+            ecs::SignalExpression shared("(source/a + 1) * (source/a + 1)", ecs::Name("bench", ""));
+            AssertTrue(shared.program != nullptr, "Expected expression to be compiled");
+            AssertEqual(shared.program->InstructionCount(), 3u, "Expected shared subexpression to be reused");
+            AssertEqual(shared.Evaluate(lock), 16.0, "Unexpected shared expression result");
+
+            ecs::SignalExpression decider("1 > 0 ? source/a : source/b", ecs::Name("bench", ""));
+            AssertEqual(decider.program->InstructionCount(), 1u, "Expected constant condition to be folded");
+            AssertEqual(decider.Evaluate(lock), 3.0, "Unexpected decider expression result");
+
+            ecs::SignalExpression branch("source/d > 0 ? source/a / 0 : source/b", ecs::Name("bench", ""));
+            AssertEqual(branch.Evaluate(lock), 0.0, "Expected divide by zero to return 0");
+
+            ecs::SignalExpression empty("");
+            AssertEqual(empty.Evaluate(lock), 0.0, "Expected empty expression to return 0");
+        }
+
+        std::vector<ecs::SignalExpression> expressions;
+        expressions.reserve(BENCHMARK_EXPRESSION_COUNT);
+        {
+            Timer t("Bind " + std::to_string(BENCHMARK_EXPRESSION_COUNT) + " signal expressions");
+            for (size_t i = 0; i < BENCHMARK_EXPRESSION_COUNT; i++) {
+                auto &expr = expressions.emplace_back(BenchmarkExpression(i), ecs::Name("bench", ""));
+                AssertTrue(expr.program != nullptr, "Expected expression to be compiled: " + expr.expr.str());
+            }
+        }
+        {
+            auto lock = ecs::StartTransaction<ecs::ReadSignalsLock>();
+            ecs::DynamicLock<ecs::ReadSignalsLock> dynamicLock(lock);
+
+            std::vector<double> treeResults(expressions.size());
+            std::vector<double> programResults(expressions.size());
+            {
+                Timer t("Evaluate signal expressions with node tree");
+                for (size_t i = 0; i < expressions.size(); i++) {
+                    ecs::expression::Context ctx(dynamicLock, expressions[i], 0.0);
+                    treeResults[i] = expressions[i].rootNode->Evaluate(ctx, 0);
+                }
+            }
+            {
+                Timer t("Evaluate signal expressions with bytecode");
+                for (size_t i = 0; i < expressions.size(); i++) {
+                    programResults[i] = expressions[i].Evaluate(dynamicLock);
+                }
+            }
+            for (size_t i = 0; i < expressions.size(); i++) {
+                AssertEqual(programResults[i],
+                    treeResults[i],
+                    "Expected bytecode to match node tree: " + expressions[i].expr.str());
+            }
+        }
+#ifndef SP_DEBUG
+        {
+            // Debug builds assert on non-finite node results, so this is only checked in release builds.
+            // sin(inf) is NaN, which must take the false branch in both interpreters.
+            auto lock = ecs::StartTransaction<ecs::ReadSignalsLock, ecs::Read<ecs::TransformSnapshot>>();
+            ecs::DynamicLock<ecs::ReadSignalsLock> dynamicLock(lock);
+            ecs::SignalExpression nanDecider("sin(source#transform_snapshot.translate.x) ? source/a : source/b",
+                ecs::Name("bench", ""));
+            AssertTrue(nanDecider.program != nullptr, "Expected expression to be compiled");
+            ecs::expression::Context ctx(dynamicLock, nanDecider, 0.0);
+            double treeResult = nanDecider.rootNode->Evaluate(ctx, 0);
+            AssertEqual(treeResult, -2.0, "Expected NaN condition to take the false branch in the node tree");
+            AssertEqual(nanDecider.Evaluate(dynamicLock),
+                treeResult,
+                "Expected bytecode to match node tree: " + nanDecider.expr.str());
+        }
+#endif
+    }
+
+    void TestProgramBatch() {
+        const size_t bindingCount = 100;
+        ecs::Entity source;
+        std::vector<ecs::SignalRef> outputs;
+        {
+            auto lock = ecs::StartTransaction<ecs::AddRemove>();
+            source = lock.NewEntity();
+            ecs::EntityRef sourceRef(ecs::Name("batch", "source"), source);
+            source.Set<ecs::Name>(lock, "batch", "source");
+            ecs::SignalRef(source, "a").SetValue(lock, 3.0);
+            ecs::SignalRef(source, "b").SetValue(lock, -2.0);
+            for (size_t i = 0; i < bindingCount; i++) {
+                auto n = std::to_string(i);
+                auto &first = outputs.emplace_back(source, "first" + n);
+                first.SetBinding(lock, "source/a * " + n + " + source/b", ecs::Name("batch", ""));
+                // Each second binding depends on a first binding, so it can only be batched in the next round
+                auto &second = outputs.emplace_back(source, "second" + n);
+                second.SetBinding(lock,
+                    "source/first" + n + " > 100 ? source/first" + n + " / " + n + " : -source/a",
+                    ecs::Name("batch", ""));
+            }
+        }
+        {
+            Timer t("Update batched signals");
+            auto lock = ecs::StartTransaction<ecs::Write<ecs::Signals>, ecs::ReadSignalsLock>();
+            auto stats = ecs::GetSignalManager().UpdateDirtySignals(lock);
+            // Setting source/a and source/b also queues them, but they are already up to date
+            AssertEqual(stats.queued, outputs.size() + 2, "Expected only new signals to be queued");
+            AssertEqual(stats.batched, outputs.size(), "Expected all bindings to be batched");
+            AssertEqual(stats.evaluated, outputs.size(), "Expected each binding to be evaluated once");
+            AssertTrue(lock.Get<ecs::Signals>().dirtyValues.empty(), "Expected dirty worklist to be empty");
+        }
+        {
+            auto lock = ecs::StartTransaction<ecs::ReadSignalsLock>();
+            auto &signals = lock.Get<ecs::Signals>();
+            for (auto &output : outputs) {
+                size_t index = output.GetIndex();
+                AssertTrue(!signals.lastValueDirty[index], "Expected batched signal to be clean: " + output.String());
+                AssertEqual(signals.lastValues[index],
+                    signals.exprs[index].Evaluate(lock),
+                    "Expected batched signal to match scalar evaluation: " + output.String());
+            }
+            AssertEqual(outputs[2 * 50].GetSignal(lock), 148.0, "Unexpected batched signal value");
+            AssertEqual(outputs[2 * 50 + 1].GetSignal(lock), 148.0 / 50, "Unexpected batched signal value");
+            AssertEqual(outputs[2 * 3 + 1].GetSignal(lock), -3.0, "Unexpected batched signal value");
+        }
+        {
+            auto lock = ecs::StartTransaction<ecs::Write<ecs::Signals>, ecs::ReadSignalsLock>();
+            ecs::SignalRef(source, "b").SetValue(lock, 1.0);
+            // Only source/b and the bindings that depend on it should be visited
+            auto stats = ecs::GetSignalManager().UpdateDirtySignals(lock, false);
+            AssertEqual(stats.queued, bindingCount * 2 + 1, "Expected subscribers of changed signal to be queued");
+            AssertEqual(stats.evaluated, bindingCount * 2, "Expected each queued binding to be evaluated once");
+            AssertEqual(outputs[2 * 50].GetSignal(lock), 151.0, "Unexpected updated signal value");
+            AssertEqual(outputs[2 * 50 + 1].GetSignal(lock), 151.0 / 50, "Unexpected updated signal value");
+        }
+    }
+
+    Test test1(&TestProgramCompile);
+    Test test2(&TestProgramBatch);
+} // namespace SignalExpressionProgramTests
@@ -0,0 +1,93 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "ecs/EcsImpl.hh"
+#include "ecs/SignalRefCache.hh"
+
+#include <string>
+#include <tests.hh>
+#include <vector>
+
+namespace SignalRefCacheTests {
+    using namespace testing;
+
+    static constexpr ecs::SignalName TEST_SIGNAL_A("value_a");
+    static constexpr ecs::SignalName TEST_SIGNAL_B("value_b");
+    static_assert(TEST_SIGNAL_A.hash != TEST_SIGNAL_B.hash, "Expected signal names to be hashed at compile time");
+
+    void TestSignalRefCache() {
+        ecs::SignalRefCache cache;
+        ecs::Entity first, second;
+        {
+            auto lock = ecs::StartTransaction<ecs::AddRemove>();
+            first = lock.NewEntity();
+            ecs::EntityRef firstRef(ecs::Name("cache", "first"), first);
+            first.Set<ecs::Name>(lock, "cache", "first");
+            second = lock.NewEntity();
+            ecs::EntityRef secondRef(ecs::Name("cache", "second"), second);
+            second.Set<ecs::Name>(lock, "cache", "second");
+
+            auto refA = cache.Get(lock, first, TEST_SIGNAL_A);
+            AssertTrue(refA == ecs::SignalRef(first, "value_a"), "Expected cached ref to match SignalManager ref");
+            AssertTrue(cache.Get(lock, first, TEST_SIGNAL_A) == refA, "Expected cached ref to be reused");
+            AssertTrue(cache.Get(lock, second, TEST_SIGNAL_A) == ecs::SignalRef(second, "value_a"),
+                "Expected ref per entity");
+            AssertTrue(cache.Get(lock, first, TEST_SIGNAL_B) == ecs::SignalRef(first, "value_b"),
+                "Expected ref per name");
+            AssertEqual(cache.Size(), 3u, "Expected one cached ref per entity and name");
+
+            refA.SetValue(lock, 42.0);
+            AssertEqual(cache.Get(lock, first, TEST_SIGNAL_A).GetSignal(lock),
+                42.0,
+                "Expected cached ref to read value");
+        }
+        {
+            auto lock = ecs::StartTransaction<ecs::AddRemove>();
+            first.Destroy(lock);
+            auto third = lock.NewEntity();
+            ecs::EntityRef thirdRef(ecs::Name("cache", "third"), third);
+            third.Set<ecs::Name>(lock, "cache", "third");
+            // The cached ref must not be returned for a different entity, even if the entity id is reused
+            AssertTrue(cache.Get(lock, third, TEST_SIGNAL_A) == ecs::SignalRef(third, "value_a"),
+                "Expected new entity ref");
+            AssertTrue(!cache.Get(lock, ecs::Entity(), TEST_SIGNAL_A), "Expected null entity to return an empty ref");
+        }
+    }
+
+    void TestSignalRefCachePrune() {
+        ecs::SignalRefCache cache;
+        std::vector<ecs::Entity> removed(1024);
+        {
+            auto lock = ecs::StartTransaction<ecs::AddRemove>();
+            for (size_t i = 0; i < removed.size(); i++) {
+                removed[i] = lock.NewEntity();
+                ecs::Name name("cache", "removed" + std::to_string(i));
+                ecs::EntityRef ref(name, removed[i]);
+                removed[i].Set<ecs::Name>(lock, name);
+                cache.Get(lock, removed[i], TEST_SIGNAL_A);
+            }
+            AssertEqual(cache.Size(), removed.size(), "Expected one cached ref per entity");
+        }
+        {
+            auto lock = ecs::StartTransaction<ecs::AddRemove>();
+            for (auto &ent : removed) {
+                ent.Destroy(lock);
+            }
+        }
+        {
+            auto lock = ecs::StartTransaction<ecs::AddRemove>();
+            auto live = lock.NewEntity();
+            ecs::EntityRef liveRef(ecs::Name("cache", "live"), live);
+            live.Set<ecs::Name>(lock, "cache", "live");
+            AssertTrue(cache.Get(lock, live, TEST_SIGNAL_A) == ecs::SignalRef(live, "value_a"), "Expected live ref");
+            AssertEqual(cache.Size(), 1u, "Expected refs for removed entities to be pruned");
+        }
+    }
+
+    Test test1(&TestSignalRefCache);
+    Test test2(&TestSignalRefCachePrune);
+} // namespace SignalRefCacheTests
@@ -0,0 +1,93 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "ecs/EcsImpl.hh"
+#include "ecs/SignalManager.hh"
+
+#include <tests.hh>
+#include <vector>
+
+namespace SignalStorageTests {
+    using namespace testing;
+
+    const size_t BINDING_COUNT = 600;
+
+    void AssertSubscribers(const ecs::Signals &signals,
+        const ecs::SignalRef &input,
+        const std::vector<ecs::SignalRef> &expected) {
+        auto subscribers = signals.subscribers.Get(input.GetIndex());
+        AssertEqual(subscribers.size(), expected.size(), "Wrong number of subscribers");
+        for (size_t i = 0; i < expected.size(); i++) {
+            ecs::SignalRef subscriber(subscribers[i].lock());
+            AssertTrue(subscriber == expected[i], "Expected subscribers in binding order: " + expected[i].String());
+            auto dependencies = signals.dependencies.Get(subscriber.GetIndex());
+            AssertEqual(dependencies.size(), 1u, "Expected subscriber to have a single dependency");
+            AssertTrue(input == ecs::SignalRef(dependencies[0].lock()), "Subscriber does not have dependency set");
+        }
+    }
+
+    void TestPackedEdges() {
+        ecs::Entity source;
+        ecs::SignalRef input;
+        std::vector<ecs::SignalRef> outputs;
+        {
+            auto lock = ecs::StartTransaction<ecs::AddRemove>();
+            source = lock.NewEntity();
+            ecs::EntityRef sourceRef(ecs::Name("storage", "source"), source);
+            source.Set<ecs::Name>(lock, "storage", "source");
+            input = ecs::SignalRef(source, "input");
+            input.SetValue(lock, 1.0);
+            for (size_t i = 0; i < BINDING_COUNT; i++) {
+                auto &output = outputs.emplace_back(source, "out" + std::to_string(i));
+                output.SetBinding(lock, "source/input + " + std::to_string(i), ecs::Name("storage", ""));
+            }
+        }
+        size_t edgeCount;
+        {
+            auto lock = ecs::StartTransaction<ecs::ReadSignalsLock>();
+            auto &signals = lock.Get<ecs::Signals>();
+            AssertSubscribers(signals, input, outputs);
+            AssertEqual(outputs[42].GetSignal(lock), 43.0, "Unexpected binding value");
+            edgeCount = signals.subscribers.edges.size();
+        }
+        {
+            Timer t("Rebind " + std::to_string(BINDING_COUNT) + " signals 20 times");
+            for (size_t round = 2; round < 22; round++) {
+                auto lock = ecs::StartTransaction<ecs::Write<ecs::Signals>, ecs::ReadSignalsLock>();
+                for (auto &output : outputs) {
+                    output.SetBinding(lock, "source/input * " + std::to_string(round), ecs::Name("storage", ""));
+                }
+            }
+        }
+        {
+            auto lock = ecs::StartTransaction<ecs::ReadSignalsLock>();
+            auto &signals = lock.Get<ecs::Signals>();
+            AssertSubscribers(signals, input, outputs);
+            AssertEqual(signals.subscribers.edges.size(), edgeCount, "Expected rebinding to reuse edge storage");
+            AssertEqual(outputs[42].GetSignal(lock), 21.0, "Unexpected binding value");
+        }
+        {
+            auto lock = ecs::StartTransaction<ecs::Write<ecs::Signals>>();
+            for (size_t i = 0; i < outputs.size(); i += 2) {
+                outputs[i].ClearBinding(lock);
+            }
+        }
+        {
+            auto lock = ecs::StartTransaction<ecs::ReadSignalsLock>();
+            auto &signals = lock.Get<ecs::Signals>();
+            std::vector<ecs::SignalRef> remaining;
+            for (size_t i = 1; i < outputs.size(); i += 2) {
+                remaining.emplace_back(outputs[i]);
+            }
+            AssertSubscribers(signals, input, remaining);
+            AssertEqual(signals.freeIndexes.size(), BINDING_COUNT / 2, "Expected cleared bindings to be freed");
+            AssertEqual(outputs[43].GetSignal(lock), 21.0, "Unexpected binding value");
+        }
+    }
+
+    Test test(&TestPackedEdges);
+} // namespace SignalStorageTests
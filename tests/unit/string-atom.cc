@@ -0,0 +1,99 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "strayphotons/StringAtom.hh"
+
+#include <atomic>
+#include <string>
+#include <tests.hh>
+#include <thread>
+#include <vector>
+
+namespace StringAtomTests {
+    using namespace testing;
+
+    const size_t THREAD_COUNT = 8;
+    const size_t STRING_COUNT = 20000;
+
+    void TestStringAtomInterning() {
+        {
+            Timer t("Test empty atoms");
+            sp::StringAtom empty;
+            AssertTrue(empty.empty(), "Default atom should be empty");
+            AssertEqual(empty, sp::StringAtom(""), "Empty string should intern to the empty atom");
+            AssertEqual(empty.View(), std::string_view(""), "Empty atom should have an empty string");
+            AssertTrue(sp::StringAtom::Find("").has_value(), "Empty string should always be found");
+        }
+        {
+            Timer t("Test interning equal strings");
+            sp::StringAtom a("string_atom_test");
+            std::string copy = "string_atom_test";
+            sp::StringAtom b(copy);
+            AssertEqual(a, b, "Equal strings should intern to the same atom");
+            AssertEqual(a.View(), std::string_view("string_atom_test"), "Atom string doesn't match");
+            AssertEqual(std::string(a.c_str()), copy, "Atom string should be null terminated");
+            AssertTrue(sp::StringAtom("string_atom_other") != a, "Different strings should have different atoms");
+
+            auto found = sp::StringAtom::Find("string_atom_test");
+            AssertTrue(found.has_value(), "Interned string should be found");
+            AssertEqual(*found, a, "Found atom doesn't match");
+            AssertTrue(!sp::StringAtom::Find("string_atom_never_interned"), "Unknown string shouldn't be found");
+        }
+        std::vector<std::string> strings;
+        for (size_t i = 0; i < STRING_COUNT; i++) {
+            strings.emplace_back("atom" + std::to_string(i));
+        }
+        std::vector<std::vector<sp::StringAtom>> atoms(THREAD_COUNT);
+        {
+            Timer t("Intern " + std::to_string(STRING_COUNT) + " strings from " + std::to_string(THREAD_COUNT) +
+                    " threads");
+            std::vector<std::thread> threads;
+            for (size_t i = 0; i < THREAD_COUNT; i++) {
+                threads.emplace_back([&, i] {
+                    atoms[i].reserve(STRING_COUNT);
+                    // Each thread inserts in a different order so new strings race with each other and table growth
+                    for (size_t j = 0; j < STRING_COUNT; j++) {
+                        atoms[i].emplace_back(strings[(j + i * STRING_COUNT / THREAD_COUNT) % STRING_COUNT]);
+                    }
+                });
+            }
+            for (auto &thread : threads) {
+                thread.join();
+            }
+        }
+        {
+            Timer t("Check interned atoms match across threads");
+            for (size_t i = 0; i < THREAD_COUNT; i++) {
+                for (size_t j = 0; j < STRING_COUNT; j++) {
+                    size_t index = (j + i * STRING_COUNT / THREAD_COUNT) % STRING_COUNT;
+                    AssertEqual(atoms[i][j], atoms[0][index], "Atoms don't match");
+                    AssertEqual(atoms[i][j].View(), std::string_view(strings[index]), "Atom string doesn't match");
+                }
+            }
+            AssertTrue(sp::StringAtom::InternedCount() >= STRING_COUNT, "Expected all strings to be interned");
+        }
+        {
+            Timer t("Look up " + std::to_string(STRING_COUNT) + " interned strings from " +
+                    std::to_string(THREAD_COUNT) + " threads");
+            std::vector<std::thread> threads;
+            std::atomic_size_t mismatches = 0;
+            for (size_t i = 0; i < THREAD_COUNT; i++) {
+                threads.emplace_back([&] {
+                    for (size_t j = 0; j < STRING_COUNT; j++) {
+                        if (sp::StringAtom(strings[j]) != atoms[0][j]) mismatches++;
+                    }
+                });
+            }
+            for (auto &thread : threads) {
+                thread.join();
+            }
+            AssertEqual(mismatches.load(), 0u, "Lookups returned different atoms");
+        }
+    }
+
+    Test test(&TestStringAtomInterning);
+} // namespace StringAtomTests
@@ -0,0 +1,49 @@
+/*
+ * Stray Photons - Copyright (C) 2023 Jacob Wirth & Justin Li
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "strayphotons/ThreadAffinity.hh"
+
+#include <tests.hh>
+
+namespace ThreadAffinityTests {
+    using namespace testing;
+
+    void TestThreadAffinityPolicyParsing() {
+        auto policy = sp::ThreadAffinityPolicy::Parse("AudioManager=3,GameLogic=1+2,reserve=3,workers=0-2");
+        AssertTrue(policy != nullptr, "Expected valid affinity policy");
+
+        auto audioCores = policy->GetThreadCores("AudioManager");
+        AssertEqual(audioCores.size(), 1u, "Expected AudioManager to be pinned to 1 core");
+        AssertEqual(audioCores[0], 3u, "Expected AudioManager to be pinned to core 3");
+
+        auto logicCores = policy->GetThreadCores("GameLogic");
+        AssertEqual(logicCores.size(), 2u, "Expected GameLogic to be pinned to 2 cores");
+        AssertEqual(logicCores[0], 1u, "Expected GameLogic to be pinned to core 1");
+        AssertEqual(logicCores[1], 2u, "Expected GameLogic to be pinned to core 2");
+
+        auto workerCores = policy->GetWorkerCores();
+        AssertEqual(workerCores.size(), 3u, "Expected workers to use 3 cores");
+        for (auto core : workerCores) {
+            AssertTrue(core != 3, "Workers should not run on reserved cores");
+        }
+
+        for (auto core : policy->GetThreadCores("PhysX")) {
+            AssertTrue(core != 3, "Unpinned threads should not run on reserved cores");
+        }
+
+        auto unrestricted = sp::ThreadAffinityPolicy::Parse("GameLogic=0");
+        AssertTrue(unrestricted != nullptr, "Expected valid affinity policy");
+        AssertTrue(unrestricted->GetThreadCores("PhysX").empty(), "Expected unpinned thread to run on any core");
+        AssertTrue(unrestricted->GetWorkerCores().empty(), "Expected workers to run on any core");
+
+        AssertTrue(sp::ThreadAffinityPolicy::Parse("GameLogic") == nullptr, "Expected missing core list to fail");
+        AssertTrue(sp::ThreadAffinityPolicy::Parse("GameLogic=3-1") == nullptr, "Expected invalid range to fail");
+        AssertTrue(sp::ThreadAffinityPolicy::Parse("GameLogic=a") == nullptr, "Expected invalid core to fail");
+    }
+
+    Test test(&TestThreadAffinityPolicyParsing);
+} // namespace ThreadAffinityTests